@@ -27,6 +27,15 @@ def main(argv=None):
     p_run.add_argument("--config", required=True, help="Config file name")
     p_run.add_argument("--port", type=int, default=None, help="Host SMB port")
 
+    # reload
+    p_reload = sub.add_parser(
+        "reload", help="Reload fault rules of the running container (no remount)"
+    )
+    p_reload.add_argument(
+        "--config", default=None,
+        help="Config file name to switch to (default: reload the current one)",
+    )
+
     # stop
     sub.add_parser("stop", help="Stop running container")
 
@@ -38,6 +47,10 @@ def main(argv=None):
         help="Preserve containers on failure for debugging",
     )
     p_test.add_argument("--verbose", "-v", action="store_true", help="Verbose output")
+    p_test.add_argument(
+        "--fresh", action="store_true",
+        help="Start a new target container per scenario instead of reloading",
+    )
 
     # clean
     p_clean = sub.add_parser("clean", help="Remove containers, volumes, networks")
@@ -78,6 +91,11 @@ def main(argv=None):
         run_container(cfg, args.config, args.port)
         return 0
 
+    elif args.command == "reload":
+        from nas_sim.run import reload_container
+
+        return 0 if reload_container(args.config) else 1
+
     elif args.command == "stop":
         from nas_sim.run import stop_container
 
@@ -96,7 +114,7 @@ def main(argv=None):
         if not build_image(cfg, test_image=True):
             return 1
 
-        return run_tests(cfg, args.filter, args.preserve, args.verbose)
+        return run_tests(cfg, args.filter, args.preserve, args.verbose, args.fresh)
 
     elif args.command == "clean":
         from nas_sim.docker_utils import (
@@ -105,14 +123,14 @@ def main(argv=None):
             remove_network,
             remove_volume,
         )
-        from nas_sim.test import SCENARIOS, NETWORK_NAME
+        from nas_sim.test import SCENARIOS, NETWORK_NAME, TARGET_NAME, VOLUME_NAME
 
         console.info("Cleaning up containers, volumes, and networks...")
         remove_container("nas-fault-simulator")
+        remove_container(TARGET_NAME)
+        remove_volume(VOLUME_NAME)
         for s in SCENARIOS:
-            remove_container(f"nas-sim-target-{s.name}")
             remove_container(f"nas-sim-runner-{s.name}")
-            remove_volume(f"nas-sim-storage-{s.name}")
         remove_network(NETWORK_NAME)
 
         if args.all:
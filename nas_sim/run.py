@@ -2,6 +2,7 @@
 
 from __future__ import annotations
 
+import subprocess
 import sys
 
 from nas_sim import console
@@ -77,6 +78,9 @@ def run_container(cfg: Config, config_file: str, port: int | None = None) -> Non
         f"@localhost:{smb_port}/{cfg.smb_share}"
     )
     console.info("")
+    console.info("To switch fault rules without restarting:")
+    console.info("  python -m nas_sim reload --config <file>")
+    console.info("")
     console.info("To stop:")
     console.info("  python -m nas_sim stop")
     console.info("")
@@ -88,3 +92,16 @@ def stop_container() -> None:
     """Stop the user-facing container."""
     remove_container("nas-fault-simulator")
     console.success("Container stopped")
+
+
+def reload_container(config_file: str | None = None) -> bool:
+    """Reload the fault rules of the user-facing container without remounting."""
+    args = ["docker", "exec", "nas-fault-simulator", "nas-emu-reload"]
+    if config_file:
+        args.append(config_file)
+    result = subprocess.run(args, capture_output=True, text=True, timeout=60)
+    if result.returncode != 0:
+        console.error(result.stderr.strip() or "Reload failed")
+        return False
+    console.success(result.stdout.strip())
+    return True
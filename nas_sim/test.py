@@ -2,6 +2,7 @@
 
 from __future__ import annotations
 
+import subprocess
 import sys
 import time
 from dataclasses import dataclass
@@ -21,6 +22,8 @@ from nas_sim.containers import start_target, start_test_runner, wait_for_smb
 
 
 NETWORK_NAME = "nas-sim-test"
+TARGET_NAME = "nas-sim-target"
+VOLUME_NAME = "nas-sim-storage"
 
 
 @dataclass
@@ -30,6 +33,7 @@ class TestScenario:
     pytest_args: str
     group: str
     exec_inside: str = ""  # If set, run this script inside target via exec
+    reloadable: bool = True  # Config differs only in fault rules: reuse the target
 
 
 # All test scenarios matching the original run_tests.sh flow
@@ -127,7 +131,11 @@ SCENARIOS: List[TestScenario] = [
         "timing_1min_write", "timing_1min_write.conf",
         "tests/test_timing.py -k timing_1min_write", "timing",
     ),
-    # Group 8: event emission tests (run inside target container)
+    # Group 8: path-scoped rules
+    TestScenario(
+        "path_scoped", "path_scoped.conf", "tests/test_path_scope.py", "path",
+    ),
+    # Group 9: event emission tests (run inside target container)
     TestScenario(
         "event_emission_nofault", "no_faults.conf", "", "event",
         exec_inside="src/fuse-driver/tests/test_event_emission.py",
@@ -136,6 +144,21 @@ SCENARIOS: List[TestScenario] = [
         "event_emission_corruption", "corruption_high.conf", "", "event",
         exec_inside="src/fuse-driver/tests/test_event_emission.py",
     ),
+    TestScenario(
+        "event_emission_binary", "event_binary.conf", "", "event",
+        exec_inside="src/fuse-driver/tests/test_event_emission.py",
+        reloadable=False,  # Event format and ring are set at mount
+    ),
+    TestScenario(
+        "event_emission_shm", "event_shm.conf", "", "event",
+        exec_inside="src/fuse-driver/tests/test_event_emission.py",
+        reloadable=False,  # Event format and ring are set at mount
+    ),
+    # Group 10: hot reload tests (run inside target container)
+    TestScenario(
+        "hot_reload", "reload_a.conf", "", "reload",
+        exec_inside="src/fuse-driver/tests/test_hot_reload.py",
+    ),
 ]
 
 
@@ -145,37 +168,106 @@ def _filter_scenarios(pattern: Optional[str]) -> List[TestScenario]:
     return [s for s in SCENARIOS if pattern in s.name or pattern in s.group]
 
 
-def _run_exec_scenario(cfg: Config, scenario: TestScenario, verbose: bool) -> bool:
-    """Run a test script inside the target container via exec."""
-    vol_name = f"nas-sim-storage-{scenario.name}"
-    target_name = f"nas-sim-target-{scenario.name}"
+def _docker_exec(container: str, args: List[str], timeout: int = 60):
+    """Run a command in a container via the docker CLI.
 
-    console.header(f"Test: {scenario.name}")
-    console.info(f"Config: {scenario.config_file}")
-    console.info(f"Script: {scenario.exec_inside}")
+    (Docker SDK exec_run/exec_start can hang on some configurations)
+    """
+    return subprocess.run(
+        ["docker", "exec", container] + args,
+        capture_output=True, text=True, timeout=timeout,
+    )
 
-    start = time.time()
 
-    try:
-        remove_volume(vol_name)
-        ensure_volume(vol_name)
+class _Target:
+    """Target container shared by consecutive scenarios.
+
+    A scenario whose config only changes fault rules reuses the running
+    target: the storage is emptied and the driver reloads its fault rules
+    (nas-emu-reload, which sends SIGHUP) instead of being remounted.
+    Scenarios that change mount-time settings get a fresh target, and so
+    does every scenario after a failed one.
+    """
+
+    def __init__(self, cfg: Config, reuse: bool = True):
+        self.cfg = cfg
+        self.reuse = reuse
+        self.running = False
+        self.reloadable = False
+
+    def prepare(self, scenario: TestScenario) -> bool:
+        """Bring up a target running the scenario's config."""
+        if self.reuse and self.running and self.reloadable and scenario.reloadable:
+            if self._reload(scenario.config_file):
+                return True
+            console.warn("Reload failed, starting a new target container")
+        return self._start(scenario)
+
+    def _start(self, scenario: TestScenario) -> bool:
+        self.stop()
+        ensure_volume(VOLUME_NAME)
 
         console.step(1, "Starting target container")
         if not start_target(
-            cfg, scenario.config_file, target_name, NETWORK_NAME, vol_name
+            self.cfg, scenario.config_file, TARGET_NAME, NETWORK_NAME, VOLUME_NAME
         ):
             return False
+        self.running = True
+        self.reloadable = scenario.reloadable
 
-        console.step(2, "Waiting for FUSE readiness")
-        if not wait_for_smb(target_name, cfg, timeout=30):
+        console.step(2, "Waiting for SMB readiness")
+        if not wait_for_smb(TARGET_NAME, self.cfg, timeout=30):
             console.error("SMB service did not become ready within 30s")
             return False
-        console.success("FUSE+SMB ready")
+        console.success("SMB ready")
+        return True
+
+    def _reload(self, config_file: str) -> bool:
+        # Files left by the previous scenario are removed under the driver;
+        # the reload then drops what the kernel still caches about them
+        console.step(1, "Clearing storage of the running target")
+        result = _docker_exec(
+            TARGET_NAME,
+            ["sh", "-c", 'find "$NAS_STORAGE_PATH" -mindepth 1 -delete'],
+        )
+        if result.returncode != 0:
+            console.error(f"Clearing storage failed: {result.stderr.strip()}")
+            return False
+
+        console.step(2, "Reloading fault rules")
+        result = _docker_exec(TARGET_NAME, ["nas-emu-reload", config_file])
+        if result.returncode != 0:
+            console.error(f"nas-emu-reload failed: {result.stderr.strip()}")
+            return False
+        console.success("Fault rules reloaded")
+        return True
+
+    def stop(self) -> None:
+        remove_container(TARGET_NAME)
+        remove_volume(VOLUME_NAME)
+        self.running = False
+        self.reloadable = False
 
+
+def _run_exec_scenario(
+    cfg: Config, target: _Target, scenario: TestScenario, verbose: bool
+) -> bool:
+    """Run a test script inside the target container via exec."""
+    console.header(f"Test: {scenario.name}")
+    console.info(f"Config: {scenario.config_file}")
+    console.info(f"Script: {scenario.exec_inside}")
+
+    start = time.time()
+
+    if not target.prepare(scenario):
+        target.stop()
+        return False
+
+    try:
         # Copy test script into container and exec it
         console.step(3, "Running tests inside container")
         client = get_client()
-        ctr = client.containers.get(target_name)
+        ctr = client.containers.get(TARGET_NAME)
 
         # Read the test script from host
         import os
@@ -196,13 +288,8 @@ def _run_exec_scenario(cfg: Config, scenario: TestScenario, verbose: bool) -> bo
         tar_stream.seek(0)
         ctr.put_archive("/tmp", tar_stream)
 
-        # Execute the test script via subprocess docker exec
-        # (Docker SDK exec_run/exec_start can hang on some configurations)
-        import subprocess
-        result = subprocess.run(
-            ["docker", "exec", ctr.id, "python3", "-u", "/tmp/test_script.py"],
-            capture_output=True, text=True, timeout=60,
-        )
+        # Execute the test script via docker exec
+        result = _docker_exec(ctr.id, ["python3", "-u", "/tmp/test_script.py"])
         if result.stdout:
             for line in result.stdout.splitlines():
                 print(f"  {line}")
@@ -217,20 +304,24 @@ def _run_exec_scenario(cfg: Config, scenario: TestScenario, verbose: bool) -> bo
             return True
         else:
             console.error(f"{scenario.name} FAILED (exit {exit_code}, {elapsed:.0f}s)")
+            # The failure may have left the target wedged: the next
+            # scenario gets a fresh one
+            target.stop()
             return False
 
-    finally:
-        remove_container(target_name)
-        remove_volume(vol_name)
+    except Exception as exc:
+        console.error(f"{scenario.name} FAILED: {exc}")
+        target.stop()
+        return False
 
 
-def _run_scenario(cfg: Config, scenario: TestScenario, verbose: bool) -> bool:
+def _run_scenario(
+    cfg: Config, target: _Target, scenario: TestScenario, verbose: bool
+) -> bool:
     """Run a single test scenario. Returns True on success."""
     if scenario.exec_inside:
-        return _run_exec_scenario(cfg, scenario, verbose)
+        return _run_exec_scenario(cfg, target, scenario, verbose)
 
-    vol_name = f"nas-sim-storage-{scenario.name}"
-    target_name = f"nas-sim-target-{scenario.name}"
     runner_name = f"nas-sim-runner-{scenario.name}"
 
     console.header(f"Test: {scenario.name}")
@@ -239,31 +330,17 @@ def _run_scenario(cfg: Config, scenario: TestScenario, verbose: bool) -> bool:
 
     start = time.time()
 
-    try:
-        # Create fresh volume
-        remove_volume(vol_name)
-        ensure_volume(vol_name)
-
-        # Start target container
-        console.step(1, "Starting target container")
-        if not start_target(
-            cfg, scenario.config_file, target_name, NETWORK_NAME, vol_name
-        ):
-            return False
-
-        # Wait for SMB readiness
-        console.step(2, "Waiting for SMB readiness")
-        if not wait_for_smb(target_name, cfg, timeout=30):
-            console.error("SMB service did not become ready within 30s")
-            return False
-        console.success("SMB ready")
+    if not target.prepare(scenario):
+        target.stop()
+        return False
 
+    try:
         # Start test runner
         console.step(3, "Running tests")
         verbose_flag = "-s" if verbose else ""
         pytest_args = f"{scenario.pytest_args} {verbose_flag}".strip()
         exit_code = start_test_runner(
-            cfg, runner_name, NETWORK_NAME, vol_name,
+            cfg, runner_name, NETWORK_NAME, VOLUME_NAME,
             scenario.config_file, pytest_args,
         )
 
@@ -273,12 +350,13 @@ def _run_scenario(cfg: Config, scenario: TestScenario, verbose: bool) -> bool:
             return True
         else:
             console.error(f"{scenario.name} FAILED (exit {exit_code}, {elapsed:.0f}s)")
+            # The failure may have left the target wedged: the next
+            # scenario gets a fresh one
+            target.stop()
             return False
 
     finally:
         remove_container(runner_name)
-        remove_container(target_name)
-        remove_volume(vol_name)
 
 
 def run_tests(
@@ -286,6 +364,7 @@ def run_tests(
     filter_pattern: Optional[str] = None,
     preserve: bool = False,
     verbose: bool = False,
+    fresh: bool = False,
 ) -> int:
     """Run all (or filtered) test scenarios. Returns process exit code."""
     scenarios = _filter_scenarios(filter_pattern)
@@ -300,12 +379,16 @@ def run_tests(
     ensure_network(NETWORK_NAME)
 
     results = {}
-    for scenario in scenarios:
-        ok = _run_scenario(cfg, scenario, verbose)
-        results[scenario.name] = ok
-        if not ok and not preserve:
-            # Continue running remaining tests (matching original behavior)
-            pass
+    target = _Target(cfg, reuse=not fresh)
+    try:
+        for scenario in scenarios:
+            ok = _run_scenario(cfg, target, scenario, verbose)
+            results[scenario.name] = ok
+            if not ok and not preserve:
+                # Continue running remaining tests (matching original behavior)
+                pass
+    finally:
+        target.stop()
 
     # Summary
     console.header("Test Results Summary")
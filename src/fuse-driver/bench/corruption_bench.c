@@ -0,0 +1,101 @@
+// Corruption kernel benchmark.
+//
+// Compares the original per-byte loop (rand() % size position, rand() % 256
+// value, positions may repeat) with corruption_apply() across buffer sizes
+// and corruption percentages. Reports time per call and the share of bytes
+// that actually changed. Kernel times include recording the full ground
+// truth (ranges and XOR masks), as the write path does.
+//
+// Build and run: make bench && ./bench/corruption_bench
+
+#include "corruption.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The loop fault_injector.c used before the kernel existed (it recorded at
+// most 256 positions; the kernel below records every corrupted byte)
+static void legacy_corrupt(unsigned char *buffer, size_t size, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        size_t pos = rand() % size;
+        buffer[pos] = rand() % 256;
+    }
+}
+
+static size_t count_changed(const unsigned char *a, const unsigned char *b, size_t size) {
+    size_t changed = 0;
+    for (size_t i = 0; i < size; i++) {
+        changed += a[i] != b[i];
+    }
+    return changed;
+}
+
+int main(void) {
+    static const size_t sizes[] = { 4096, 128 * 1024, 1024 * 1024 };
+    static const double percentages[] = { 0.1, 1.0, 10.0, 50.0, 90.0, 100.0 };
+    static corruption_detail_t detail;
+
+    srand(1);
+    rng_init(1);
+
+    printf("%-9s %7s %14s %14s %9s %12s %12s\n",
+           "size", "pct", "legacy us/op", "kernel us/op", "speedup", "legacy hit%", "kernel hit%");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t size = sizes[s];
+        unsigned char *original = malloc(size);
+        unsigned char *work = malloc(size);
+        for (size_t i = 0; i < size; i++) {
+            original[i] = (unsigned char)rand();
+        }
+
+        for (size_t p = 0; p < sizeof(percentages) / sizeof(percentages[0]); p++) {
+            size_t count = (size_t)(size * percentages[p] / 100.0);
+            if (count == 0) {
+                count = 1;
+            }
+            int iterations = (int)(64 * 1024 * 1024 / size / (percentages[p] < 10.0 ? 1 : 10));
+            if (iterations < 5) {
+                iterations = 5;
+            }
+
+            double legacy_time = 0, kernel_time = 0;
+            size_t legacy_changed = 0, kernel_changed = 0;
+
+            for (int it = 0; it < iterations; it++) {
+                memcpy(work, original, size);
+                double t0 = now_sec();
+                legacy_corrupt(work, size, count);
+                legacy_time += now_sec() - t0;
+                legacy_changed += count_changed(original, work, size);
+
+                memcpy(work, original, size);
+                t0 = now_sec();
+                corruption_apply(work, size, count, &detail);
+                kernel_time += now_sec() - t0;
+                kernel_changed += count_changed(original, work, size);
+            }
+
+            double expected = (double)count * iterations;
+            printf("%-9zu %6.1f%% %14.2f %14.2f %8.1fx %11.2f%% %11.2f%%\n",
+                   size, percentages[p],
+                   legacy_time / iterations * 1e6,
+                   kernel_time / iterations * 1e6,
+                   legacy_time / kernel_time,
+                   100.0 * legacy_changed / expected,
+                   100.0 * kernel_changed / expected);
+        }
+
+        free(original);
+        free(work);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#!/bin/bash
+# [fuse] tuning benchmark.
+#
+# Mounts a scratch instance of the driver (no fault rules) once per
+# [fuse] variant and runs fio sequential write and read over it, so the
+# effect of max_write, writeback_cache and direct_io can be compared. The
+# container's own mount is not touched.
+#
+# Run inside the container: bench/fuse_tuning_fio.sh [size]   (default 1G)
+
+set -e
+
+DRIVER=${DRIVER:-/usr/local/bin/nas-emu-fuse}
+SIZE=${1:-1G}
+WORK=$(mktemp -d /tmp/fuse-tuning.XXXXXX)
+MNT="$WORK/mnt"
+STORE="$WORK/store"
+
+if ! command -v fio >/dev/null 2>&1; then
+    echo "fio not found (apt-get install fio)" >&2
+    exit 1
+fi
+
+mkdir -p "$MNT" "$STORE"
+trap 'fusermount3 -u "$MNT" 2>/dev/null || true; rm -rf "$WORK"' EXIT
+
+# name|[fuse] keys (';'-separated)
+VARIANTS=(
+    "default|"
+    "max_write=1M|max_write = 1048576"
+    "writeback|writeback_cache = true"
+    "writeback+max_write=1M|writeback_cache = true;max_write = 1048576;max_background = 64;congestion_threshold = 48"
+    "direct_io|direct_io = true"
+    "direct_io+max=1M|direct_io = true;max_write = 1048576;max_read = 1048576"
+)
+
+# MB/s of one fio job
+run_fio() {
+    local rw=$1
+    fio --name=seq --directory="$MNT" --rw="$rw" --bs=1M --size="$SIZE" \
+        --ioengine=psync --end_fsync=1 --output-format=terse --terse-version=3 \
+        | awk -F';' -v rw="$rw" '{ kb = (rw == "write") ? $48 : $7; printf "%.1f", kb / 1024 }'
+}
+
+printf "%-28s %12s %12s\n" "variant" "write MB/s" "read MB/s"
+for variant in "${VARIANTS[@]}"; do
+    name=${variant%%|*}
+    keys=${variant#*|}
+
+    conf="$WORK/$name.conf"
+    {
+        echo "enable_fault_injection = false"
+        echo "[fuse]"
+        [ -n "$keys" ] && echo "$keys" | tr ';' '\n'
+    } > "$conf"
+
+    "$DRIVER" "$MNT" --storage="$STORE" --log="$WORK/$name.log" --config="$conf"
+    for _ in $(seq 50); do
+        mountpoint -q "$MNT" && break
+        sleep 0.1
+    done
+
+    write=$(run_fio write)
+    sync; echo 3 > /proc/sys/vm/drop_caches 2>/dev/null || true
+    read=$(run_fio read)
+    printf "%-28s %12s %12s\n" "$name" "$write" "$read"
+
+    rm -f "$MNT"/seq.*
+    fusermount3 -u "$MNT"
+done
@@ -42,13 +42,19 @@ else
     echo "Using default config: $FUSE_CONFIG"
 fi
 
+# The driver reads a copy of the config, so nas-emu-reload can switch it to
+# another one (and SIGHUP reloads its fault rules) without remounting
+cp "$FUSE_CONFIG" /var/run/nas-emu/active.conf
+echo "$FUSE_CONFIG" > /var/run/nas-emu/active.source
+
 # Start FUSE driver
 echo "Starting FUSE driver with config: $FUSE_CONFIG"
 /usr/local/bin/nas-emu-fuse "$NAS_MOUNT_POINT" \
     --storage="$NAS_STORAGE_PATH" \
     --log="$NAS_LOG_FILE" \
     --loglevel="$NAS_LOG_LEVEL" \
-    --config="$FUSE_CONFIG" &
+    --config=/var/run/nas-emu/active.conf \
+    --reload-status=/var/run/nas-emu/reload.status &
 
 # Wait a moment for FUSE to initialize
 sleep 2
@@ -0,0 +1,125 @@
+#include "buf_pool.h"
+#include "log.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+// Number of size classes (4 KiB << 0 ... 4 KiB << 11 = 8 MiB)
+#define BUF_POOL_CLASSES 12
+
+// Size from which huge pages are worth trying
+#define BUF_POOL_HUGEPAGE_SIZE (2UL * 1024 * 1024)
+
+// Buffers cached by one thread, one slot per size class
+typedef struct {
+    void *slots[BUF_POOL_CLASSES];
+} buf_pool_cache_t;
+
+static atomic_bool hugepages_enabled = false;
+
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+static __thread buf_pool_cache_t tls_cache;
+static __thread bool tls_registered = false;
+
+// Size class index for a request (-1 if larger than the biggest class)
+static int size_class(size_t size) {
+    size_t class_size = BUF_POOL_MIN_SIZE;
+    for (int i = 0; i < BUF_POOL_CLASSES; i++) {
+        if (size <= class_size) {
+            return i;
+        }
+        class_size <<= 1;
+    }
+    return -1;
+}
+
+static size_t class_size(int index) {
+    return BUF_POOL_MIN_SIZE << index;
+}
+
+// Map a buffer, trying huge pages first for large classes
+static void *map_buffer(size_t size) {
+    void *buffer;
+
+#ifdef MAP_HUGETLB
+    if (size >= BUF_POOL_HUGEPAGE_SIZE && atomic_load_explicit(&hugepages_enabled, memory_order_relaxed)) {
+        buffer = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (buffer != MAP_FAILED) {
+            return buffer;
+        }
+        LOG_DEBUG("Buffer pool: huge page mapping of %zu bytes failed, using regular pages", size);
+    }
+#endif
+
+    buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        LOG_ERROR("Buffer pool: failed to map %zu bytes", size);
+        return NULL;
+    }
+    return buffer;
+}
+
+// Release a thread's cached buffers when the thread exits
+static void cache_release(void *arg) {
+    buf_pool_cache_t *cache = arg;
+    for (int i = 0; i < BUF_POOL_CLASSES; i++) {
+        if (cache->slots[i]) {
+            munmap(cache->slots[i], class_size(i));
+            cache->slots[i] = NULL;
+        }
+    }
+}
+
+static void cache_key_create(void) {
+    pthread_key_create(&cache_key, cache_release);
+}
+
+// Initialize the pool
+void buf_pool_init(bool use_hugepages) {
+    pthread_once(&cache_key_once, cache_key_create);
+    atomic_store(&hugepages_enabled, use_hugepages);
+    LOG_INFO("Buffer pool initialized (huge pages: %s)", use_hugepages ? "enabled" : "disabled");
+}
+
+// Get a scratch buffer of at least size bytes
+void *buf_pool_get(size_t size) {
+    int index = size_class(size);
+    if (index < 0) {
+        return map_buffer(size);
+    }
+
+    void *buffer = tls_cache.slots[index];
+    if (buffer) {
+        tls_cache.slots[index] = NULL;
+        return buffer;
+    }
+    return map_buffer(class_size(index));
+}
+
+// Return a buffer to the calling thread's cache
+void buf_pool_put(void *buffer, size_t size) {
+    if (!buffer) {
+        return;
+    }
+
+    int index = size_class(size);
+    if (index < 0) {
+        munmap(buffer, size);
+        return;
+    }
+
+    if (tls_cache.slots[index]) {
+        munmap(buffer, class_size(index));
+        return;
+    }
+
+    if (!tls_registered) {
+        pthread_once(&cache_key_once, cache_key_create);
+        pthread_setspecific(cache_key, &tls_cache);
+        tls_registered = true;
+    }
+    tls_cache.slots[index] = buffer;
+}
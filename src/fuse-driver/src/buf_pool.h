@@ -0,0 +1,28 @@
+#ifndef BUF_POOL_H
+#define BUF_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Per-thread scratch buffer pool.
+//
+// Buffers come in power-of-two size classes from 4 KiB to 8 MiB. Each thread
+// caches one buffer per class, so a worker that keeps handling writes of a
+// similar size reuses the same mapping without locking or calling malloc.
+// Larger requests fall back to a one-off mapping. Cached buffers are released
+// when their thread exits.
+
+// Smallest and largest pooled size class
+#define BUF_POOL_MIN_SIZE  (4UL * 1024)
+#define BUF_POOL_MAX_SIZE  (8UL * 1024 * 1024)
+
+// Initialize the pool (use_hugepages = back classes >= 2 MiB with huge pages)
+void buf_pool_init(bool use_hugepages);
+
+// Get a scratch buffer of at least size bytes (NULL on failure)
+void *buf_pool_get(size_t size);
+
+// Return a buffer obtained from buf_pool_get() with the same size
+void buf_pool_put(void *buffer, size_t size);
+
+#endif // BUF_POOL_H
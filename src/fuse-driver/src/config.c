@@ -4,10 +4,44 @@
 #include <ctype.h>
 #include <errno.h>
 #include "config.h"
+#include "event_ring.h"
 
 // Global configuration instance
 static fs_config_t global_config;
 
+// Append a rule to the end of a fault rule list
+#define CONFIG_LIST_APPEND(type, head, item) do { \
+        type **tail_ = &(head);                  \
+        while (*tail_) {                         \
+            tail_ = &(*tail_)->next;             \
+        }                                        \
+        *tail_ = (item);                         \
+    } while (0)
+
+// Free every rule in a fault rule list
+#define CONFIG_LIST_FREE(type, head) do {        \
+        type *item_ = (head);                    \
+        while (item_) {                          \
+            type *next_ = item_->next;           \
+            free(item_->path);                   \
+            free(item_);                         \
+            item_ = next_;                       \
+        }                                        \
+        (head) = NULL;                           \
+    } while (0)
+
+// Parse one [management] event limit key (class prefix already stripped)
+static void config_parse_event_limit(event_limit_t *limit, const char *key, const char *v) {
+    double value = atof(v);
+    if (strcmp(key, "sample_rate") == 0) {
+        limit->sample_rate = value < 0.0 ? 0.0 : (value > 1.0 ? 1.0 : value);
+    } else if (strcmp(key, "rate_limit") == 0) {
+        limit->rate_limit = value > 0.0 ? value : 0.0;
+    } else if (strcmp(key, "rate_burst") == 0) {
+        limit->rate_burst = value > 0.0 ? value : 0.0;
+    }
+}
+
 // This function has been replaced by config_parse_operations_mask
 
 // Helper function to check if an operation should be affected by a fault
@@ -17,9 +51,9 @@ bool config_should_affect_operation(uint32_t operations_mask, fs_op_type_t opera
         return false;
     }
     
-    // If all bits set to 1, affect all operations
+    // If all bits set to 1, affect all operations but the named-only ones
     if (operations_mask == 0xFFFFFFFF) {
-        return true;
+        return (CONFIG_OPS_NAMED_ONLY & (1u << operation)) == 0;
     }
     
     // Check if the bit for this operation is set in the mask
@@ -54,6 +88,11 @@ uint32_t config_parse_operations_mask(const char *operations_str) {
             end--;
         }
         
+        // "all" in a list ("all,fsync") adds every operation "all" covers
+        if (strcmp(token, "all") == 0 || strcmp(token, "*") == 0) {
+            mask |= ((1u << FS_OP_COUNT) - 1) & ~CONFIG_OPS_NAMED_ONLY;
+        }
+
         // Find matching operation and set its bit
         for (int i = 0; i < FS_OP_COUNT; i++) {
             if (strcmp(token, fs_op_names[i]) == 0) {
@@ -86,13 +125,35 @@ void config_init(fs_config_t *config) {
     config->storage_path = strdup(env_storage_path ? env_storage_path : "/var/nas-storage");
     config->log_file = strdup(env_log_file ? env_log_file : "/var/log/nas-emu.log");
     config->log_level = env_log_level ? atoi(env_log_level) : 2;
+    config->log_binary = false;
     config->enable_fault_injection = false;
+    config->random_seed = 0;
+    config->hugepage_buffers = false;
     config->config_file = NULL;
 
     // Event emission defaults
     config->event_emission_enabled = true;
     config->event_socket_path = strdup("/var/run/nas-emu/events.sock");
     config->emit_metadata_ops = false;
+    config->event_binary = false;
+    config->event_shm_path = NULL;
+    config->event_shm_size = EVENT_RING_DEFAULT_SIZE;
+    for (int i = 0; i < EVENT_CLASS_COUNT; i++) {
+        config->event_limits[i].sample_rate = 1.0;
+        config->event_limits[i].rate_limit = 0.0;
+        config->event_limits[i].rate_burst = 0.0;
+    }
+
+    // Kernel cache defaults (what libfuse's high-level API used)
+    config->attr_timeout = 1.0;
+    config->entry_timeout = 1.0;
+    config->negative_timeout = 0.0;
+    config->max_write = 0;
+    config->max_read = 0;
+    config->max_background = 0;
+    config->congestion_threshold = 0;
+    config->writeback_cache = false;
+    config->direct_io = false;
 
     // Initialize all fault pointers to NULL (disabled)
     config->error_fault = NULL;
@@ -111,17 +172,32 @@ bool config_load_from_file(fs_config_t *config, const char *filename) {
         return false;
     }
     
-    // Store config file path
+    // Store config file path (absolute, so a reload still finds it after the
+    // driver has daemonized and changed to /)
     if (config->config_file) {
         free(config->config_file);
     }
-    config->config_file = strdup(filename);
+    config->config_file = realpath(filename, NULL);
+    if (!config->config_file) {
+        config->config_file = strdup(filename);
+    }
     
     // Section tracking for nested configurations
     char current_section[128] = "";
     
-    char line[256];
-    while (fgets(line, sizeof(line), file)) {
+    // Rule currently being parsed (the one added by the last section header)
+    fault_error_t *cur_error = NULL;
+    fault_corruption_t *cur_corruption = NULL;
+    fault_delay_t *cur_delay = NULL;
+    fault_timing_t *cur_timing = NULL;
+    fault_operation_count_t *cur_operation_count = NULL;
+    fault_partial_t *cur_partial = NULL;
+    
+    // Lines are read whole, however long: a fixed buffer would cut a long
+    // value (a path pattern, say) and parse the rest as a line of its own
+    char *line = NULL;
+    size_t line_capacity = 0;
+    while (getline(&line, &line_capacity, file) != -1) {
         // Strip trailing \r\n (handles both Unix LF and Windows CRLF)
         size_t len = strlen(line);
         while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
@@ -137,64 +213,78 @@ bool config_load_from_file(fs_config_t *config, const char *filename) {
         if (line[0] == '[' && strchr(line, ']')) {
             sscanf(line, "[%127[^]]", current_section);
             
-            // Initialize fault structures for each section
-            if (strcmp(current_section, "error_fault") == 0 && !config->error_fault) {
-                config->error_fault = calloc(1, sizeof(fault_error_t));
-                if (config->error_fault) {
-                    config->error_fault->probability = 0.5;  // Default values
-                    config->error_fault->error_code = -EIO;
-                    config->error_fault->operations_mask = 0xFFFFFFFF;  // Default: all operations
+            // Each fault section adds a new rule with default values,
+            // appended to the list for its fault type
+            cur_error = NULL;
+            cur_corruption = NULL;
+            cur_delay = NULL;
+            cur_timing = NULL;
+            cur_operation_count = NULL;
+            cur_partial = NULL;
+            
+            if (strcmp(current_section, "error_fault") == 0) {
+                cur_error = calloc(1, sizeof(fault_error_t));
+                if (cur_error) {
+                    cur_error->probability = 0.5;  // Default values
+                    cur_error->error_code = -EIO;
+                    cur_error->operations_mask = 0xFFFFFFFF;  // Default: all operations
+                    CONFIG_LIST_APPEND(fault_error_t, config->error_fault, cur_error);
                 }
-            } else if (strcmp(current_section, "corruption_fault") == 0 && !config->corruption_fault) {
-                config->corruption_fault = calloc(1, sizeof(fault_corruption_t));
-                if (config->corruption_fault) {
-                    config->corruption_fault->probability = 0.5;
-                    config->corruption_fault->percentage = 10.0;
-                    config->corruption_fault->operations_mask = (1 << FS_OP_WRITE);  // Default: write only (safer)
+            } else if (strcmp(current_section, "corruption_fault") == 0) {
+                cur_corruption = calloc(1, sizeof(fault_corruption_t));
+                if (cur_corruption) {
+                    cur_corruption->probability = 0.5;
+                    cur_corruption->percentage = 10.0;
+                    cur_corruption->operations_mask = (1 << FS_OP_WRITE);  // Default: write only (safer)
+                    CONFIG_LIST_APPEND(fault_corruption_t, config->corruption_fault, cur_corruption);
                 }
-            } else if (strcmp(current_section, "delay_fault") == 0 && !config->delay_fault) {
-                config->delay_fault = calloc(1, sizeof(fault_delay_t));
-                if (config->delay_fault) {
-                    config->delay_fault->probability = 0.5;
-                    config->delay_fault->delay_ms = 500;
-                    config->delay_fault->operations_mask = 0xFFFFFFFF;  // Default: all operations
+            } else if (strcmp(current_section, "delay_fault") == 0) {
+                cur_delay = calloc(1, sizeof(fault_delay_t));
+                if (cur_delay) {
+                    cur_delay->probability = 0.5;
+                    cur_delay->delay_ms = 500;
+                    cur_delay->operations_mask = 0xFFFFFFFF;  // Default: all operations
+                    CONFIG_LIST_APPEND(fault_delay_t, config->delay_fault, cur_delay);
                 }
-            } else if (strcmp(current_section, "timing_fault") == 0 && !config->timing_fault) {
-                config->timing_fault = calloc(1, sizeof(fault_timing_t));
-                if (config->timing_fault) {
-                    config->timing_fault->enabled = false;  // Default: disabled for safety
-                    config->timing_fault->after_minutes = 5;
-                    config->timing_fault->operations_mask = 0xFFFFFFFF;  // Default: all operations
+            } else if (strcmp(current_section, "timing_fault") == 0) {
+                cur_timing = calloc(1, sizeof(fault_timing_t));
+                if (cur_timing) {
+                    cur_timing->enabled = false;  // Default: disabled for safety
+                    cur_timing->after_minutes = 5;
+                    cur_timing->operations_mask = 0xFFFFFFFF;  // Default: all operations
+                    CONFIG_LIST_APPEND(fault_timing_t, config->timing_fault, cur_timing);
                 }
-            } else if (strcmp(current_section, "operation_count_fault") == 0 && !config->operation_count_fault) {
-                config->operation_count_fault = calloc(1, sizeof(fault_operation_count_t));
-                if (config->operation_count_fault) {
-                    config->operation_count_fault->enabled = false;  // Default: disabled for safety
-                    config->operation_count_fault->every_n_operations = 10;
-                    config->operation_count_fault->after_bytes = 1024 * 1024; // 1MB
-                    config->operation_count_fault->operations_mask = 0xFFFFFFFF;  // Default: all operations
+            } else if (strcmp(current_section, "operation_count_fault") == 0) {
+                cur_operation_count = calloc(1, sizeof(fault_operation_count_t));
+                if (cur_operation_count) {
+                    cur_operation_count->enabled = false;  // Default: disabled for safety
+                    cur_operation_count->every_n_operations = 10;
+                    cur_operation_count->after_bytes = 1024 * 1024; // 1MB
+                    cur_operation_count->operations_mask = 0xFFFFFFFF;  // Default: all operations
+                    CONFIG_LIST_APPEND(fault_operation_count_t, config->operation_count_fault, cur_operation_count);
                 }
-            } else if (strcmp(current_section, "partial_fault") == 0 && !config->partial_fault) {
-                config->partial_fault = calloc(1, sizeof(fault_partial_t));
-                if (config->partial_fault) {
-                    config->partial_fault->probability = 0.5;
-                    config->partial_fault->factor = 0.5;
-                    config->partial_fault->operations_mask = (1 << FS_OP_READ) | (1 << FS_OP_WRITE);  // Default: read/write only
+            } else if (strcmp(current_section, "partial_fault") == 0) {
+                cur_partial = calloc(1, sizeof(fault_partial_t));
+                if (cur_partial) {
+                    cur_partial->probability = 0.5;
+                    cur_partial->factor = 0.5;
+                    cur_partial->operations_mask = (1 << FS_OP_READ) | (1 << FS_OP_WRITE);  // Default: read/write only
+                    CONFIG_LIST_APPEND(fault_partial_t, config->partial_fault, cur_partial);
                 }
             }
             
             continue;
         }
         
-        char key[128] = {0};
-        char value[128] = {0};
-        
-        // Parse key-value pairs
-        if (sscanf(line, "%127[^=]=%127[^\n]", key, value) == 2) {
+        // Parse key-value pairs (split in place at the first '=')
+        char *equals = strchr(line, '=');
+        if (equals && equals != line && equals[1] != '\0') {
+            *equals = '\0';
+
             // Trim whitespace
-            char *k = key;
+            char *k = line;
             while (*k && *k == ' ') k++;
-            char *v = value;
+            char *v = equals + 1;
             while (*v && *v == ' ') v++;
             
             // Remove trailing whitespace from key
@@ -227,70 +317,94 @@ bool config_load_from_file(fs_config_t *config, const char *filename) {
                     config->log_file = strdup(v);
                 } else if (strcmp(k, "log_level") == 0) {
                     config->log_level = atoi(v);
+                } else if (strcmp(k, "log_binary") == 0) {
+                    config->log_binary = (strcmp(v, "true") == 0 || strcmp(v, "1") == 0);
                 } else if (strcmp(k, "enable_fault_injection") == 0) {
                     config->enable_fault_injection = (strcmp(v, "true") == 0 || strcmp(v, "1") == 0);
+                } else if (strcmp(k, "random_seed") == 0) {
+                    config->random_seed = strtoull(v, NULL, 0);
+                } else if (strcmp(k, "hugepage_buffers") == 0) {
+                    config->hugepage_buffers = (strcmp(v, "true") == 0 || strcmp(v, "1") == 0);
                 }
             }
             // Process error fault configuration
-            else if (strcmp(current_section, "error_fault") == 0 && config->error_fault) {
+            else if (strcmp(current_section, "error_fault") == 0 && cur_error) {
                 if (strcmp(k, "probability") == 0) {
-                    config->error_fault->probability = atof(v);
+                    cur_error->probability = atof(v);
                 } else if (strcmp(k, "error_code") == 0) {
-                    config->error_fault->error_code = atoi(v);
+                    cur_error->error_code = atoi(v);
                 } else if (strcmp(k, "operations") == 0) {
-                    config->error_fault->operations_mask = config_parse_operations_mask(v);
+                    cur_error->operations_mask = config_parse_operations_mask(v);
+                } else if (strcmp(k, "path") == 0) {
+                    free(cur_error->path);
+                    cur_error->path = v[0] ? strdup(v) : NULL;
                 }
             }
             // Process corruption fault configuration
-            else if (strcmp(current_section, "corruption_fault") == 0 && config->corruption_fault) {
+            else if (strcmp(current_section, "corruption_fault") == 0 && cur_corruption) {
                 if (strcmp(k, "probability") == 0) {
-                    config->corruption_fault->probability = atof(v);
+                    cur_corruption->probability = atof(v);
                 } else if (strcmp(k, "percentage") == 0) {
-                    config->corruption_fault->percentage = atof(v);
+                    cur_corruption->percentage = atof(v);
                 } else if (strcmp(k, "operations") == 0) {
-                    config->corruption_fault->operations_mask = config_parse_operations_mask(v);
+                    cur_corruption->operations_mask = config_parse_operations_mask(v);
+                } else if (strcmp(k, "path") == 0) {
+                    free(cur_corruption->path);
+                    cur_corruption->path = v[0] ? strdup(v) : NULL;
                 }
             }
             // Process delay fault configuration
-            else if (strcmp(current_section, "delay_fault") == 0 && config->delay_fault) {
+            else if (strcmp(current_section, "delay_fault") == 0 && cur_delay) {
                 if (strcmp(k, "probability") == 0) {
-                    config->delay_fault->probability = atof(v);
+                    cur_delay->probability = atof(v);
                 } else if (strcmp(k, "delay_ms") == 0) {
-                    config->delay_fault->delay_ms = atoi(v);
+                    cur_delay->delay_ms = atoi(v);
                 } else if (strcmp(k, "operations") == 0) {
-                    config->delay_fault->operations_mask = config_parse_operations_mask(v);
+                    cur_delay->operations_mask = config_parse_operations_mask(v);
+                } else if (strcmp(k, "path") == 0) {
+                    free(cur_delay->path);
+                    cur_delay->path = v[0] ? strdup(v) : NULL;
                 }
             }
             // Process timing fault configuration
-            else if (strcmp(current_section, "timing_fault") == 0 && config->timing_fault) {
+            else if (strcmp(current_section, "timing_fault") == 0 && cur_timing) {
                 if (strcmp(k, "enabled") == 0) {
-                    config->timing_fault->enabled = (strcmp(v, "true") == 0 || strcmp(v, "1") == 0);
+                    cur_timing->enabled = (strcmp(v, "true") == 0 || strcmp(v, "1") == 0);
                 } else if (strcmp(k, "after_minutes") == 0) {
-                    config->timing_fault->after_minutes = atoi(v);
+                    cur_timing->after_minutes = atoi(v);
                 } else if (strcmp(k, "operations") == 0) {
-                    config->timing_fault->operations_mask = config_parse_operations_mask(v);
+                    cur_timing->operations_mask = config_parse_operations_mask(v);
+                } else if (strcmp(k, "path") == 0) {
+                    free(cur_timing->path);
+                    cur_timing->path = v[0] ? strdup(v) : NULL;
                 }
             }
             // Process operation count fault configuration
-            else if (strcmp(current_section, "operation_count_fault") == 0 && config->operation_count_fault) {
+            else if (strcmp(current_section, "operation_count_fault") == 0 && cur_operation_count) {
                 if (strcmp(k, "enabled") == 0) {
-                    config->operation_count_fault->enabled = (strcmp(v, "true") == 0 || strcmp(v, "1") == 0);
+                    cur_operation_count->enabled = (strcmp(v, "true") == 0 || strcmp(v, "1") == 0);
                 } else if (strcmp(k, "every_n_operations") == 0) {
-                    config->operation_count_fault->every_n_operations = atoi(v);
+                    cur_operation_count->every_n_operations = atoi(v);
                 } else if (strcmp(k, "after_bytes") == 0) {
-                    config->operation_count_fault->after_bytes = atol(v);
+                    cur_operation_count->after_bytes = atol(v);
                 } else if (strcmp(k, "operations") == 0) {
-                    config->operation_count_fault->operations_mask = config_parse_operations_mask(v);
+                    cur_operation_count->operations_mask = config_parse_operations_mask(v);
+                } else if (strcmp(k, "path") == 0) {
+                    free(cur_operation_count->path);
+                    cur_operation_count->path = v[0] ? strdup(v) : NULL;
                 }
             }
             // Process partial operation fault configuration
-            else if (strcmp(current_section, "partial_fault") == 0 && config->partial_fault) {
+            else if (strcmp(current_section, "partial_fault") == 0 && cur_partial) {
                 if (strcmp(k, "probability") == 0) {
-                    config->partial_fault->probability = atof(v);
+                    cur_partial->probability = atof(v);
                 } else if (strcmp(k, "factor") == 0) {
-                    config->partial_fault->factor = atof(v);
+                    cur_partial->factor = atof(v);
                 } else if (strcmp(k, "operations") == 0) {
-                    config->partial_fault->operations_mask = config_parse_operations_mask(v);
+                    cur_partial->operations_mask = config_parse_operations_mask(v);
+                } else if (strcmp(k, "path") == 0) {
+                    free(cur_partial->path);
+                    cur_partial->path = v[0] ? strdup(v) : NULL;
                 }
             }
             // Process management/event emission configuration
@@ -302,11 +416,55 @@ bool config_load_from_file(fs_config_t *config, const char *filename) {
                     config->event_socket_path = strdup(v);
                 } else if (strcmp(k, "emit_metadata_ops") == 0) {
                     config->emit_metadata_ops = (strcmp(v, "true") == 0 || strcmp(v, "1") == 0);
+                } else if (strcmp(k, "event_format") == 0) {
+                    if (strcmp(v, "binary") == 0) {
+                        config->event_binary = true;
+                    } else if (strcmp(v, "json") == 0) {
+                        config->event_binary = false;
+                    } else {
+                        fprintf(stderr, "Unknown event_format '%s', using json\n", v);
+                        config->event_binary = false;
+                    }
+                } else if (strcmp(k, "event_shm_path") == 0) {
+                    free(config->event_shm_path);
+                    config->event_shm_path = v[0] ? strdup(v) : NULL;
+                } else if (strcmp(k, "event_shm_size") == 0) {
+                    config->event_shm_size = (size_t)strtoull(v, NULL, 10);
+                } else if (strncmp(k, "data_", 5) == 0) {
+                    config_parse_event_limit(&config->event_limits[EVENT_CLASS_DATA], k + 5, v);
+                } else if (strncmp(k, "metadata_", 9) == 0) {
+                    config_parse_event_limit(&config->event_limits[EVENT_CLASS_METADATA], k + 9, v);
+                }
+            }
+            // Process FUSE session configuration
+            else if (strcmp(current_section, "fuse") == 0) {
+                double timeout = atof(v) > 0.0 ? atof(v) : 0.0;
+                unsigned int count = (unsigned int)strtoul(v, NULL, 0);
+                bool flag = (strcmp(v, "true") == 0 || strcmp(v, "1") == 0);
+                if (strcmp(k, "attr_timeout") == 0) {
+                    config->attr_timeout = timeout;
+                } else if (strcmp(k, "entry_timeout") == 0) {
+                    config->entry_timeout = timeout;
+                } else if (strcmp(k, "negative_timeout") == 0) {
+                    config->negative_timeout = timeout;
+                } else if (strcmp(k, "max_write") == 0) {
+                    config->max_write = count;
+                } else if (strcmp(k, "max_read") == 0) {
+                    config->max_read = count;
+                } else if (strcmp(k, "max_background") == 0) {
+                    config->max_background = count;
+                } else if (strcmp(k, "congestion_threshold") == 0) {
+                    config->congestion_threshold = count;
+                } else if (strcmp(k, "writeback_cache") == 0) {
+                    config->writeback_cache = flag;
+                } else if (strcmp(k, "direct_io") == 0) {
+                    config->direct_io = flag;
                 }
             }
         }
     }
     
+    free(line);
     fclose(file);
     return true;
 }
@@ -338,42 +496,45 @@ void config_cleanup(fs_config_t *config) {
         free(config->event_socket_path);
         config->event_socket_path = NULL;
     }
+    if (config->event_shm_path) {
+        free(config->event_shm_path);
+        config->event_shm_path = NULL;
+    }
     
     // Free error fault resources
-    if (config->error_fault) {
-        free(config->error_fault);
-        config->error_fault = NULL;
-    }
+    CONFIG_LIST_FREE(fault_error_t, config->error_fault);
     
     // Free corruption fault resources
-    if (config->corruption_fault) {
-        free(config->corruption_fault);
-        config->corruption_fault = NULL;
-    }
+    CONFIG_LIST_FREE(fault_corruption_t, config->corruption_fault);
     
     // Free delay fault resources
-    if (config->delay_fault) {
-        free(config->delay_fault);
-        config->delay_fault = NULL;
-    }
+    CONFIG_LIST_FREE(fault_delay_t, config->delay_fault);
     
     // Free timing fault resources
-    if (config->timing_fault) {
-        free(config->timing_fault);
-        config->timing_fault = NULL;
-    }
+    CONFIG_LIST_FREE(fault_timing_t, config->timing_fault);
     
     // Free operation count fault resources
-    if (config->operation_count_fault) {
-        free(config->operation_count_fault);
-        config->operation_count_fault = NULL;
-    }
+    CONFIG_LIST_FREE(fault_operation_count_t, config->operation_count_fault);
     
     // Free partial fault resources
-    if (config->partial_fault) {
-        free(config->partial_fault);
-        config->partial_fault = NULL;
+    CONFIG_LIST_FREE(fault_partial_t, config->partial_fault);
+}
+
+// Print the operations a fault rule applies to
+static void print_operations_mask(uint32_t operations_mask) {
+    printf("    Operations: ");
+    if (operations_mask == 0xFFFFFFFF) {
+        printf("all");
+    } else {
+        int printed = 0;
+        for (int i = 0; i < FS_OP_COUNT; i++) {
+            if (operations_mask & (1 << i)) {
+                printf("%s%s", printed > 0 ? ", " : "", fs_op_names[i]);
+                printed++;
+            }
+        }
     }
+    printf("\n");
 }
 
 // Print current configuration
@@ -383,7 +544,22 @@ void config_print(fs_config_t *config) {
     printf("  Storage Path: %s\n", config->storage_path);
     printf("  Log File: %s\n", config->log_file);
     printf("  Log Level: %d\n", config->log_level);
+    if (config->log_binary) {
+        printf("  Log Format: binary\n");
+    }
     printf("  Enable Fault Injection: %s\n", config->enable_fault_injection ? "true" : "false");
+    if (config->random_seed) {
+        printf("  Random Seed: %llu\n", (unsigned long long)config->random_seed);
+    }
+    if (config->hugepage_buffers) {
+        printf("  Huge Page Buffers: true\n");
+    }
+    printf("  Kernel Cache: attr %.2fs, entry %.2fs, negative %.2fs\n",
+           config->attr_timeout, config->entry_timeout, config->negative_timeout);
+    printf("  FUSE: max_write %u, max_read %u, max_background %u, congestion_threshold %u%s%s\n",
+           config->max_write, config->max_read, config->max_background,
+           config->congestion_threshold, config->writeback_cache ? ", writeback_cache" : "",
+           config->direct_io ? ", direct_io" : "");
     
     if (config->config_file) {
         printf("  Config File: %s\n", config->config_file);
@@ -391,61 +567,34 @@ void config_print(fs_config_t *config) {
     
     // Print fault configurations if enabled
     if (config->enable_fault_injection) {
-        if (config->error_fault) {
+        for (fault_error_t *f = config->error_fault; f; f = f->next) {
             printf("  Error Fault:\n");
-            printf("    Probability: %.2f\n", config->error_fault->probability);
-            printf("    Error Code: %d\n", config->error_fault->error_code);
-            printf("    Operations: ");
-            if (config->error_fault->operations_mask == 0xFFFFFFFF) {
-                printf("all");
-            } else {
-                int printed = 0;
-                for (int i = 0; i < FS_OP_COUNT; i++) {
-                    if (config->error_fault->operations_mask & (1 << i)) {
-                        printf("%s%s", printed > 0 ? ", " : "", fs_op_names[i]);
-                        printed++;
-                    }
-                }
+            printf("    Probability: %.2f\n", f->probability);
+            printf("    Error Code: %d\n", f->error_code);
+            print_operations_mask(f->operations_mask);
+            if (f->path) {
+                printf("    Path: %s\n", f->path);
             }
-            printf("\n");
         }
         
-        if (config->corruption_fault) {
+        for (fault_corruption_t *f = config->corruption_fault; f; f = f->next) {
             printf("  Corruption Fault:\n");
-            printf("    Probability: %.2f\n", config->corruption_fault->probability);
-            printf("    Percentage: %.2f%%\n", config->corruption_fault->percentage);
-            printf("    Operations: ");
-            if (config->corruption_fault->operations_mask == 0xFFFFFFFF) {
-                printf("all");
-            } else {
-                int printed = 0;
-                for (int i = 0; i < FS_OP_COUNT; i++) {
-                    if (config->corruption_fault->operations_mask & (1 << i)) {
-                        printf("%s%s", printed > 0 ? ", " : "", fs_op_names[i]);
-                        printed++;
-                    }
-                }
+            printf("    Probability: %.2f\n", f->probability);
+            printf("    Percentage: %.2f%%\n", f->percentage);
+            print_operations_mask(f->operations_mask);
+            if (f->path) {
+                printf("    Path: %s\n", f->path);
             }
-            printf("\n");
         }
         
-        if (config->delay_fault) {
+        for (fault_delay_t *f = config->delay_fault; f; f = f->next) {
             printf("  Delay Fault:\n");
-            printf("    Probability: %.2f\n", config->delay_fault->probability);
-            printf("    Delay: %d ms\n", config->delay_fault->delay_ms);
-            printf("    Operations: ");
-            if (config->delay_fault->operations_mask == 0xFFFFFFFF) {
-                printf("all");
-            } else {
-                int printed = 0;
-                for (int i = 0; i < FS_OP_COUNT; i++) {
-                    if (config->delay_fault->operations_mask & (1 << i)) {
-                        printf("%s%s", printed > 0 ? ", " : "", fs_op_names[i]);
-                        printed++;
-                    }
-                }
+            printf("    Probability: %.2f\n", f->probability);
+            printf("    Delay: %d ms\n", f->delay_ms);
+            print_operations_mask(f->operations_mask);
+            if (f->path) {
+                printf("    Path: %s\n", f->path);
             }
-            printf("\n");
         }
         
         // Print other fault types...
@@ -6,47 +6,77 @@
 #include <stdint.h>  /* For uint32_t */
 #include "fs_common.h"
 
-// Error fault - returns error codes for operations
+// Event classes for emission limits: data covers read, write, the
+// server-side copy and allocation (copy_file_range, fallocate) and the
+// namespace changes (create, truncate, unlink, rename, mknod); metadata is
+// everything else and is only emitted with emit_metadata_ops
+typedef enum {
+    EVENT_CLASS_DATA = 0,
+    EVENT_CLASS_METADATA,
+    EVENT_CLASS_COUNT
+} event_class_t;
+
+// Emission limits for one event class ([management] data_* / metadata_*).
+// Fault and corruption events are never limited.
 typedef struct {
+    double sample_rate;       // Fraction of events emitted (1.0 = all)
+    double rate_limit;        // Token bucket refill, events per second (0 = unlimited)
+    double rate_burst;        // Bucket depth in events (0 = one second's worth)
+} event_limit_t;
+
+// Error fault - returns error codes for operations
+typedef struct fault_error {
     float probability;        // Probability of triggering (0.0-1.0)
     int error_code;           // Specific error code to return (e.g., -EIO)
     uint32_t operations_mask; // Bit mask of operations to affect
+    char *path;               // Path pattern the rule is limited to (NULL = all paths)
+    struct fault_error *next; // Next rule (repeated section)
 } fault_error_t;
 
 // Corruption fault - corrupts data in read/write operations
-typedef struct {
+typedef struct fault_corruption {
     float probability;        // Probability of corrupting data
     float percentage;         // Percentage of data to corrupt (0-100)
     uint32_t operations_mask; // Bit mask of operations to affect
+    char *path;               // Path pattern the rule is limited to (NULL = all paths)
+    struct fault_corruption *next; // Next rule (repeated section)
 } fault_corruption_t;
 
 // Delay fault - adds latency to operations
-typedef struct {
+typedef struct fault_delay {
     float probability;        // Probability of adding delay
     int delay_ms;             // Delay in milliseconds
     uint32_t operations_mask; // Bit mask of operations to affect
+    char *path;               // Path pattern the rule is limited to (NULL = all paths)
+    struct fault_delay *next; // Next rule (repeated section)
 } fault_delay_t;
 
 // Timing fault - triggers based on time patterns
-typedef struct {
+typedef struct fault_timing {
     bool enabled;             // Whether timing-based triggering is enabled
     int after_minutes;        // Start triggering after X minutes of operation
     uint32_t operations_mask; // Bit mask of operations to affect
+    char *path;               // Path pattern the rule is limited to (NULL = all paths)
+    struct fault_timing *next; // Next rule (repeated section)
 } fault_timing_t;
 
 // Operation count fault - triggers based on operation counts
-typedef struct {
+typedef struct fault_operation_count {
     bool enabled;             // Whether count-based triggering is enabled
     int every_n_operations;   // Trigger on every Nth operation
     size_t after_bytes;       // Trigger after X bytes processed
     uint32_t operations_mask; // Bit mask of operations to affect
+    char *path;               // Path pattern the rule is limited to (NULL = all paths)
+    struct fault_operation_count *next; // Next rule (repeated section)
 } fault_operation_count_t;
 
 // Partial operation fault - only completes part of read/write operations
-typedef struct {
+typedef struct fault_partial {
     float probability;        // Probability of partial operation
     float factor;             // Factor to multiply size by (0.0-1.0)
     uint32_t operations_mask; // Bit mask of operations to affect
+    char *path;               // Path pattern the rule is limited to (NULL = all paths)
+    struct fault_partial *next; // Next rule (repeated section)
 } fault_partial_t;
 
 // Configuration structure
@@ -56,11 +86,15 @@ typedef struct {
     char *storage_path;      // Path to backing storage
     char *log_file;          // Path to log file
     int log_level;           // Log level (0-3)
+    bool log_binary;         // Write binary records (decode with tools/log_decode)
     
     // Fault injection master switch
     bool enable_fault_injection;  // Master switch for fault injection
+    uint64_t random_seed;         // Master RNG seed (0 = derive from time)
+    bool hugepage_buffers;        // Back large scratch buffers with huge pages
     
-    // Pointers to specific fault types (NULL if not enabled)
+    // Lists of rules for each fault type (NULL if not enabled). Each
+    // occurrence of a fault section in the config file adds one rule.
     fault_error_t *error_fault;
     fault_corruption_t *corruption_fault;
     fault_delay_t *delay_fault;
@@ -74,7 +108,25 @@ typedef struct {
     // Event emission / management settings
     bool event_emission_enabled;  // Emit events to Unix socket
     char *event_socket_path;      // Path to event socket
+    bool event_binary;            // Binary wire format instead of JSON
+    char *event_shm_path;         // Shared-memory ring instead of the socket (NULL = socket)
+    size_t event_shm_size;        // Ring data area size in bytes
     bool emit_metadata_ops;       // Emit getattr/readdir/access events
+    event_limit_t event_limits[EVENT_CLASS_COUNT];  // Sampling / rate limits per class
+
+    // Kernel caching ([fuse]). Turned off only for the paths a getattr rule
+    // matches (every path for a rule without a path pattern).
+    double attr_timeout;          // Seconds the kernel may cache attributes
+    double entry_timeout;         // Seconds the kernel may cache name lookups
+    double negative_timeout;      // Seconds the kernel may cache missing names (0 = off)
+
+    // FUSE session tuning ([fuse]; 0 = kernel/libfuse default)
+    unsigned int max_write;       // Largest write request in bytes
+    unsigned int max_read;        // Largest read request in bytes
+    unsigned int max_background;  // Background (readahead, write-back) requests in flight
+    unsigned int congestion_threshold;  // Background requests before the kernel throttles
+    bool writeback_cache;         // Kernel write-back cache
+    bool direct_io;               // Open files with direct_io (no page cache)
 } fs_config_t;
 
 // Initialize configuration with defaults from environment
@@ -92,6 +144,13 @@ fs_config_t *config_get_global(void);
 // Print current configuration
 void config_print(fs_config_t *config);
 
+// Operations that "all" (and the all-operations default of the error, delay,
+// timing and operation count sections) leaves out. They were added after
+// configurations relied on "all": selecting them by name keeps an existing
+// rule from delaying every close() or shifting an every_n_operations count.
+#define CONFIG_OPS_NAMED_ONLY ((1u << FS_OP_COPY_FILE_RANGE) | (1u << FS_OP_FALLOCATE) | \
+                               (1u << FS_OP_FSYNC) | (1u << FS_OP_FLUSH) | (1u << FS_OP_STATFS))
+
 // Helper function to check if an operation should be affected by a fault
 bool config_should_affect_operation(uint32_t operations_mask, fs_op_type_t operation);
 
@@ -0,0 +1,183 @@
+#include "config_reload.h"
+#include "epoch.h"
+#include "fault_injector.h"
+#include "fault_plan.h"
+#include "log.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// How often retired plans still in use are checked again
+#define RECLAIM_INTERVAL_MS 100
+
+static int request_fd = -1;           // eventfd: reload requested
+static int stop_fd = -1;              // eventfd: stop the thread
+static pthread_t reload_thread;
+static bool running = false;
+static char *reload_path = NULL;
+static char *status_path = NULL;      // Outcome of the last reload (NULL = none)
+static unsigned long attempts = 0;    // Reloads attempted so far
+
+// Publish "<attempts> <loaded|failed> <generation>" in the status file.
+// Written to a temporary file and renamed, so readers never see half a line.
+static void write_status(bool loaded) {
+    if (!status_path) {
+        return;
+    }
+    epoch_enter();
+    unsigned int generation = fault_plan_current()->generation;
+    epoch_exit();
+
+    size_t len = strlen(status_path) + sizeof(".tmp");
+    char *tmp = malloc(len);
+    if (!tmp) {
+        LOG_ERROR("Reload: memory allocation failed, status not written");
+        return;
+    }
+    snprintf(tmp, len, "%s.tmp", status_path);
+    FILE *f = fopen(tmp, "w");
+    if (!f) {
+        LOG_ERROR("Reload: cannot write %s: %s", tmp, strerror(errno));
+        free(tmp);
+        return;
+    }
+    fprintf(f, "%lu %s %u\n", attempts, loaded ? "loaded" : "failed", generation);
+    if (fclose(f) != 0 || rename(tmp, status_path) != 0) {
+        LOG_ERROR("Reload: cannot publish %s: %s", status_path, strerror(errno));
+        unlink(tmp);
+    }
+    free(tmp);
+}
+
+static void hup_handler(int sig) {
+    (void)sig;
+    config_reload_request();
+}
+
+static void *reload_main(void *arg) {
+    (void)arg;
+    struct pollfd fds[2] = {
+        { .fd = request_fd, .events = POLLIN },
+        { .fd = stop_fd, .events = POLLIN }
+    };
+    size_t retired = 0;
+
+    for (;;) {
+        int ready = poll(fds, 2, retired > 0 ? RECLAIM_INTERVAL_MS : -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Reload: poll failed: %s", strerror(errno));
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            uint64_t requests;
+            if (read(request_fd, &requests, sizeof(requests)) < 0 && errno != EAGAIN) {
+                LOG_ERROR("Reload: eventfd read failed: %s", strerror(errno));
+            }
+            LOG_INFO("Reload: reloading fault rules from %s", reload_path);
+            bool loaded = fault_injector_reload(reload_path);
+            attempts++;
+            write_status(loaded);
+        }
+        retired = fault_plan_reclaim();
+    }
+    return NULL;
+}
+
+// Start the reload thread
+int config_reload_start(const char *config_file, const char *status_file) {
+    if (running) {
+        return 0;
+    }
+    if (!config_file) {
+        return -EINVAL;
+    }
+
+    reload_path = strdup(config_file);
+    status_path = status_file ? strdup(status_file) : NULL;
+    request_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!reload_path || (status_file && !status_path) || request_fd < 0 || stop_fd < 0) {
+        int err = (reload_path && (!status_file || status_path)) ? errno : ENOMEM;
+        LOG_ERROR("Reload: cannot set up: %s", strerror(err));
+        config_reload_stop();
+        return -err;
+    }
+
+    int err = pthread_create(&reload_thread, NULL, reload_main, NULL);
+    if (err != 0) {
+        LOG_ERROR("Reload: failed to start thread: %s", strerror(err));
+        config_reload_stop();
+        return -err;
+    }
+    running = true;
+    attempts = 0;
+    write_status(true);  // The rules loaded at mount
+
+    // Replaces the session exit handler libfuse installs for SIGHUP
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = hup_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    if (sigaction(SIGHUP, &sa, NULL) != 0) {
+        LOG_WARN("Reload: cannot install SIGHUP handler: %s", strerror(errno));
+    }
+
+    LOG_INFO("Reload: send SIGHUP to reload fault rules from %s", reload_path);
+    return 0;
+}
+
+// Wake the reload thread (only write(), so usable from a signal handler)
+void config_reload_request(void) {
+    int saved_errno = errno;
+    uint64_t one = 1;
+    if (request_fd >= 0 && write(request_fd, &one, sizeof(one)) < 0) {
+        // Counter full: a reload is pending anyway
+    }
+    errno = saved_errno;
+}
+
+// Stop the reload thread
+void config_reload_stop(void) {
+    if (running) {
+        // The session is going away: a late SIGHUP has nothing to reload
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = SIG_IGN;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGHUP, &sa, NULL);
+
+        uint64_t one = 1;
+        if (write(stop_fd, &one, sizeof(one)) < 0) {
+            LOG_ERROR("Reload: failed to wake thread: %s", strerror(errno));
+        }
+        pthread_join(reload_thread, NULL);
+        running = false;
+    }
+
+    if (request_fd >= 0) {
+        close(request_fd);
+    }
+    if (stop_fd >= 0) {
+        close(stop_fd);
+    }
+    request_fd = stop_fd = -1;
+    free(reload_path);
+    free(status_path);
+    reload_path = status_path = NULL;
+}
@@ -0,0 +1,28 @@
+#ifndef CONFIG_RELOAD_H
+#define CONFIG_RELOAD_H
+
+// Hot reload of the fault rules.
+//
+// SIGHUP (or config_reload_request()) wakes a reload thread that reads the
+// configuration file again and swaps in the newly compiled fault plan with
+// fault_injector_reload(). FUSE workers keep serving requests throughout:
+// they switch to the new rules with their next lookup, and the thread frees
+// the old plan once the last request using it has finished.
+//
+// With a status file, the thread publishes the outcome of every attempt as
+// one line, "<attempts> <loaded|failed> <generation>", replaced atomically:
+// attempts counts the reloads tried so far (0 for the rules loaded at mount)
+// and generation is that of the active plan. Tools wait for attempts to grow
+// instead of parsing the log, whose format and level may not show it.
+
+// Start the reload thread for a configuration file and route SIGHUP to it;
+// status_file may be NULL (0 on success, negative errno on failure)
+int config_reload_start(const char *config_file, const char *status_file);
+
+// Ask for a reload (async-signal-safe)
+void config_reload_request(void);
+
+// Stop the reload thread (SIGHUP is ignored from then on)
+void config_reload_stop(void);
+
+#endif // CONFIG_RELOAD_H
@@ -0,0 +1,451 @@
+#include "corruption.h"
+#include "buf_pool.h"
+#include "log.h"
+#include "rng.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Use the bitmap path once at least one byte in SPARSE_LIMIT is corrupted
+#define SPARSE_LIMIT 32
+
+// Up to this many positions are sampled on the stack, without a hash set
+#define SMALL_SAMPLE 16
+
+// Initial range capacity of a thread's detail arena
+#define ARENA_MIN_RANGES 64
+
+// 64-bit XOR mask with no zero byte (a zero byte would leave data unchanged).
+// Zero bytes are bumped to 0x01, a negligible bias for fault injection.
+static inline uint64_t nonzero_mask_word(void) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    uint64_t word = rng_next();
+    uint64_t zero_bytes = ~(((word & low7) + low7) | word | low7);  // 0x80 in each zero byte
+    return word | (zero_bytes >> 7);
+}
+
+// Source of single non-zero mask bytes, eight per random draw
+typedef struct {
+    uint64_t word;
+    int left;
+} mask_stream_t;
+
+static inline unsigned char next_mask_byte(mask_stream_t *stream) {
+    if (stream->left == 0) {
+        stream->word = nonzero_mask_word();
+        stream->left = 8;
+    }
+    unsigned char mask = (unsigned char)stream->word;
+    stream->word >>= 8;
+    stream->left--;
+    return mask;
+}
+
+// Per-thread storage behind corruption_detail_t, reused across calls and
+// grown as needed (freed when the thread exits)
+typedef struct {
+    corruption_range_t *ranges;
+    size_t range_cap;
+    unsigned char *masks;
+    size_t mask_cap;
+} detail_arena_t;
+
+static __thread detail_arena_t tls_arena;
+static __thread bool tls_arena_registered = false;
+static pthread_key_t arena_key;
+static pthread_once_t arena_key_once = PTHREAD_ONCE_INIT;
+
+static void arena_release(void *arg) {
+    detail_arena_t *arena = arg;
+    free(arena->ranges);
+    free(arena->masks);
+    arena->ranges = NULL;
+    arena->masks = NULL;
+    arena->range_cap = arena->mask_cap = 0;
+}
+
+static void arena_key_create(void) {
+    pthread_key_create(&arena_key, arena_release);
+}
+
+// Make room for `masks` mask bytes (the ranges grow while recording)
+static bool arena_reserve(size_t masks) {
+    detail_arena_t *arena = &tls_arena;
+    if (!tls_arena_registered) {
+        pthread_once(&arena_key_once, arena_key_create);
+        pthread_setspecific(arena_key, arena);
+        tls_arena_registered = true;
+    }
+    if (arena->mask_cap < masks) {
+        unsigned char *grown = realloc(arena->masks, masks);
+        if (!grown) {
+            return false;
+        }
+        arena->masks = grown;
+        arena->mask_cap = masks;
+    }
+    if (!arena->ranges) {
+        arena->ranges = malloc(ARENA_MIN_RANGES * sizeof(corruption_range_t));
+        if (!arena->ranges) {
+            return false;
+        }
+        arena->range_cap = ARENA_MIN_RANGES;
+    }
+    return true;
+}
+
+// State shared by the sampling callbacks
+typedef struct {
+    unsigned char *buffer;
+    mask_stream_t masks;
+    bool record;                  // Ground truth wanted and still complete
+    bool truncated;
+    size_t range_count;
+    size_t recorded;              // Mask bytes recorded
+} corrupt_ctx_t;
+
+// Record that the byte at pos was XORed with mask (positions arrive in
+// ascending order, so a byte either extends the last range or opens one)
+static inline void record_byte(corrupt_ctx_t *ctx, size_t pos, unsigned char mask) {
+    detail_arena_t *arena = &tls_arena;
+    corruption_range_t *last = ctx->range_count ? &arena->ranges[ctx->range_count - 1] : NULL;
+
+    if (last && last->offset + last->length == pos) {
+        last->length++;
+    } else {
+        if (ctx->range_count == arena->range_cap) {
+            corruption_range_t *grown = realloc(arena->ranges,
+                                                2 * arena->range_cap * sizeof(corruption_range_t));
+            if (!grown) {
+                ctx->record = false;
+                ctx->truncated = true;
+                return;
+            }
+            arena->ranges = grown;
+            arena->range_cap *= 2;
+        }
+        arena->ranges[ctx->range_count].offset = pos;
+        arena->ranges[ctx->range_count].length = 1;
+        ctx->range_count++;
+    }
+    arena->masks[ctx->recorded++] = mask;
+}
+
+// Fast path for sixteen corrupted bytes that continue the last range
+static inline bool record_run16(corrupt_ctx_t *ctx, size_t pos, const void *masks) {
+    if (ctx->range_count == 0) {
+        return false;
+    }
+    corruption_range_t *last = &tls_arena.ranges[ctx->range_count - 1];
+    if (last->offset + last->length != pos) {
+        return false;
+    }
+    last->length += 16;
+    memcpy(tls_arena.masks + ctx->recorded, masks, 16);
+    ctx->recorded += 16;
+    return true;
+}
+
+static inline void corrupt_byte(corrupt_ctx_t *ctx, size_t pos) {
+    unsigned char mask = next_mask_byte(&ctx->masks);
+    ctx->buffer[pos] ^= mask;
+    if (ctx->record) {
+        record_byte(ctx, pos, mask);
+    }
+}
+
+// Knuth's selection sampling (Algorithm S): visits every byte, needs no
+// memory. Only used when the scratch buffers of the other paths cannot be had.
+static void selection_apply(corrupt_ctx_t *ctx, size_t size, size_t count) {
+    for (size_t pos = 0; count > 0; pos++) {
+        if (rng_below(size - pos) < count) {
+            corrupt_byte(ctx, pos);
+            count--;
+        }
+    }
+}
+
+// Add pos to an open-addressed set (slots hold pos + 1, 0 = empty).
+// Returns false if pos was already in it.
+static inline bool set_insert(uint32_t *slots, uint32_t slot_mask, uint32_t pos) {
+    uint32_t key = pos + 1;
+    uint32_t i = (uint32_t)(((uint64_t)key * 0x9E3779B97F4A7C15ULL) >> 32) & slot_mask;
+    while (slots[i]) {
+        if (slots[i] == key) {
+            return false;
+        }
+        i = (i + 1) & slot_mask;
+    }
+    slots[i] = key;
+    return true;
+}
+
+// Insertion sort, linear on input that is already nearly in order
+static void insertion_sort(uint32_t *positions, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        uint32_t pos = positions[i];
+        size_t j = i;
+        for (; j > 0 && positions[j - 1] > pos; j--) {
+            positions[j] = positions[j - 1];
+        }
+        positions[j] = pos;
+    }
+}
+
+// Sort uniformly drawn positions into out: one counting pass scatters them
+// into about count / 2 buckets by their top bits, and an insertion sort
+// orders the few positions that share a bucket. buckets needs room for
+// that many counters.
+static void sort_positions(const uint32_t *positions, uint32_t *out, uint32_t *buckets,
+                           size_t count, size_t size) {
+    unsigned size_bits = 64 - (unsigned)__builtin_clzll((unsigned long long)size);
+    unsigned bucket_bits = 0;
+    while ((2UL << bucket_bits) < count && bucket_bits < size_bits) {
+        bucket_bits++;
+    }
+    unsigned shift = size_bits - bucket_bits;
+    size_t bucket_count = (size_t)1 << bucket_bits;
+
+    memset(buckets, 0, bucket_count * sizeof(uint32_t));
+    for (size_t i = 0; i < count; i++) {
+        buckets[positions[i] >> shift]++;
+    }
+    uint32_t start = 0;
+    for (size_t b = 0; b < bucket_count; b++) {
+        uint32_t n = buckets[b];
+        buckets[b] = start;
+        start += n;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out[buckets[positions[i] >> shift]++] = positions[i];
+    }
+    insertion_sort(out, count);
+}
+
+// Sparse path: Floyd's sampling draws exactly count distinct positions
+// straight from the thread's stream (one draw each), a small hash set rejects
+// repeats, and the positions are sorted before corrupting them in order.
+// Returns false if no scratch memory was available (nothing corrupted).
+static bool sparse_apply(corrupt_ctx_t *ctx, size_t size, size_t count) {
+    if (count <= SMALL_SAMPLE) {
+        uint32_t small[SMALL_SAMPLE];
+        size_t n = 0;
+        for (size_t j = size - count; j < size; j++) {
+            uint32_t pos = (uint32_t)rng_below(j + 1);
+            for (size_t i = 0; i < n; i++) {
+                if (small[i] == pos) {
+                    pos = (uint32_t)j;
+                    break;
+                }
+            }
+            small[n++] = pos;
+        }
+        insertion_sort(small, count);
+        for (size_t i = 0; i < count; i++) {
+            corrupt_byte(ctx, small[i]);
+        }
+        return true;
+    }
+
+    size_t slot_count = 64;
+    while (slot_count < 2 * count) {
+        slot_count <<= 1;
+    }
+    size_t scratch_size = (2 * count + slot_count) * sizeof(uint32_t);
+    uint32_t *positions = buf_pool_get(scratch_size);
+    if (!positions) {
+        return false;
+    }
+    uint32_t *tmp = positions + count;
+    uint32_t *slots = tmp + count;
+    uint32_t slot_mask = (uint32_t)(slot_count - 1);
+    memset(slots, 0, slot_count * sizeof(uint32_t));
+
+    size_t n = 0;
+    for (size_t j = size - count; j < size; j++) {
+        uint32_t pos = (uint32_t)rng_below(j + 1);
+        if (!set_insert(slots, slot_mask, pos)) {
+            pos = (uint32_t)j;  // j itself was never drawn before
+            set_insert(slots, slot_mask, pos);
+        }
+        positions[n++] = pos;
+    }
+
+    // The set is no longer needed, its slots hold the bucket counters
+    uint32_t *sorted = tmp;
+    sort_positions(positions, sorted, slots, count, size);
+    for (size_t i = 0; i < count; i++) {
+        corrupt_byte(ctx, sorted[i]);
+    }
+    buf_pool_put(positions, scratch_size);
+    return true;
+}
+
+// Set `count` distinct random bits of a zeroed bitmap (count <= size / 2,
+// so rejection needs fewer than two draws per bit on average)
+static void bitmap_sample(uint64_t *bitmap, size_t size, size_t count) {
+    while (count > 0) {
+        size_t pos = (size_t)rng_below(size);
+        uint64_t bit = 1ULL << (pos & 63);
+        if (!(bitmap[pos >> 6] & bit)) {
+            bitmap[pos >> 6] |= bit;
+            count--;
+        }
+    }
+}
+
+// 16 byte lanes, one SSE2/NEON register (compiled to scalar code where the
+// target has no vector unit)
+typedef unsigned char v16u8 __attribute__((vector_size(16)));
+
+// Bit of a bitmap byte that selects each lane
+static const v16u8 lane_bits = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+
+// XOR the 16 bytes at p whose bits are set in select (bit i = p[i]) with
+// the non-zero bytes of random. Returns the masks applied, zero in the
+// lanes that were not selected.
+static inline v16u8 xor_block16(unsigned char *p, unsigned select, const uint64_t random[2]) {
+    uint64_t spread[2] = { (select & 0xFF) * 0x0101010101010101ULL,
+                           ((select >> 8) & 0xFF) * 0x0101010101010101ULL };
+    v16u8 lanes, mask, data;
+    memcpy(&lanes, spread, sizeof(lanes));
+    memcpy(&mask, random, sizeof(mask));
+    memcpy(&data, p, sizeof(data));
+
+    lanes = (v16u8)((lanes & lane_bits) != 0);  // 0xFF in selected lanes
+    mask |= (v16u8)(mask == 0) & 1;               // A zero mask byte would change nothing
+    mask &= lanes;
+    data ^= mask;
+    memcpy(p, &data, sizeof(data));
+    return mask;
+}
+
+// Corrupt every byte whose bit is set, scanning in ascending order, 16
+// bytes per vector XOR with the bitmap bits expanded into lane masks. When
+// the ground truth is recorded, the mask of each selected byte is recorded
+// from the same vector.
+static void bitmap_apply(corrupt_ctx_t *ctx, const uint64_t *bitmap, size_t size) {
+    size_t words = (size + 63) / 64;
+
+    for (size_t w = 0; w < words; w++) {
+        uint64_t bits = bitmap[w];
+        size_t base = w * 64;
+        if (!bits) {
+            continue;
+        }
+
+        if (base + 64 > size) {
+            // Partial last word
+            for (; bits; bits &= bits - 1) {
+                corrupt_byte(ctx, base + (size_t)__builtin_ctzll(bits));
+            }
+            continue;
+        }
+
+        uint64_t random[8];
+        rng_fill(random, 8);
+        for (size_t block = 0; block < 4; block++) {
+            unsigned select = (unsigned)(bits >> (block * 16)) & 0xFFFF;
+            if (!select) {
+                continue;
+            }
+            size_t pos = base + block * 16;
+            v16u8 mask = xor_block16(ctx->buffer + pos, select, random + block * 2);
+
+            if (!ctx->record) {
+                continue;
+            }
+            if (select == 0xFFFF && record_run16(ctx, pos, &mask)) {
+                continue;
+            }
+            for (; select && ctx->record; select &= select - 1) {
+                unsigned lane = (unsigned)__builtin_ctz(select);
+                record_byte(ctx, pos + lane, mask[lane]);
+            }
+        }
+    }
+}
+
+// Point the caller's detail at what was recorded in the arena
+static void detail_finish(const corrupt_ctx_t *ctx, corruption_detail_t *detail, size_t count) {
+    if (!detail) {
+        return;
+    }
+    detail->count = count;
+    detail->range_count = ctx->range_count;
+    detail->ranges = tls_arena.ranges;
+    detail->masks = tls_arena.masks;
+    detail->truncated = ctx->truncated;
+    if (ctx->truncated) {
+        LOG_WARN("Corruption: detail arena could not grow, %zu of %zu corrupted bytes recorded",
+                 ctx->recorded, count);
+    }
+}
+
+// Corrupt exactly min(count, size) distinct bytes of buffer
+size_t corruption_apply(unsigned char *buffer, size_t size, size_t count,
+                        corruption_detail_t *detail) {
+    if (detail) {
+        memset(detail, 0, sizeof(*detail));
+    }
+    if (!buffer || size == 0 || count == 0) {
+        return 0;
+    }
+    if (count > size) {
+        count = size;
+    }
+
+    corrupt_ctx_t ctx = {
+        .buffer = buffer,
+        .masks = { 0, 0 },
+        .record = detail != NULL,
+        .truncated = false,
+        .range_count = 0,
+        .recorded = 0
+    };
+    if (detail && !arena_reserve(count)) {
+        ctx.record = false;
+        ctx.truncated = true;
+    }
+
+    // Sparse: sample the positions themselves, memory proportional to count
+    if (count < size / SPARSE_LIMIT && size <= UINT32_MAX) {
+        if (!sparse_apply(&ctx, size, count)) {
+            LOG_ERROR("Corruption: no memory for %zu sampled positions", count);
+            selection_apply(&ctx, size, count);
+        }
+        detail_finish(&ctx, detail, count);
+        return count;
+    }
+
+    // Dense: mark positions in a bitmap. Above 50% mark the bytes to keep
+    // instead and invert, so rejection sampling stays cheap.
+    size_t words = (size + 63) / 64;
+    size_t bitmap_size = words * sizeof(uint64_t);
+    uint64_t *bitmap = buf_pool_get(bitmap_size);
+    if (!bitmap) {
+        LOG_ERROR("Corruption: no memory for %zu byte position bitmap", bitmap_size);
+        selection_apply(&ctx, size, count);
+        detail_finish(&ctx, detail, count);
+        return count;
+    }
+    memset(bitmap, 0, bitmap_size);
+
+    if (count <= size / 2) {
+        bitmap_sample(bitmap, size, count);
+    } else {
+        bitmap_sample(bitmap, size, size - count);
+        for (size_t w = 0; w < words; w++) {
+            bitmap[w] = ~bitmap[w];
+        }
+        if (size % 64) {
+            bitmap[words - 1] &= (1ULL << (size % 64)) - 1;
+        }
+    }
+
+    bitmap_apply(&ctx, bitmap, size);
+    buf_pool_put(bitmap, bitmap_size);
+    detail_finish(&ctx, detail, count);
+    return count;
+}
@@ -0,0 +1,29 @@
+#ifndef CORRUPTION_H
+#define CORRUPTION_H
+
+#include <stddef.h>
+#include "event_emitter.h"
+
+// Corruption kernel.
+//
+// Picks exactly `count` distinct byte positions uniformly at random and XORs
+// each chosen byte with a random non-zero mask, so every chosen byte really
+// changes. Positions are always produced in ascending order:
+//
+// - Sparse (under 1 byte in 32): Floyd's algorithm draws exactly `count`
+//   distinct positions from the thread's rng stream, using a small hash set
+//   for repeats; the positions are then bucket-sorted. O(count) time and
+//   memory.
+// - Dense: positions are marked in a bitmap (sampling the bytes to keep
+//   instead above 50%), which is then scanned in order, applying XOR masks
+//   16 bytes per vector operation.
+
+// Corrupt exactly min(count, size) distinct bytes of buffer. If detail is
+// not NULL, every corrupted byte is recorded in it as ascending ranges plus
+// the XOR mask applied to each byte; the arrays belong to the calling
+// thread and are reused by its next call. Returns the number of bytes
+// corrupted.
+size_t corruption_apply(unsigned char *buffer, size_t size, size_t count,
+                        corruption_detail_t *detail);
+
+#endif // CORRUPTION_H
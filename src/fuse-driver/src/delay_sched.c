@@ -0,0 +1,365 @@
+#include "delay_sched.h"
+#include "log.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DELAY_SCHED_INITIAL_CAPACITY 64
+
+// Threads that run expired callbacks (the backend step and the reply)
+#define DELAY_SCHED_WORKERS 4
+
+// One parked operation
+typedef struct {
+    uint64_t deadline_ns;    // CLOCK_MONOTONIC deadline
+    uint64_t seq;            // Submission order (ties run FIFO)
+    delay_sched_fn fn;
+    void *arg;
+} delay_entry_t;
+
+static pthread_mutex_t sched_mutex = PTHREAD_MUTEX_INITIALIZER;
+static delay_entry_t *heap = NULL;      // Min-heap on (deadline_ns, seq)
+static size_t heap_size = 0;
+static size_t heap_capacity = 0;
+static uint64_t next_seq = 0;
+
+// Expired entries waiting for a worker (ring buffer in deadline order)
+static pthread_cond_t ready_cond = PTHREAD_COND_INITIALIZER;
+static delay_entry_t *ready = NULL;
+static size_t ready_head = 0;
+static size_t ready_count = 0;
+static size_t ready_capacity = 0;
+static bool workers_stopping = false;
+static pthread_t workers[DELAY_SCHED_WORKERS];
+static size_t worker_count = 0;
+
+static int timer_fd = -1;
+static int wake_fd = -1;                // eventfd used to stop the thread
+static pthread_t sched_thread;
+static bool running = false;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline bool entry_before(const delay_entry_t *a, const delay_entry_t *b) {
+    return a->deadline_ns < b->deadline_ns ||
+           (a->deadline_ns == b->deadline_ns && a->seq < b->seq);
+}
+
+static void heap_push(const delay_entry_t *entry) {
+    size_t i = heap_size++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!entry_before(entry, &heap[parent])) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = *entry;
+}
+
+static delay_entry_t heap_pop(void) {
+    delay_entry_t top = heap[0];
+    delay_entry_t last = heap[--heap_size];
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= heap_size) {
+            break;
+        }
+        if (child + 1 < heap_size && entry_before(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!entry_before(&heap[child], &last)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (heap_size > 0) {
+        heap[i] = last;
+    }
+    return top;
+}
+
+// Arm the timer for the earliest deadline (disarm if nothing is pending).
+// Called with sched_mutex held.
+static void timer_rearm(void) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (heap_size > 0) {
+        uint64_t deadline = heap[0].deadline_ns;
+        if (deadline == 0) {
+            deadline = 1;  // 0 would disarm the timer
+        }
+        spec.it_value.tv_sec = (time_t)(deadline / 1000000000ULL);
+        spec.it_value.tv_nsec = (long)(deadline % 1000000000ULL);
+    }
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL) != 0) {
+        LOG_ERROR("Delay scheduler: timerfd_settime failed: %s", strerror(errno));
+    }
+}
+
+// Queue an entry for the workers (false if the queue cannot grow).
+// Called with sched_mutex held.
+static bool ready_push(const delay_entry_t *entry) {
+    if (ready_count == ready_capacity) {
+        size_t capacity = ready_capacity ? ready_capacity * 2 : DELAY_SCHED_INITIAL_CAPACITY;
+        delay_entry_t *grown = malloc(capacity * sizeof(delay_entry_t));
+        if (!grown) {
+            return false;
+        }
+        for (size_t i = 0; i < ready_count; i++) {
+            grown[i] = ready[(ready_head + i) % ready_capacity];
+        }
+        free(ready);
+        ready = grown;
+        ready_head = 0;
+        ready_capacity = capacity;
+    }
+    ready[(ready_head + ready_count++) % ready_capacity] = *entry;
+    return true;
+}
+
+// Hand every entry whose deadline has passed to the workers
+static void run_expired(void) {
+    pthread_mutex_lock(&sched_mutex);
+    uint64_t now = now_ns();
+    while (heap_size > 0 && heap[0].deadline_ns <= now) {
+        delay_entry_t entry = heap_pop();
+        if (!ready_push(&entry)) {
+            // Out of memory: finish this one here rather than lose its reply
+            LOG_ERROR("Delay scheduler: memory allocation failed, completing on the timer thread");
+            pthread_mutex_unlock(&sched_mutex);
+            entry.fn(entry.arg);
+            pthread_mutex_lock(&sched_mutex);
+            now = now_ns();
+            continue;
+        }
+        pthread_cond_signal(&ready_cond);
+    }
+    timer_rearm();
+    pthread_mutex_unlock(&sched_mutex);
+}
+
+// Worker: run expired callbacks until stopped and the queue is empty
+static void *worker_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&sched_mutex);
+    for (;;) {
+        while (ready_count == 0 && !workers_stopping) {
+            pthread_cond_wait(&ready_cond, &sched_mutex);
+        }
+        if (ready_count == 0) {
+            break;
+        }
+        delay_entry_t entry = ready[ready_head];
+        ready_head = (ready_head + 1) % ready_capacity;
+        ready_count--;
+        pthread_mutex_unlock(&sched_mutex);
+
+        entry.fn(entry.arg);
+
+        pthread_mutex_lock(&sched_mutex);
+    }
+    pthread_mutex_unlock(&sched_mutex);
+    return NULL;
+}
+
+// Let the workers drain the queue, then join them
+static void stop_workers(void) {
+    pthread_mutex_lock(&sched_mutex);
+    workers_stopping = true;
+    pthread_cond_broadcast(&ready_cond);
+    pthread_mutex_unlock(&sched_mutex);
+    for (size_t i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    worker_count = 0;
+
+    pthread_mutex_lock(&sched_mutex);
+    workers_stopping = false;
+    free(ready);
+    ready = NULL;
+    ready_head = ready_count = ready_capacity = 0;
+    pthread_mutex_unlock(&sched_mutex);
+}
+
+static void *sched_main(void *arg) {
+    (void)arg;
+    struct pollfd fds[2] = {
+        { .fd = timer_fd, .events = POLLIN },
+        { .fd = wake_fd, .events = POLLIN }
+    };
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Delay scheduler: poll failed: %s", strerror(errno));
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            uint64_t expirations;
+            if (read(timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+                LOG_ERROR("Delay scheduler: timerfd read failed: %s", strerror(errno));
+            }
+            run_expired();
+        }
+    }
+    return NULL;
+}
+
+// Start the scheduler thread
+int delay_sched_init(void) {
+    if (running) {
+        return 0;
+    }
+
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0) {
+        int err = errno;
+        LOG_ERROR("Delay scheduler: timerfd_create failed: %s", strerror(err));
+        return -err;
+    }
+
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) {
+        int err = errno;
+        LOG_ERROR("Delay scheduler: eventfd failed: %s", strerror(err));
+        close(timer_fd);
+        timer_fd = -1;
+        return -err;
+    }
+
+    int err = 0;
+    while (worker_count < DELAY_SCHED_WORKERS &&
+           (err = pthread_create(&workers[worker_count], NULL, worker_main, NULL)) == 0) {
+        worker_count++;
+    }
+    if (err == 0) {
+        err = pthread_create(&sched_thread, NULL, sched_main, NULL);
+    }
+    if (err != 0) {
+        LOG_ERROR("Delay scheduler: failed to start thread: %s", strerror(err));
+        stop_workers();
+        close(wake_fd);
+        close(timer_fd);
+        wake_fd = timer_fd = -1;
+        return -err;
+    }
+
+    pthread_mutex_lock(&sched_mutex);
+    running = true;
+    pthread_mutex_unlock(&sched_mutex);
+    LOG_INFO("Delay scheduler started (%d workers)", DELAY_SCHED_WORKERS);
+    return 0;
+}
+
+// Stop the scheduler thread, running whatever is still pending
+void delay_sched_cleanup(void) {
+    pthread_mutex_lock(&sched_mutex);
+    bool was_running = running;
+    running = false;
+    pthread_mutex_unlock(&sched_mutex);
+    if (!was_running) {
+        return;
+    }
+
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        LOG_ERROR("Delay scheduler: failed to wake thread: %s", strerror(errno));
+    }
+    pthread_join(sched_thread, NULL);
+
+    // No new submissions are accepted now; complete the parked operations
+    size_t flushed = 0;
+    pthread_mutex_lock(&sched_mutex);
+    while (heap_size > 0) {
+        delay_entry_t entry = heap_pop();
+        if (ready_push(&entry)) {
+            pthread_cond_signal(&ready_cond);
+        } else {
+            pthread_mutex_unlock(&sched_mutex);
+            entry.fn(entry.arg);
+            pthread_mutex_lock(&sched_mutex);
+        }
+        flushed++;
+    }
+    free(heap);
+    heap = NULL;
+    heap_capacity = 0;
+    pthread_mutex_unlock(&sched_mutex);
+    stop_workers();
+
+    close(wake_fd);
+    close(timer_fd);
+    wake_fd = timer_fd = -1;
+    LOG_INFO("Delay scheduler stopped (%zu pending operations completed early)", flushed);
+}
+
+// Park fn(arg) until delay_ms milliseconds from now
+int delay_sched_submit(unsigned int delay_ms, delay_sched_fn fn, void *arg) {
+    delay_entry_t entry = {
+        .deadline_ns = now_ns() + (uint64_t)delay_ms * 1000000ULL,
+        .fn = fn,
+        .arg = arg
+    };
+
+    pthread_mutex_lock(&sched_mutex);
+    if (!running) {
+        pthread_mutex_unlock(&sched_mutex);
+        return -ESHUTDOWN;
+    }
+
+    if (heap_size == heap_capacity) {
+        size_t capacity = heap_capacity ? heap_capacity * 2 : DELAY_SCHED_INITIAL_CAPACITY;
+        delay_entry_t *grown = realloc(heap, capacity * sizeof(delay_entry_t));
+        if (!grown) {
+            pthread_mutex_unlock(&sched_mutex);
+            LOG_ERROR("Delay scheduler: memory allocation failed");
+            return -ENOMEM;
+        }
+        heap = grown;
+        heap_capacity = capacity;
+    }
+
+    entry.seq = next_seq++;
+    heap_push(&entry);
+    if (heap[0].seq == entry.seq) {
+        timer_rearm();  // New earliest deadline
+    }
+    pthread_mutex_unlock(&sched_mutex);
+    return 0;
+}
+
+// Is the scheduler running?
+bool delay_sched_running(void) {
+    pthread_mutex_lock(&sched_mutex);
+    bool result = running;
+    pthread_mutex_unlock(&sched_mutex);
+    return result;
+}
+
+// Number of operations currently parked
+size_t delay_sched_pending(void) {
+    pthread_mutex_lock(&sched_mutex);
+    size_t pending = heap_size + ready_count;
+    pthread_mutex_unlock(&sched_mutex);
+    return pending;
+}
@@ -0,0 +1,40 @@
+#ifndef DELAY_SCHED_H
+#define DELAY_SCHED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Deferred completion scheduler for delay faults.
+//
+// Instead of sleeping in a FUSE worker thread, a delayed operation is parked
+// here with a callback that finishes it (runs the backend operation and sends
+// the reply). A single timer thread keeps pending entries in a min-heap
+// ordered by deadline and waits on a timerfd armed for the earliest one, so
+// any number of delayed operations costs memory, not threads.
+//
+// Expired entries are handed to a small pool of worker threads, so a slow
+// backend step delays neither the timer nor the other expired callbacks.
+// Callbacks start in deadline order (submission order for equal deadlines)
+// but may run concurrently.
+
+typedef void (*delay_sched_fn)(void *arg);
+
+// Start the timer and worker threads (0 on success, negative errno on failure)
+int delay_sched_init(void);
+
+// Stop the scheduler threads. Pending callbacks run immediately and are
+// waited for, so every parked operation still gets its reply.
+void delay_sched_cleanup(void);
+
+// Run fn(arg) after delay_ms milliseconds. Returns 0 on success or a
+// negative errno (-ENOMEM, -ESHUTDOWN); on failure fn is NOT called and the
+// caller must complete the operation itself.
+int delay_sched_submit(unsigned int delay_ms, delay_sched_fn fn, void *arg);
+
+// Is the scheduler running (deferred delays available)?
+bool delay_sched_running(void);
+
+// Number of operations currently parked
+size_t delay_sched_pending(void);
+
+#endif // DELAY_SCHED_H
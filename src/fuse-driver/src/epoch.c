@@ -0,0 +1,125 @@
+#include "epoch.h"
+#include "log.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+// One thread's announcement, on a cache line of its own
+typedef struct epoch_record {
+    _Alignas(64) _Atomic uint64_t epoch;  // Epoch of the open section (0 = none)
+    atomic_bool in_use;                   // Owned by a live thread
+    struct epoch_record *next;            // Records are never freed, only reused
+} epoch_record_t;
+
+// Current epoch (starts at 1 so 0 can mean "outside")
+static _Atomic uint64_t global_epoch = 1;
+
+// Every record ever registered
+static _Atomic(epoch_record_t *) records;
+
+// Readers that could not get a record (out of memory): hold back all
+// reclamation while any is inside
+static atomic_uint unregistered_readers;
+
+static pthread_key_t record_key;
+static pthread_once_t record_key_once = PTHREAD_ONCE_INIT;
+
+static __thread epoch_record_t *local_record;
+static __thread unsigned int local_depth;
+static __thread bool local_unregistered;
+
+// Thread exit: hand the record to the next new thread
+static void release_record(void *arg) {
+    epoch_record_t *record = arg;
+    atomic_store_explicit(&record->epoch, 0, memory_order_release);
+    atomic_store_explicit(&record->in_use, false, memory_order_release);
+}
+
+static void create_record_key(void) {
+    if (pthread_key_create(&record_key, release_record) != 0) {
+        LOG_ERROR("Epoch: cannot create thread key, records of exited threads are not reused");
+    }
+}
+
+// Claim a free record or register a new one (NULL on allocation failure)
+static epoch_record_t *acquire_record(void) {
+    pthread_once(&record_key_once, create_record_key);
+
+    epoch_record_t *record;
+    for (record = atomic_load(&records); record; record = record->next) {
+        bool expected = false;
+        if (!atomic_load_explicit(&record->in_use, memory_order_relaxed) &&
+            atomic_compare_exchange_strong(&record->in_use, &expected, true)) {
+            break;
+        }
+    }
+
+    if (!record) {
+        record = aligned_alloc(_Alignof(epoch_record_t), sizeof(epoch_record_t));
+        if (!record) {
+            LOG_ERROR("Epoch: memory allocation failed");
+            return NULL;
+        }
+        atomic_init(&record->epoch, 0);
+        atomic_init(&record->in_use, true);
+        record->next = atomic_load(&records);
+        while (!atomic_compare_exchange_weak(&records, &record->next, record)) {
+        }
+    }
+
+    pthread_setspecific(record_key, record);
+    return record;
+}
+
+// Enter a read-side section
+void epoch_enter(void) {
+    if (local_depth++ > 0) {
+        return;
+    }
+    if (!local_record && !(local_record = acquire_record())) {
+        local_unregistered = true;
+        atomic_fetch_add(&unregistered_readers, 1);
+        return;
+    }
+
+    // The announcement must be visible before the section reads the shared
+    // pointer, or a writer could miss it and free what the read returns
+    atomic_store_explicit(&local_record->epoch, atomic_load(&global_epoch),
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+// Leave a read-side section
+void epoch_exit(void) {
+    if (--local_depth > 0) {
+        return;
+    }
+    if (local_unregistered) {
+        local_unregistered = false;
+        atomic_fetch_sub(&unregistered_readers, 1);
+        return;
+    }
+    atomic_store_explicit(&local_record->epoch, 0, memory_order_release);
+}
+
+// Start a new epoch
+uint64_t epoch_advance(void) {
+    uint64_t epoch = atomic_fetch_add(&global_epoch, 1) + 1;
+    atomic_thread_fence(memory_order_seq_cst);
+    return epoch;
+}
+
+// Has every reader left the sections entered before epoch?
+bool epoch_passed(uint64_t epoch) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&unregistered_readers) > 0) {
+        return false;
+    }
+    for (epoch_record_t *record = atomic_load(&records); record; record = record->next) {
+        uint64_t entered = atomic_load_explicit(&record->epoch, memory_order_acquire);
+        if (entered != 0 && entered < epoch) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Epoch-based reclamation for data read without locks.
+//
+// Readers bracket every use of a shared pointer with epoch_enter() and
+// epoch_exit(); each thread announces the global epoch it entered in a
+// record of its own, so readers never write a shared line or take a lock.
+// A writer that replaces a pointer calls epoch_advance() and may free the
+// old object once epoch_passed() reports that no reader is still inside a
+// section it entered before the replacement.
+//
+// Sections nest (only the outermost one counts) and must not block for
+// long: reclamation waits for them.
+
+// Enter a read-side section on this thread
+void epoch_enter(void);
+
+// Leave the section entered by the matching epoch_enter()
+void epoch_exit(void);
+
+// Start a new epoch and return it. Objects unpublished before this call
+// can be freed once epoch_passed() returns true for the returned value.
+uint64_t epoch_advance(void);
+
+// No reader is inside a section entered before `epoch`
+bool epoch_passed(uint64_t epoch);
+
+#endif // EPOCH_H
@@ -1,6 +1,11 @@
+#define _GNU_SOURCE  /* sendmmsg */
+
 #include "event_emitter.h"
 #include "log.h"
 #include "config.h"
+#include "event_ring.h"
+#include "trace.h"
+#include "rng.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -9,17 +14,100 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 
+// Max datagram size (stay well under kernel limit)
+#define MAX_EVENT_SIZE 4096
+
+// Batching: a thread's staged events are sent once EVENT_BATCH_MAX of them
+// are waiting or the oldest has waited EVENT_FLUSH_NS, whichever comes first
+#define EVENT_BATCH_MAX   64
+#define EVENT_STAGE_BYTES (64 * 1024)
+#define EVENT_FLUSH_NS    (1000 * 1000ULL)
+
+// Idle flusher re-check interval (bounds the latency of a missed wakeup)
+#define EVENT_IDLE_NS     (100 * 1000 * 1000ULL)
+
+// Suppression summaries: at most one per EVENT_SUMMARY_NS, looking at the
+// clock on every rate-limited event and every EVENT_SUMMARY_CHECK-th
+// sampled-out one (sampling does not read the clock otherwise)
+#define EVENT_SUMMARY_NS    (1000 * 1000 * 1000ULL)
+#define EVENT_SUMMARY_CHECK 64
+
+// Per-thread staging buffer of encoded events. The owning thread appends and
+// the flusher takes the contents, both under the (normally uncontended)
+// stage mutex.
+typedef struct event_stage {
+    pthread_mutex_t mutex;
+    size_t count;
+    size_t used;                          // Bytes of data in use
+    uint64_t ts_ns[EVENT_BATCH_MAX];      // Staging time (flush order across threads)
+    uint32_t offset[EVENT_BATCH_MAX];
+    uint32_t len[EVENT_BATCH_MAX];
+    bool orphaned;                        // Owning thread has exited
+    struct event_stage *next;
+    char data[EVENT_STAGE_BYTES];
+} event_stage_t;
+
+// Events collected by one flush, in send order
+typedef struct {
+    uint64_t ts_ns;
+    size_t offset;
+    uint32_t len;
+} flush_entry_t;
+
+// Emission limits for one event class. The token bucket is kept in GCRA
+// form: a single "theoretical arrival time" that each admitted event pushes
+// forward by one interval, so admission is one CAS and needs no refill timer.
+typedef struct {
+    uint64_t sample_threshold;         // Emit if a 64-bit draw is below this
+    bool sample_all;
+    uint64_t interval_ns;              // 1 s / rate_limit (0 = unlimited)
+    uint64_t tolerance_ns;             // (burst - 1) intervals
+    _Atomic uint64_t tat_ns;           // Theoretical arrival time (CLOCK_MONOTONIC)
+    atomic_size_t sampled_out;         // Suppressed by sampling
+    atomic_size_t rate_limited;        // Suppressed by the token bucket
+} event_limiter_t;
+
+static const char *event_class_names[EVENT_CLASS_COUNT] = { "data", "metadata" };
+
 // Socket state
 static int emit_fd = -1;
 static struct sockaddr_un dest_addr;
-static size_t events_dropped = 0;
+static atomic_size_t events_dropped = 0;
 static bool initialized = false;
 
-// Max datagram size (stay well under kernel limit)
-#define MAX_EVENT_SIZE 4096
+static event_limiter_t limiters[EVENT_CLASS_COUNT];
+
+// Time of the last suppression summary (CLOCK_MONOTONIC, 0 = none yet)
+static _Atomic uint64_t summary_ns = 0;
+
+// Stage registry (stages_mutex)
+static pthread_mutex_t stages_mutex = PTHREAD_MUTEX_INITIALIZER;
+static event_stage_t *stages = NULL;
+static pthread_key_t stage_key;
+static pthread_once_t stage_key_once = PTHREAD_ONCE_INIT;
+static __thread event_stage_t *tls_stage = NULL;
+
+// Flusher thread (flush_mutex)
+static pthread_mutex_t flush_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flush_cond;
+static pthread_t flush_thread;
+static atomic_bool flusher_running = false;
+static bool flusher_stop = false;
+static atomic_bool flush_pending = false;  // Some stage holds events
+static uint64_t pending_since_ns = 0;
+static bool flush_urgent = false;          // Some stage reached EVENT_BATCH_MAX
+
+// Flush scratch space, owned by whoever holds drain_mutex
+static pthread_mutex_t drain_mutex = PTHREAD_MUTEX_INITIALIZER;
+static flush_entry_t *flush_entries = NULL;
+static size_t flush_entries_cap = 0;
+static char *flush_data = NULL;
+static size_t flush_data_cap = 0;
 
 // Get current time as epoch milliseconds
 static uint64_t now_ms(void) {
@@ -28,41 +116,414 @@ static uint64_t now_ms(void) {
     return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
 }
 
-// Send a buffer to the socket (non-blocking, silently drops on failure)
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Count a lost event
+static void count_dropped(void) {
+    size_t dropped = atomic_fetch_add_explicit(&events_dropped, 1, memory_order_relaxed) + 1;
+    if (dropped % 1000 == 1) {
+        LOG_DEBUG("Event emitter: %zu events dropped (last errno: %d)", dropped, errno);
+    }
+}
+
+// Set up the limiter of one event class from its configuration
+static void limiter_init(event_limiter_t *limiter, const event_limit_t *limit) {
+    limiter->sample_all = limit->sample_rate >= 1.0;
+    limiter->sample_threshold = limit->sample_rate > 0.0 && limit->sample_rate < 1.0
+        ? (uint64_t)(limit->sample_rate * 18446744073709551616.0) : 0;
+    limiter->interval_ns = 0;
+    limiter->tolerance_ns = 0;
+    if (limit->rate_limit > 0.0) {
+        double burst = limit->rate_burst > 0.0 ? limit->rate_burst : limit->rate_limit;
+        if (burst < 1.0) burst = 1.0;
+        limiter->interval_ns = (uint64_t)(1e9 / limit->rate_limit);
+        if (limiter->interval_ns == 0) limiter->interval_ns = 1;
+        limiter->tolerance_ns = (uint64_t)((burst - 1.0) * (double)limiter->interval_ns);
+    }
+    atomic_store(&limiter->tat_ns, 0);
+    atomic_store(&limiter->sampled_out, 0);
+    atomic_store(&limiter->rate_limited, 0);
+}
+
+static void emit_summary(void);
+
+// Count a suppressed event; emit a summary if the last one is old enough
+// (now = 0: clock not read yet)
+static void count_suppressed(atomic_size_t *counter, uint64_t now) {
+    size_t count = atomic_fetch_add_explicit(counter, 1, memory_order_relaxed) + 1;
+    if (now == 0) {
+        if (count % EVENT_SUMMARY_CHECK != 0) {
+            return;
+        }
+        now = mono_ns();
+    }
+    uint64_t last = atomic_load_explicit(&summary_ns, memory_order_relaxed);
+    if ((last == 0 || now - last >= EVENT_SUMMARY_NS) &&
+        atomic_compare_exchange_strong_explicit(&summary_ns, &last, now,
+                                                memory_order_relaxed, memory_order_relaxed)) {
+        emit_summary();
+    }
+}
+
+// Sampling, then the token bucket. Suppressed events are counted per class.
+// Sampling draws come from the thread's side stream (rng.h): the seed
+// reproduces them, and changing a sample rate does not shift the fault
+// decisions of a seeded run.
+static bool limiter_admit(event_limiter_t *limiter) {
+    if (!limiter->sample_all && rng_next_side() >= limiter->sample_threshold) {
+        count_suppressed(&limiter->sampled_out, 0);
+        return false;
+    }
+    if (limiter->interval_ns == 0) {
+        return true;
+    }
+
+    uint64_t now = mono_ns();
+    uint64_t tat = atomic_load_explicit(&limiter->tat_ns, memory_order_relaxed);
+    uint64_t next;
+    do {
+        uint64_t start = tat > now ? tat : now;
+        if (start - now > limiter->tolerance_ns) {
+            count_suppressed(&limiter->rate_limited, now);
+            return false;
+        }
+        next = start + limiter->interval_ns;
+    } while (!atomic_compare_exchange_weak_explicit(&limiter->tat_ns, &tat, next,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    return true;
+}
+
+// Send datagrams with as few sendmmsg() calls as possible. A datagram the
+// socket refuses is dropped and counted, the rest are still attempted.
+static void send_batch(struct iovec *iov, size_t count) {
+    struct mmsghdr msgs[EVENT_BATCH_MAX];
+
+    for (size_t base = 0; base < count; base += EVENT_BATCH_MAX) {
+        size_t n = count - base < EVENT_BATCH_MAX ? count - base : EVENT_BATCH_MAX;
+        for (size_t i = 0; i < n; i++) {
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_name = &dest_addr;
+            msgs[i].msg_hdr.msg_namelen = sizeof(dest_addr);
+            msgs[i].msg_hdr.msg_iov = &iov[base + i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        size_t done = 0;
+        while (done < n) {
+            int sent = sendmmsg(emit_fd, msgs + done, (unsigned int)(n - done), 0);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                TRACE2(event_send, iov[base + done].iov_len, 0);
+                count_dropped();
+                done++;
+                continue;
+            }
+            for (int i = 0; i < sent; i++) {
+                TRACE2(event_send, iov[base + done + i].iov_len, 1);
+            }
+            done += (size_t)sent;
+        }
+    }
+}
+
+// Send a stage's events directly (no flush scratch space available).
+// Called with drain_mutex and the stage mutex held.
+static void stage_send_locked(event_stage_t *stage) {
+    struct iovec iov[EVENT_BATCH_MAX];
+    for (size_t i = 0; i < stage->count; i++) {
+        iov[i].iov_base = stage->data + stage->offset[i];
+        iov[i].iov_len = stage->len[i];
+    }
+    send_batch(iov, stage->count);
+    stage->count = 0;
+    stage->used = 0;
+}
+
+// Thread exit: the flusher frees the stage once it is empty
+static void stage_release(void *arg) {
+    pthread_mutex_lock(&stages_mutex);
+    for (event_stage_t *stage = stages; stage; stage = stage->next) {
+        if (stage == arg) {
+            stage->orphaned = true;  // Still registered (not freed by cleanup)
+            break;
+        }
+    }
+    pthread_mutex_unlock(&stages_mutex);
+}
+
+static void stage_key_create(void) {
+    pthread_key_create(&stage_key, stage_release);
+}
+
+// The calling thread's stage (created on first use)
+static event_stage_t *stage_get(void) {
+    if (tls_stage) {
+        return tls_stage;
+    }
+
+    pthread_once(&stage_key_once, stage_key_create);
+    event_stage_t *stage = malloc(sizeof(event_stage_t));
+    if (!stage) {
+        return NULL;
+    }
+    pthread_mutex_init(&stage->mutex, NULL);
+    stage->count = 0;
+    stage->used = 0;
+    stage->orphaned = false;
+
+    pthread_mutex_lock(&stages_mutex);
+    stage->next = stages;
+    stages = stage;
+    pthread_mutex_unlock(&stages_mutex);
+
+    pthread_setspecific(stage_key, stage);
+    tls_stage = stage;
+    return stage;
+}
+
+// Tell the flusher a stage has events (first = batch just started,
+// full = batch size reached)
+static void flusher_notify(bool first, bool full) {
+    if (full) {
+        pthread_mutex_lock(&flush_mutex);
+        flush_urgent = true;
+        pthread_cond_signal(&flush_cond);
+        pthread_mutex_unlock(&flush_mutex);
+    } else if (first && !atomic_load(&flush_pending)) {
+        pthread_mutex_lock(&flush_mutex);
+        if (!atomic_load(&flush_pending)) {
+            atomic_store(&flush_pending, true);
+            pending_since_ns = mono_ns();
+            pthread_cond_signal(&flush_cond);
+        }
+        pthread_mutex_unlock(&flush_mutex);
+    }
+}
+
+static int flush_entry_cmp(const void *a, const void *b) {
+    const flush_entry_t *x = a;
+    const flush_entry_t *y = b;
+    if (x->ts_ns != y->ts_ns) {
+        return x->ts_ns < y->ts_ns ? -1 : 1;
+    }
+    return x->offset < y->offset ? -1 : (x->offset > y->offset);
+}
+
+// Grow the flush scratch space. Called with drain_mutex held.
+static bool flush_reserve(size_t entries, size_t bytes) {
+    if (entries > flush_entries_cap) {
+        size_t cap = flush_entries_cap ? flush_entries_cap : EVENT_BATCH_MAX;
+        while (cap < entries) cap *= 2;
+        flush_entry_t *grown = realloc(flush_entries, cap * sizeof(flush_entry_t));
+        if (!grown) return false;
+        flush_entries = grown;
+        flush_entries_cap = cap;
+    }
+    if (bytes > flush_data_cap) {
+        size_t cap = flush_data_cap ? flush_data_cap : EVENT_STAGE_BYTES;
+        while (cap < bytes) cap *= 2;
+        char *grown = realloc(flush_data, cap);
+        if (!grown) return false;
+        flush_data = grown;
+        flush_data_cap = cap;
+    }
+    return true;
+}
+
+// Take every stage's events and send them in staging order
+static void flush_all(void) {
+    pthread_mutex_lock(&drain_mutex);
+    pthread_mutex_lock(&stages_mutex);
+
+    size_t count = 0;
+    size_t used = 0;
+    event_stage_t **link = &stages;
+    while (*link) {
+        event_stage_t *stage = *link;
+        pthread_mutex_lock(&stage->mutex);
+        if (stage->count > 0 && flush_reserve(count + stage->count, used + stage->used)) {
+            memcpy(flush_data + used, stage->data, stage->used);
+            for (size_t i = 0; i < stage->count; i++) {
+                flush_entries[count + i].ts_ns = stage->ts_ns[i];
+                flush_entries[count + i].offset = used + stage->offset[i];
+                flush_entries[count + i].len = stage->len[i];
+            }
+            count += stage->count;
+            used += stage->used;
+        } else if (stage->count > 0) {
+            // No scratch space: send from the stage itself
+            stage_send_locked(stage);
+        }
+        stage->count = 0;
+        stage->used = 0;
+        bool unused = stage->orphaned;
+        pthread_mutex_unlock(&stage->mutex);
+
+        if (unused) {
+            *link = stage->next;
+            pthread_mutex_destroy(&stage->mutex);
+            free(stage);
+        } else {
+            link = &stage->next;
+        }
+    }
+    pthread_mutex_unlock(&stages_mutex);
+
+    if (count > 0) {
+        qsort(flush_entries, count, sizeof(flush_entry_t), flush_entry_cmp);
+
+        struct iovec iov[EVENT_BATCH_MAX];
+        for (size_t base = 0; base < count; base += EVENT_BATCH_MAX) {
+            size_t n = count - base < EVENT_BATCH_MAX ? count - base : EVENT_BATCH_MAX;
+            for (size_t i = 0; i < n; i++) {
+                iov[i].iov_base = flush_data + flush_entries[base + i].offset;
+                iov[i].iov_len = flush_entries[base + i].len;
+            }
+            send_batch(iov, n);
+        }
+    }
+    pthread_mutex_unlock(&drain_mutex);
+}
+
+// Stage an encoded event for the flusher
+static bool stage_event(const char *buf, size_t len) {
+    event_stage_t *stage = stage_get();
+    if (!stage) {
+        return false;
+    }
+
+    pthread_mutex_lock(&stage->mutex);
+    while (stage->count == EVENT_BATCH_MAX || stage->used + len > EVENT_STAGE_BYTES) {
+        // The flusher has not caught up: flush from this thread. Going
+        // through flush_all() keeps the send order, since the flusher may
+        // still be sending older events it already took.
+        pthread_mutex_unlock(&stage->mutex);
+        flush_all();
+        pthread_mutex_lock(&stage->mutex);
+    }
+    size_t index = stage->count++;
+    stage->ts_ns[index] = mono_ns();
+    stage->offset[index] = (uint32_t)stage->used;
+    stage->len[index] = (uint32_t)len;
+    memcpy(stage->data + stage->used, buf, len);
+    stage->used += len;
+    pthread_mutex_unlock(&stage->mutex);
+
+    flusher_notify(index == 0, index + 1 == EVENT_BATCH_MAX);
+    return true;
+}
+
+static void *flusher_main(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&flush_mutex);
+    while (!flusher_stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        uint64_t wait_ns = EVENT_IDLE_NS;
+        if (!flush_urgent && atomic_load(&flush_pending)) {
+            uint64_t age = mono_ns() - pending_since_ns;
+            wait_ns = age < EVENT_FLUSH_NS ? EVENT_FLUSH_NS - age : 0;
+        }
+        if (!flush_urgent && wait_ns > 0) {
+            uint64_t ns = (uint64_t)deadline.tv_nsec + wait_ns;
+            deadline.tv_sec += (time_t)(ns / 1000000000ULL);
+            deadline.tv_nsec = (long)(ns % 1000000000ULL);
+            int res = pthread_cond_timedwait(&flush_cond, &flush_mutex, &deadline);
+            if (res == 0 && !flush_urgent && !flusher_stop) {
+                continue;  // New batch started or spurious wakeup: recompute the deadline
+            }
+        }
+
+        atomic_store(&flush_pending, false);
+        flush_urgent = false;
+        pthread_mutex_unlock(&flush_mutex);
+        flush_all();
+        pthread_mutex_lock(&flush_mutex);
+    }
+    pthread_mutex_unlock(&flush_mutex);
+    return NULL;
+}
+
+// Send a buffer to the socket (non-blocking, silently drops on failure).
+// Events are staged for the flusher thread when it runs, or go straight
+// into the shared-memory ring when that transport is configured.
 static void emit_send(const char *buf, size_t len) {
-    if (!initialized || emit_fd < 0) return;
+    if (!initialized) return;
 
     fs_config_t *config = config_get_global();
     if (!config->event_emission_enabled) return;
 
+    if (event_ring_active()) {
+        bool written = event_ring_write(buf, len);
+        TRACE2(event_send, len, written);
+        if (!written) {
+            count_dropped();
+        }
+        return;
+    }
+    if (emit_fd < 0) return;
+
+    if (atomic_load_explicit(&flusher_running, memory_order_acquire) && stage_event(buf, len)) {
+        return;
+    }
+
     ssize_t sent = sendto(emit_fd, buf, len, 0,
                           (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+    TRACE2(event_send, len, sent >= 0);
     if (sent < 0) {
-        events_dropped++;
-        if (events_dropped % 1000 == 1) {
-            LOG_DEBUG("Event emitter: %zu events dropped (last errno: %d)",
-                      events_dropped, errno);
-        }
+        count_dropped();
     }
 }
 
-// Check if an operation should be emitted
+// Check if an operation should be emitted (fault events bypass this)
 static bool should_emit(fs_op_type_t op) {
     fs_config_t *config = config_get_global();
     if (!config->event_emission_enabled) return false;
 
-    // Always emit data operations and faults
+    // Data operations are always candidates
     if (op == FS_OP_READ || op == FS_OP_WRITE || op == FS_OP_CREATE ||
         op == FS_OP_TRUNCATE || op == FS_OP_UNLINK || op == FS_OP_RENAME ||
-        op == FS_OP_MKNOD) {
-        return true;
+        op == FS_OP_MKNOD || op == FS_OP_COPY_FILE_RANGE || op == FS_OP_FALLOCATE) {
+        return limiter_admit(&limiters[EVENT_CLASS_DATA]);
     }
 
     // Metadata ops only if configured
-    return config->emit_metadata_ops;
+    return config->emit_metadata_ops && limiter_admit(&limiters[EVENT_CLASS_METADATA]);
 }
 
 void event_emitter_init(const char *socket_path) {
+    fs_config_t *config = config_get_global();
+    for (int i = 0; i < EVENT_CLASS_COUNT; i++) {
+        const event_limit_t *limit = &config->event_limits[i];
+        limiter_init(&limiters[i], limit);
+        if (limit->sample_rate < 1.0) {
+            LOG_INFO("Event emitter: sampling %s events at %.3f",
+                     event_class_names[i], limit->sample_rate);
+        }
+        if (limit->rate_limit > 0.0) {
+            LOG_INFO("Event emitter: %s events limited to %.1f/s (burst %.0f)",
+                     event_class_names[i], limit->rate_limit,
+                     limit->rate_burst > 0.0 ? limit->rate_burst : limit->rate_limit);
+        }
+    }
+
+    if (config->event_shm_path) {
+        if (event_ring_create(config->event_shm_path, config->event_shm_size) == 0) {
+            initialized = true;
+            atomic_store(&events_dropped, 0);
+            LOG_INFO("Event emitter initialized (ring: %s)", config->event_shm_path);
+            return;
+        }
+        LOG_WARN("Event emitter: falling back to socket");
+    }
+
     if (!socket_path) socket_path = EVENT_SOCKET_PATH_DEFAULT;
 
     emit_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
@@ -81,18 +542,148 @@ void event_emitter_init(const char *socket_path) {
     strncpy(dest_addr.sun_path, socket_path, sizeof(dest_addr.sun_path) - 1);
 
     initialized = true;
-    events_dropped = 0;
+    atomic_store(&events_dropped, 0);
 
     LOG_INFO("Event emitter initialized (socket: %s)", socket_path);
 }
 
+// Start the flusher thread (the ring needs none)
+int event_emitter_start(void) {
+    if (!initialized || event_ring_active() || atomic_load(&flusher_running)) {
+        return 0;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&flush_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    flusher_stop = false;
+    int err = pthread_create(&flush_thread, NULL, flusher_main, NULL);
+    if (err != 0) {
+        LOG_ERROR("Event emitter: failed to start flusher thread: %s", strerror(err));
+        pthread_cond_destroy(&flush_cond);
+        return -err;
+    }
+    atomic_store_explicit(&flusher_running, true, memory_order_release);
+    LOG_INFO("Event emitter: batching up to %d events or %llu us per flush",
+             EVENT_BATCH_MAX, (unsigned long long)(EVENT_FLUSH_NS / 1000));
+    return 0;
+}
+
 void event_emitter_cleanup(void) {
+    // Final totals for consumers that track the summaries
+    if (atomic_load(&summary_ns) != 0) {
+        emit_summary();
+    }
+
+    if (atomic_exchange(&flusher_running, false)) {
+        pthread_mutex_lock(&flush_mutex);
+        flusher_stop = true;
+        pthread_cond_signal(&flush_cond);
+        pthread_mutex_unlock(&flush_mutex);
+        pthread_join(flush_thread, NULL);
+        pthread_cond_destroy(&flush_cond);
+    }
+
+    // Send whatever is still staged, then free the stages
+    if (emit_fd >= 0) {
+        flush_all();
+    }
+    pthread_mutex_lock(&stages_mutex);
+    while (stages) {
+        event_stage_t *stage = stages;
+        stages = stage->next;
+        pthread_mutex_destroy(&stage->mutex);
+        free(stage);
+    }
+    pthread_mutex_unlock(&stages_mutex);
+    tls_stage = NULL;
+
+    pthread_mutex_lock(&drain_mutex);
+    free(flush_entries);
+    free(flush_data);
+    flush_entries = NULL;
+    flush_data = NULL;
+    flush_entries_cap = flush_data_cap = 0;
+    pthread_mutex_unlock(&drain_mutex);
+
     if (emit_fd >= 0) {
         close(emit_fd);
         emit_fd = -1;
     }
+    event_ring_destroy();
     initialized = false;
-    LOG_INFO("Event emitter cleanup (dropped: %zu)", events_dropped);
+    atomic_store(&summary_ns, 0);
+    LOG_INFO("Event emitter cleanup (dropped: %zu)", atomic_load(&events_dropped));
+    for (int i = 0; i < EVENT_CLASS_COUNT; i++) {
+        size_t sampled_out = atomic_load(&limiters[i].sampled_out);
+        size_t rate_limited = atomic_load(&limiters[i].rate_limited);
+        if (sampled_out > 0 || rate_limited > 0) {
+            LOG_INFO("  %s events suppressed: %zu by sampling, %zu by rate limit",
+                     event_class_names[i], sampled_out, rate_limited);
+        }
+    }
+}
+
+// Copy a path into a JSON string body, escaping quotes, backslashes and
+// control characters. Returns the length written (output is NUL-terminated).
+static size_t json_escape(char *out, size_t size, const char *path) {
+    static const char hex[] = "0123456789abcdef";
+    size_t pos = 0;
+
+    for (const unsigned char *p = (const unsigned char *)(path ? path : ""); *p; p++) {
+        size_t need = (*p == '"' || *p == '\\') ? 2 : (*p < 0x20 ? 6 : 1);
+        if (pos + need >= size) {
+            break;
+        }
+        if (need == 2) {
+            out[pos++] = '\\';
+            out[pos++] = (char)*p;
+        } else if (need == 6) {
+            memcpy(out + pos, "\\u00", 4);
+            out[pos + 4] = hex[*p >> 4];
+            out[pos + 5] = hex[*p & 0xf];
+            pos += 6;
+        } else {
+            out[pos++] = (char)*p;
+        }
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+// Encode the fixed binary header and the path. Returns the record length so
+// far, or 0 if the record does not fit (cannot happen with MAX_EVENT_SIZE).
+static size_t wire_header(char *buf, uint8_t kind, fs_op_type_t op, uint8_t fault,
+                          uint8_t flags, const char *path, off_t offset, size_t size,
+                          int32_t result, uint32_t corr_count, uint64_t ts) {
+    size_t path_len = path ? strlen(path) : 0;
+    if (path_len > MAX_EVENT_SIZE / 2) {
+        path_len = MAX_EVENT_SIZE / 2;  // Leaves room for corruption ranges
+    }
+
+    int64_t off = (int64_t)offset;
+    uint64_t sz = (uint64_t)size;
+    uint16_t plen = (uint16_t)path_len;
+
+    buf[0] = EVENT_WIRE_VERSION;
+    buf[1] = (char)kind;
+    buf[2] = (char)op;
+    buf[3] = (char)fault;
+    buf[4] = (char)flags;
+    buf[5] = 0;
+    memcpy(buf + 6, &plen, 2);
+    memcpy(buf + 8, &ts, 8);
+    memcpy(buf + 16, &off, 8);
+    memcpy(buf + 24, &sz, 8);
+    memcpy(buf + 32, &result, 4);
+    memcpy(buf + 36, &corr_count, 4);
+    if (path_len > 0) {
+        memcpy(buf + EVENT_WIRE_HEADER_SIZE, path, path_len);
+    }
+    return EVENT_WIRE_HEADER_SIZE + path_len;
 }
 
 void event_emit_op(fs_op_type_t op, const char *path,
@@ -100,18 +691,27 @@ void event_emit_op(fs_op_type_t op, const char *path,
     if (!should_emit(op)) return;
 
     char buf[MAX_EVENT_SIZE];
-    int len = snprintf(buf, sizeof(buf),
-        "{\"ts\":%llu,\"op\":\"%s\",\"path\":\"%s\","
-        "\"off\":%lld,\"sz\":%zu,\"res\":%d,\"fault\":null}",
-        (unsigned long long)now_ms(),
-        fs_op_names[op],
-        path ? path : "",
-        (long long)offset,
-        size,
-        result);
+    size_t len;
+    if (config_get_global()->event_binary) {
+        len = wire_header(buf, EVENT_KIND_OP, op, EVENT_WIRE_NO_FAULT, 0,
+                          path, offset, size, result, 0, now_ms());
+    } else {
+        char escaped[MAX_EVENT_SIZE / 2];
+        json_escape(escaped, sizeof(escaped), path);
+        int n = snprintf(buf, sizeof(buf),
+            "{\"ts\":%llu,\"op\":\"%s\",\"path\":\"%s\","
+            "\"off\":%lld,\"sz\":%zu,\"res\":%d,\"fault\":null}",
+            (unsigned long long)now_ms(),
+            fs_op_names[op],
+            escaped,
+            (long long)offset,
+            size,
+            result);
+        len = (n > 0 && (size_t)n < sizeof(buf)) ? (size_t)n : 0;
+    }
 
-    if (len > 0 && (size_t)len < sizeof(buf)) {
-        emit_send(buf, (size_t)len);
+    if (len > 0) {
+        emit_send(buf, len);
         LOG_DEBUG("Event emitted: op=%s path=%s off=%lld sz=%zu res=%d",
                   fs_op_names[op], path ? path : "", (long long)offset, size, result);
     }
@@ -119,79 +719,226 @@ void event_emit_op(fs_op_type_t op, const char *path,
 
 void event_emit_fault(fs_op_type_t op, const char *path,
                       off_t offset, size_t size,
-                      const char *fault_type, int fault_result) {
+                      fs_fault_type_t fault, int fault_result) {
     char buf[MAX_EVENT_SIZE];
-    int len = snprintf(buf, sizeof(buf),
-        "{\"ts\":%llu,\"op\":\"%s\",\"path\":\"%s\","
-        "\"off\":%lld,\"sz\":%zu,\"res\":%d,\"fault\":\"%s\"}",
-        (unsigned long long)now_ms(),
-        fs_op_names[op],
-        path ? path : "",
-        (long long)offset,
-        size,
-        fault_result,
-        fault_type);
+    size_t len;
+    if (config_get_global()->event_binary) {
+        len = wire_header(buf, EVENT_KIND_FAULT, op, (uint8_t)fault, 0,
+                          path, offset, size, fault_result, 0, now_ms());
+    } else {
+        char escaped[MAX_EVENT_SIZE / 2];
+        json_escape(escaped, sizeof(escaped), path);
+        int n = snprintf(buf, sizeof(buf),
+            "{\"ts\":%llu,\"op\":\"%s\",\"path\":\"%s\","
+            "\"off\":%lld,\"sz\":%zu,\"res\":%d,\"fault\":\"%s\"}",
+            (unsigned long long)now_ms(),
+            fs_op_names[op],
+            escaped,
+            (long long)offset,
+            size,
+            fault_result,
+            fs_fault_names[fault]);
+        len = (n > 0 && (size_t)n < sizeof(buf)) ? (size_t)n : 0;
+    }
 
-    if (len > 0 && (size_t)len < sizeof(buf)) {
-        emit_send(buf, (size_t)len);
+    if (len > 0) {
+        emit_send(buf, len);
         LOG_DEBUG("Event emitted: fault=%s op=%s path=%s res=%d",
-                  fault_type, fs_op_names[op], path ? path : "", fault_result);
+                  fs_fault_names[fault], fs_op_names[op], path ? path : "", fault_result);
     }
 }
 
-void event_emit_corruption(fs_op_type_t op, const char *path,
-                           off_t offset, size_t size,
-                           const corruption_detail_t *detail) {
-    if (!detail || detail->count == 0) return;
+// Suppression totals since startup: per class, events sampled out and
+// events over the rate limit, then events the transport dropped
+static void emit_summary(void) {
+    uint64_t counts[2 * EVENT_CLASS_COUNT + 1];
+    for (int i = 0; i < EVENT_CLASS_COUNT; i++) {
+        counts[2 * i] = atomic_load_explicit(&limiters[i].sampled_out, memory_order_relaxed);
+        counts[2 * i + 1] = atomic_load_explicit(&limiters[i].rate_limited, memory_order_relaxed);
+    }
+    counts[2 * EVENT_CLASS_COUNT] = atomic_load_explicit(&events_dropped, memory_order_relaxed);
 
     char buf[MAX_EVENT_SIZE];
-    int pos = 0;
+    size_t len;
+    if (config_get_global()->event_binary) {
+        len = wire_header(buf, EVENT_KIND_SUMMARY, (fs_op_type_t)EVENT_WIRE_NO_FAULT,
+                          EVENT_WIRE_NO_FAULT, 0, NULL, 0, 0, 0, 0, now_ms());
+        memcpy(buf + len, counts, sizeof(counts));
+        len += sizeof(counts);
+    } else {
+        int n = snprintf(buf, sizeof(buf), "{\"ts\":%llu,\"summary\":{",
+                         (unsigned long long)now_ms());
+        for (int i = 0; i < EVENT_CLASS_COUNT && n > 0 && (size_t)n < sizeof(buf); i++) {
+            n += snprintf(buf + n, sizeof(buf) - (size_t)n,
+                          "\"%s\":{\"sampled_out\":%llu,\"rate_limited\":%llu},",
+                          event_class_names[i], (unsigned long long)counts[2 * i],
+                          (unsigned long long)counts[2 * i + 1]);
+        }
+        if (n > 0 && (size_t)n < sizeof(buf)) {
+            n += snprintf(buf + n, sizeof(buf) - (size_t)n, "\"dropped\":%llu}}",
+                          (unsigned long long)counts[2 * EVENT_CLASS_COUNT]);
+        }
+        len = (n > 0 && (size_t)n < sizeof(buf)) ? (size_t)n : 0;
+    }
+
+    if (len > 0) {
+        emit_send(buf, len);
+        LOG_DEBUG("Event emitted: summary dropped=%llu",
+                  (unsigned long long)counts[2 * EVENT_CLASS_COUNT]);
+    }
+}
+
+// Position in a corruption detail while it is split into chunk records
+typedef struct {
+    const corruption_detail_t *detail;
+    size_t range;                     // Next range to emit
+    size_t done;                      // Bytes of that range already emitted
+    size_t mask;                      // Next mask byte
+} corr_cursor_t;
+
+static bool corr_cursor_done(const corr_cursor_t *cursor) {
+    return cursor->range >= cursor->detail->range_count;
+}
+
+// Take up to max bytes of the current range. Returns its start and sets *len.
+static size_t corr_cursor_take(corr_cursor_t *cursor, size_t max, size_t *len) {
+    const corruption_range_t *range = &cursor->detail->ranges[cursor->range];
+    size_t start = range->offset + cursor->done;
+    size_t left = range->length - cursor->done;
+    *len = left < max ? left : max;
+
+    cursor->done += *len;
+    cursor->mask += *len;
+    if (cursor->done == range->length) {
+        cursor->range++;
+        cursor->done = 0;
+    }
+    return start;
+}
 
-    // Header
-    pos += snprintf(buf + pos, sizeof(buf) - pos,
+static size_t put_varint(char *buf, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        buf[n++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    buf[n++] = (char)value;
+    return n;
+}
+
+// Binary corruption chunk: header, path, u32 chunk index, u32 range count,
+// then gap/length varints and mask bytes per range
+static size_t wire_corruption_chunk(char *buf, fs_op_type_t op, const char *path,
+                                    off_t offset, size_t size, uint64_t ts,
+                                    uint32_t chunk, corr_cursor_t *cursor) {
+    const corruption_detail_t *detail = cursor->detail;
+
+    // result = size (corruption doesn't change return value)
+    size_t pos = wire_header(buf, EVENT_KIND_CORRUPTION, op, FS_FAULT_CORRUPTION, 0,
+                             path, offset, size, (int32_t)size, (uint32_t)detail->count, ts);
+    memcpy(buf + pos, &chunk, 4);
+    size_t count_pos = pos + 4;
+    pos += 8;
+
+    uint32_t ranges = 0;
+    size_t prev_end = 0;
+    while (!corr_cursor_done(cursor) && pos + 21 < MAX_EVENT_SIZE) {
+        const unsigned char *masks = detail->masks + cursor->mask;
+        size_t len;
+        size_t start = corr_cursor_take(cursor, MAX_EVENT_SIZE - pos - 20, &len);
+        pos += put_varint(buf + pos, start - prev_end);
+        pos += put_varint(buf + pos, len);
+        memcpy(buf + pos, masks, len);
+        pos += len;
+        prev_end = start + len;
+        ranges++;
+    }
+    memcpy(buf + count_pos, &ranges, 4);
+
+    buf[4] = (char)((detail->truncated ? EVENT_WIRE_TRUNCATED : 0) |
+                    (corr_cursor_done(cursor) ? 0 : EVENT_WIRE_MORE));
+    return pos;
+}
+
+// JSON corruption chunk: ranges as [offset, length, "hex masks"]
+static size_t json_corruption_chunk(char *buf, fs_op_type_t op, const char *escaped,
+                                    off_t offset, size_t size, uint64_t ts,
+                                    uint32_t chunk, corr_cursor_t *cursor) {
+    static const char hex[] = "0123456789abcdef";
+    const corruption_detail_t *detail = cursor->detail;
+
+    int n = snprintf(buf, MAX_EVENT_SIZE,
         "{\"ts\":%llu,\"op\":\"%s\",\"path\":\"%s\","
         "\"off\":%lld,\"sz\":%zu,\"res\":%zu,"
-        "\"fault\":\"corruption\",\"corr\":{\"n\":%zu,\"pos\":[",
-        (unsigned long long)now_ms(),
+        "\"fault\":\"corruption\",\"corr\":{\"n\":%zu,\"chunk\":%u,\"ranges\":[",
+        (unsigned long long)ts,
         fs_op_names[op],
-        path ? path : "",
+        escaped,
         (long long)offset,
         size,
         size,  // result = size (corruption doesn't change return value)
-        detail->count);
-
-    // Positions array
-    size_t emit_count = detail->count;
-    if (emit_count > MAX_CORRUPTION_TRACK) emit_count = MAX_CORRUPTION_TRACK;
-
-    for (size_t i = 0; i < emit_count && pos < (int)(sizeof(buf) - 200); i++) {
-        if (i > 0) buf[pos++] = ',';
-        pos += snprintf(buf + pos, sizeof(buf) - pos, "%zu", detail->positions[i]);
+        detail->count,
+        chunk);
+    if (n < 0 || n >= MAX_EVENT_SIZE) {
+        return 0;
     }
+    size_t pos = (size_t)n;
 
-    // Original values array
-    pos += snprintf(buf + pos, sizeof(buf) - pos, "],\"orig\":[");
-    for (size_t i = 0; i < emit_count && pos < (int)(sizeof(buf) - 200); i++) {
-        if (i > 0) buf[pos++] = ',';
-        pos += snprintf(buf + pos, sizeof(buf) - pos, "%u", detail->original[i]);
+    // Each range costs up to 50 bytes plus two hex digits per byte; keep 64
+    // bytes for the closing fields
+    bool first = true;
+    while (!corr_cursor_done(cursor) && pos + 64 + 50 + 2 < MAX_EVENT_SIZE) {
+        const unsigned char *masks = detail->masks + cursor->mask;
+        size_t len;
+        size_t start = corr_cursor_take(cursor, (MAX_EVENT_SIZE - pos - 64 - 50) / 2, &len);
+        pos += (size_t)snprintf(buf + pos, MAX_EVENT_SIZE - pos, "%s[%zu,%zu,\"",
+                                first ? "" : ",", start, len);
+        for (size_t i = 0; i < len; i++) {
+            buf[pos++] = hex[masks[i] >> 4];
+            buf[pos++] = hex[masks[i] & 0xf];
+        }
+        buf[pos++] = '"';
+        buf[pos++] = ']';
+        first = false;
     }
 
-    // Corrupted values array
-    pos += snprintf(buf + pos, sizeof(buf) - pos, "],\"new\":[");
-    for (size_t i = 0; i < emit_count && pos < (int)(sizeof(buf) - 200); i++) {
-        if (i > 0) buf[pos++] = ',';
-        pos += snprintf(buf + pos, sizeof(buf) - pos, "%u", detail->corrupted[i]);
-    }
+    n = snprintf(buf + pos, MAX_EVENT_SIZE - pos, "],\"more\":%s,\"truncated\":%s}}",
+                 corr_cursor_done(cursor) ? "false" : "true",
+                 detail->truncated ? "true" : "false");
+    return n > 0 && pos + (size_t)n < MAX_EVENT_SIZE ? pos + (size_t)n : 0;
+}
 
-    // Close
-    bool truncated = (detail->count > MAX_CORRUPTION_TRACK) ||
-                     (pos >= (int)(sizeof(buf) - 200));
-    pos += snprintf(buf + pos, sizeof(buf) - pos,
-        "],\"truncated\":%s}}", truncated ? "true" : "false");
+void event_emit_corruption(fs_op_type_t op, const char *path,
+                           off_t offset, size_t size,
+                           const corruption_detail_t *detail) {
+    if (!detail || detail->count == 0) return;
 
-    if (pos > 0 && (size_t)pos < sizeof(buf)) {
-        emit_send(buf, (size_t)pos);
-        LOG_DEBUG("Event emitted: corruption op=%s path=%s n=%zu",
-                  fs_op_names[op], path ? path : "", detail->count);
+    bool binary = config_get_global()->event_binary;
+    char escaped[MAX_EVENT_SIZE / 4];
+    if (!binary) {
+        json_escape(escaped, sizeof(escaped), path);
     }
+
+    // One record per chunk; an empty (truncated) detail still gets one
+    char buf[MAX_EVENT_SIZE];
+    corr_cursor_t cursor = { detail, 0, 0, 0 };
+    uint64_t ts = now_ms();
+    uint32_t chunk = 0;
+    do {
+        size_t before = cursor.mask;
+        size_t len = binary
+            ? wire_corruption_chunk(buf, op, path, offset, size, ts, chunk, &cursor)
+            : json_corruption_chunk(buf, op, escaped, offset, size, ts, chunk, &cursor);
+        if (len == 0) {
+            break;
+        }
+        emit_send(buf, len);
+        chunk++;
+        if (cursor.mask == before) {
+            break;  // No room for ranges (cannot happen with the path caps)
+        }
+    } while (!corr_cursor_done(&cursor));
+
+    LOG_DEBUG("Event emitted: corruption op=%s path=%s n=%zu ranges=%zu chunks=%u",
+              fs_op_names[op], path ? path : "", detail->count, detail->range_count, chunk);
 }
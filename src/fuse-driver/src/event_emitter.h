@@ -6,21 +6,82 @@
 #include <sys/types.h>
 #include "fs_common.h"
 
-#define MAX_CORRUPTION_TRACK 256
 #define EVENT_SOCKET_PATH_DEFAULT "/var/run/nas-emu/events.sock"
 
-// Corruption detail collected during apply_corruption_fault
+// Binary wire format (event_format = binary). One datagram per event; all
+// integers little-endian. A JSON datagram starts with '{', a binary one with
+// the schema version byte.
+//
+//   off  size  field
+//     0     1  version (EVENT_WIRE_VERSION)
+//     1     1  kind (EVENT_KIND_*)
+//     2     1  op (fs_op_type_t)
+//     3     1  fault (fs_fault_type_t, EVENT_WIRE_NO_FAULT for none)
+//     4     1  flags (EVENT_WIRE_TRUNCATED, EVENT_WIRE_MORE)
+//     5     1  reserved (0)
+//     6     2  path length
+//     8     8  ts (epoch ms)
+//    16     8  offset (signed)
+//    24     8  size
+//    32     4  result (signed)
+//    36     4  corrupted byte count of the whole write (0 unless kind is corruption)
+//    40     -  path bytes (not NUL-terminated)
+//
+// Corruption records continue with a u32 chunk index and a u32 range count
+// m, then m ranges, each a LEB128 varint gap (from the end of the previous
+// range in this record, or from 0 for the first), a varint length and
+// `length` XOR mask bytes (corrupted = original ^ mask). A corruption that
+// does not fit one datagram is split across records with chunk indexes
+// 0, 1, ... that repeat the header (same ts); all but the last carry
+// EVENT_WIRE_MORE. A range may continue in the next chunk.
+//
+// Summary records (EVENT_KIND_SUMMARY, op and fault EVENT_WIRE_NO_FAULT, no
+// path) continue with u64 totals since startup: data events sampled out,
+// data events over the rate limit, the same two for metadata events, and
+// events the transport dropped. One is sent at most once a second while
+// events are being suppressed, and a last one at cleanup.
+#define EVENT_WIRE_VERSION     2
+#define EVENT_WIRE_HEADER_SIZE 40
+#define EVENT_WIRE_NO_FAULT    0xff
+#define EVENT_WIRE_TRUNCATED   0x01   // Detail incomplete (no memory to record it)
+#define EVENT_WIRE_MORE        0x02   // More chunks of this corruption follow
+
+typedef enum {
+    EVENT_KIND_OP = 0,
+    EVENT_KIND_FAULT,
+    EVENT_KIND_CORRUPTION,
+    EVENT_KIND_SUMMARY
+} event_kind_t;
+
+// One run of consecutive corrupted bytes
 typedef struct {
-    size_t count;
-    size_t positions[MAX_CORRUPTION_TRACK];
-    unsigned char original[MAX_CORRUPTION_TRACK];
-    unsigned char corrupted[MAX_CORRUPTION_TRACK];
+    size_t offset;                    // First byte, relative to the buffer
+    size_t length;
+} corruption_range_t;
+
+// Corruption detail collected during apply_corruption_fault: the corrupted
+// bytes as ascending, non-adjacent ranges plus the XOR mask applied to each
+// byte (the masks of all ranges, concatenated). The arrays live in a
+// per-thread arena and stay valid until the next corruption on that thread.
+typedef struct {
+    size_t count;                     // Bytes corrupted
+    size_t range_count;
+    const corruption_range_t *ranges;
+    const unsigned char *masks;
+    bool truncated;                   // Arena could not grow; ranges are incomplete
 } corruption_detail_t;
 
-// Initialize event emitter (create socket, set non-blocking)
+// Initialize event emitter (create socket, set non-blocking; or create the
+// shared-memory ring when event_shm_path is configured)
 void event_emitter_init(const char *socket_path);
 
-// Cleanup event emitter
+// Start the flusher thread (0 or negative errno). Until it runs, and if it
+// cannot be started, every event is sent synchronously by the emitting
+// thread. Once it runs, events are staged per thread and sent in batches
+// with sendmmsg() (64 events or 1 ms, whichever comes first).
+int event_emitter_start(void);
+
+// Cleanup event emitter (stops the flusher and sends staged events)
 void event_emitter_cleanup(void);
 
 // Emit a filesystem operation event (no fault)
@@ -30,9 +91,9 @@ void event_emit_op(fs_op_type_t op, const char *path,
 // Emit a fault event (error, delay, partial, timing, opcount)
 void event_emit_fault(fs_op_type_t op, const char *path,
                       off_t offset, size_t size,
-                      const char *fault_type, int fault_result);
+                      fs_fault_type_t fault, int fault_result);
 
-// Emit a corruption event with byte-level details
+// Emit a corruption event with byte-level details (one or more chunk records)
 void event_emit_corruption(fs_op_type_t op, const char *path,
                            off_t offset, size_t size,
                            const corruption_detail_t *detail);
@@ -0,0 +1,309 @@
+#define _GNU_SOURCE  /* gettid via syscall, futex */
+
+#include "event_ring.h"
+#include "log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+_Static_assert(offsetof(event_ring_header_t, head) == 64, "ring head offset");
+_Static_assert(offsetof(event_ring_header_t, tail) == 128, "ring tail offset");
+_Static_assert(offsetof(event_ring_header_t, wake_seq) == 192, "ring wake offset");
+_Static_assert(offsetof(event_ring_header_t, producer_count) == 256, "ring producer count offset");
+_Static_assert(offsetof(event_ring_header_t, producers) == 320, "ring producer table offset");
+_Static_assert(sizeof(event_ring_header_t) <= EVENT_RING_DATA_OFFSET, "ring header too large");
+
+#define EVENT_RING_MIN_SIZE (64 * 1024)
+#define EVENT_RING_MAX_SIZE (1024 * 1024 * 1024)
+
+// Producer state
+static event_ring_header_t *ring = NULL;
+static unsigned char *ring_data = NULL;
+static size_t ring_map_size = 0;
+static __thread int tls_slot = -1;
+
+static inline _Atomic uint32_t *record_word(unsigned char *data, uint64_t pos) {
+    return (_Atomic uint32_t *)(data + pos);
+}
+
+static inline uint32_t record_size(uint32_t len) {
+    return (len + 7u) & ~7u;
+}
+
+static int futex(_Atomic uint32_t *word, int op, uint32_t value, const struct timespec *timeout) {
+    return (int)syscall(SYS_futex, (uint32_t *)word, op, value, timeout, NULL, 0);
+}
+
+// Create the ring file and map it
+int event_ring_create(const char *path, size_t capacity) {
+    size_t cap = EVENT_RING_MIN_SIZE;
+    while (cap < capacity && cap < EVENT_RING_MAX_SIZE) {
+        cap *= 2;
+    }
+
+    // Replace rather than truncate: a reader still mapping an old ring keeps
+    // its own file instead of faulting on a shrunk one
+    unlink(path);
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        int err = errno;
+        LOG_ERROR("Event ring: cannot create %s: %s", path, strerror(err));
+        return -err;
+    }
+
+    size_t map_size = EVENT_RING_DATA_OFFSET + cap;
+    if (ftruncate(fd, (off_t)map_size) != 0) {
+        int err = errno;
+        LOG_ERROR("Event ring: cannot size %s to %zu bytes: %s", path, map_size, strerror(err));
+        close(fd);
+        unlink(path);
+        return -err;
+    }
+
+    void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (map == MAP_FAILED) {
+        LOG_ERROR("Event ring: cannot map %s: %s", path, strerror(err));
+        unlink(path);
+        return -err;
+    }
+
+    event_ring_header_t *header = map;
+    header->version = EVENT_RING_VERSION;
+    header->data_offset = EVENT_RING_DATA_OFFSET;
+    header->capacity = cap;
+    header->max_producers = EVENT_RING_MAX_PRODUCERS;
+    atomic_store(&header->magic, EVENT_RING_MAGIC);  // Readers may attach now
+
+    ring_data = (unsigned char *)map + EVENT_RING_DATA_OFFSET;
+    ring_map_size = map_size;
+    ring = header;
+
+    LOG_INFO("Event ring: %s (%zu bytes)", path, cap);
+    return 0;
+}
+
+// Unmap the ring
+void event_ring_destroy(void) {
+    if (!ring) {
+        return;
+    }
+
+    uint64_t written = 0, dropped = 0;
+    uint32_t slots = atomic_load(&ring->producer_count);
+    if (slots > EVENT_RING_MAX_PRODUCERS) {
+        slots = EVENT_RING_MAX_PRODUCERS;
+    }
+    for (uint32_t i = 0; i < slots; i++) {
+        written += atomic_load(&ring->producers[i].written);
+        dropped += atomic_load(&ring->producers[i].dropped);
+    }
+    LOG_INFO("Event ring closed (written: %llu, dropped: %llu)",
+             (unsigned long long)written, (unsigned long long)dropped);
+
+    munmap(ring, ring_map_size);
+    ring = NULL;
+    ring_data = NULL;
+    ring_map_size = 0;
+}
+
+bool event_ring_active(void) {
+    return ring != NULL;
+}
+
+// Producer table slot of the calling thread (the last slot is shared once
+// the table is full)
+static event_ring_producer_t *producer_slot(void) {
+    if (tls_slot < 0) {
+        uint32_t slot = atomic_fetch_add(&ring->producer_count, 1);
+        if (slot >= EVENT_RING_MAX_PRODUCERS) {
+            slot = EVENT_RING_MAX_PRODUCERS - 1;
+        } else {
+            ring->producers[slot].tid = (uint64_t)syscall(SYS_gettid);
+        }
+        tls_slot = (int)slot;
+    }
+    return &ring->producers[tls_slot];
+}
+
+// Append one event
+bool event_ring_write(const void *data, size_t len) {
+    event_ring_header_t *header = ring;
+    if (!header) {
+        return false;
+    }
+    event_ring_producer_t *producer = producer_slot();
+
+    uint64_t capacity = header->capacity;
+    uint64_t mask = capacity - 1;
+    uint32_t exact = (uint32_t)(EVENT_RING_RECORD_HEADER + len);
+    uint64_t size = record_size(exact);
+    if (size > capacity / 2) {
+        atomic_fetch_add_explicit(&producer->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    // Reserve size bytes (plus the rest of the lap if the record would wrap)
+    uint64_t head = atomic_load_explicit(&header->head, memory_order_relaxed);
+    uint64_t pos, to_end, need;
+    do {
+        uint64_t tail = atomic_load_explicit(&header->tail, memory_order_acquire);
+        pos = head & mask;
+        to_end = capacity - pos;
+        need = size <= to_end ? size : to_end + size;
+        if (head + need - tail > capacity) {
+            atomic_fetch_add_explicit(&producer->dropped, 1, memory_order_relaxed);
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&header->head, &head, head + need,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+
+    uint32_t slot = (uint32_t)tls_slot;
+    if (need != size) {
+        memcpy(ring_data + pos + 4, &slot, 4);
+        atomic_store_explicit(record_word(ring_data, pos), (uint32_t)to_end | EVENT_RING_PAD,
+                              memory_order_release);
+        pos = 0;
+    }
+
+    memcpy(ring_data + pos + 4, &slot, 4);
+    memcpy(ring_data + pos + EVENT_RING_RECORD_HEADER, data, len);
+    atomic_store_explicit(record_word(ring_data, pos), exact | EVENT_RING_COMMITTED,
+                          memory_order_release);
+    atomic_fetch_add_explicit(&producer->written, 1, memory_order_relaxed);
+
+    // Only a sleeping consumer costs a syscall
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&header->consumer_sleeping, memory_order_relaxed)) {
+        atomic_fetch_add(&header->wake_seq, 1);
+        futex(&header->wake_seq, FUTEX_WAKE, 1, NULL);
+    }
+    return true;
+}
+
+// Map an existing ring
+int event_ring_attach(event_ring_reader_t *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = -errno;
+        close(fd);
+        return err;
+    }
+    if ((size_t)st.st_size < EVENT_RING_DATA_OFFSET + EVENT_RING_MIN_SIZE) {
+        close(fd);
+        return -EAGAIN;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = -errno;
+    close(fd);
+    if (map == MAP_FAILED) {
+        return err;
+    }
+
+    event_ring_header_t *header = map;
+    if (atomic_load(&header->magic) != EVENT_RING_MAGIC) {
+        munmap(map, (size_t)st.st_size);
+        return -EAGAIN;
+    }
+    if (header->version != EVENT_RING_VERSION ||
+        header->data_offset != EVENT_RING_DATA_OFFSET ||
+        header->data_offset + header->capacity > (uint64_t)st.st_size) {
+        munmap(map, (size_t)st.st_size);
+        return -EPROTO;
+    }
+
+    reader->header = header;
+    reader->data = (unsigned char *)map + header->data_offset;
+    reader->map_size = (size_t)st.st_size;
+    return 0;
+}
+
+void event_ring_detach(event_ring_reader_t *reader) {
+    if (reader->header) {
+        munmap(reader->header, reader->map_size);
+    }
+    memset(reader, 0, sizeof(*reader));
+}
+
+// Clear a consumed record and hand its space back to producers
+static void release_record(event_ring_reader_t *reader, uint64_t tail, uint32_t size) {
+    uint64_t mask = reader->header->capacity - 1;
+    memset(reader->data + (tail & mask), 0, size);
+    atomic_store_explicit(&reader->header->tail, tail + size, memory_order_release);
+}
+
+// Take the next event
+size_t event_ring_peek(event_ring_reader_t *reader, const unsigned char **data) {
+    event_ring_header_t *header = reader->header;
+    uint64_t mask = header->capacity - 1;
+
+    for (;;) {
+        uint64_t tail = atomic_load_explicit(&header->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&header->head, memory_order_acquire);
+        if (tail == head) {
+            return 0;
+        }
+
+        uint64_t pos = tail & mask;
+        uint32_t word = atomic_load_explicit(record_word(reader->data, pos), memory_order_acquire);
+        uint32_t len = word & EVENT_RING_LEN_MASK;
+        if (word & EVENT_RING_PAD) {
+            release_record(reader, tail, len);
+            continue;
+        }
+        if (!(word & EVENT_RING_COMMITTED)) {
+            return 0;  // Oldest record still being written
+        }
+
+        reader->pending = record_size(len);
+        *data = reader->data + pos + EVENT_RING_RECORD_HEADER;
+        return len - EVENT_RING_RECORD_HEADER;
+    }
+}
+
+// Release the event returned by the last peek
+void event_ring_release(event_ring_reader_t *reader) {
+    if (reader->pending == 0) {
+        return;
+    }
+    uint64_t tail = atomic_load_explicit(&reader->header->tail, memory_order_relaxed);
+    release_record(reader, tail, reader->pending);
+    reader->pending = 0;
+}
+
+// Sleep until producers publish something
+void event_ring_wait(event_ring_reader_t *reader, int timeout_ms) {
+    event_ring_header_t *header = reader->header;
+    uint32_t seq = atomic_load(&header->wake_seq);
+
+    atomic_store(&header->consumer_sleeping, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    // Re-check after announcing the sleep, so a commit in between is not missed
+    uint64_t tail = atomic_load(&header->tail);
+    uint32_t word = atomic_load(record_word(reader->data, tail & (header->capacity - 1)));
+    if (tail == atomic_load(&header->head) || !(word & (EVENT_RING_COMMITTED | EVENT_RING_PAD))) {
+        struct timespec timeout = {
+            .tv_sec = timeout_ms / 1000,
+            .tv_nsec = (long)(timeout_ms % 1000) * 1000000L
+        };
+        futex(&header->wake_seq, FUTEX_WAIT, seq, timeout_ms >= 0 ? &timeout : NULL);
+    }
+    atomic_store(&header->consumer_sleeping, 0);
+}
@@ -0,0 +1,119 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Shared-memory event transport (event_shm_path).
+//
+// A multi-producer, single-consumer ring in a file mapped MAP_SHARED (put it
+// on tmpfs, e.g. /dev/shm). FUSE threads reserve space by advancing head with
+// a CAS, copy the encoded event (the same JSON or binary datagram the socket
+// would carry) and publish it by storing the record word last. A consumer in
+// any process maps the same file, reads records in order at tail, clears
+// them and advances tail. Nothing on the producer side makes a syscall unless
+// the consumer sleeps in event_ring_wait(). When the ring is full the event
+// is dropped and counted against the producing thread.
+//
+// File layout (all integers little-endian):
+//
+//   off   field
+//     0   u64 magic (EVENT_RING_MAGIC), written last by the creator
+//     8   u32 version (EVENT_RING_VERSION)
+//    12   u32 data offset (EVENT_RING_DATA_OFFSET)
+//    16   u64 capacity of the data area in bytes (power of two)
+//    24   u32 producer slots (EVENT_RING_MAX_PRODUCERS)
+//    64   u64 head: bytes reserved by producers
+//   128   u64 tail: bytes released by the consumer
+//   192   u32 wake sequence (futex word), u32 consumer sleeping flag
+//   256   u32 producer slots in use
+//   320   producer table, 32 bytes per slot: u64 tid, u64 written,
+//         u64 dropped, u64 reserved
+//  4096   data
+//
+// Records start on 8-byte boundaries with a u32 word (length in bytes
+// including the 8-byte record header, | EVENT_RING_COMMITTED, or
+// | EVENT_RING_PAD for the filler before a wrap) and a u32 producer slot.
+// A zero word means the record is still being written.
+
+#define EVENT_RING_MAGIC         0x31425245564e4153ULL   // "NASEVRB1"
+#define EVENT_RING_VERSION       1
+#define EVENT_RING_DATA_OFFSET   4096
+#define EVENT_RING_MAX_PRODUCERS 64
+#define EVENT_RING_RECORD_HEADER 8
+#define EVENT_RING_COMMITTED     0x80000000u
+#define EVENT_RING_PAD           0x40000000u
+#define EVENT_RING_LEN_MASK      0x3fffffffu
+
+// Default data area size
+#define EVENT_RING_DEFAULT_SIZE  (8 * 1024 * 1024)
+
+typedef struct {
+    uint64_t tid;
+    _Atomic uint64_t written;
+    _Atomic uint64_t dropped;
+    uint64_t reserved;
+} event_ring_producer_t;
+
+typedef struct {
+    _Atomic uint64_t magic;
+    uint32_t version;
+    uint32_t data_offset;
+    uint64_t capacity;
+    uint32_t max_producers;
+    char pad0[64 - 28];
+    _Atomic uint64_t head;
+    char pad1[64 - 8];
+    _Atomic uint64_t tail;
+    char pad2[64 - 8];
+    _Atomic uint32_t wake_seq;
+    _Atomic uint32_t consumer_sleeping;
+    char pad3[64 - 8];
+    _Atomic uint32_t producer_count;
+    char pad4[64 - 4];
+    event_ring_producer_t producers[EVENT_RING_MAX_PRODUCERS];
+} event_ring_header_t;
+
+// Producer side (the driver)
+
+// Create (or replace) the ring file and map it. capacity is rounded up to a
+// power of two. Returns 0 or a negative errno.
+int event_ring_create(const char *path, size_t capacity);
+
+// Unmap the ring (the file stays for late readers)
+void event_ring_destroy(void);
+
+// True once event_ring_create() succeeded
+bool event_ring_active(void);
+
+// Append one event. Returns false if it was dropped (ring full).
+bool event_ring_write(const void *data, size_t len);
+
+// Consumer side (tools and tests)
+
+typedef struct {
+    event_ring_header_t *header;
+    unsigned char *data;
+    size_t map_size;
+    uint32_t pending;        // Size of the record returned by the last peek
+} event_ring_reader_t;
+
+// Map an existing ring file (0 or a negative errno; -EAGAIN if the creator
+// has not finished initializing it)
+int event_ring_attach(event_ring_reader_t *reader, const char *path);
+
+void event_ring_detach(event_ring_reader_t *reader);
+
+// Take the next event. Returns its length and points *data at it (valid
+// until event_ring_release()), or 0 if nothing is ready.
+size_t event_ring_peek(event_ring_reader_t *reader, const unsigned char **data);
+
+// Release the event returned by the last event_ring_peek()
+void event_ring_release(event_ring_reader_t *reader);
+
+// Sleep until producers publish something or timeout_ms passes
+void event_ring_wait(event_ring_reader_t *reader, int timeout_ms);
+
+#endif // EVENT_RING_H
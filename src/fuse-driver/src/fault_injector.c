@@ -1,56 +1,128 @@
 #include "fault_injector.h"
 #include "log.h"
 #include "config.h"
+#include "fault_plan.h"
+#include "rng.h"
+#include "op_stats.h"
+#include "corruption.h"
+#include "trace.h"
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
-// Operational statistics tracking
-typedef struct {
-    size_t bytes_read;
-    size_t bytes_written;
-    int operation_count;
-    time_t start_time;
-    int op_counts[FS_OP_COUNT];  // Count per operation type
-} operation_stats_t;
+// Time the fault injector started or last reloaded (for timing faults)
+static _Atomic time_t start_time;
 
-static operation_stats_t stats;
+// Highest byte total seen by a count rule check since the last (re)load.
+// Bytes only ever grow, so a rule whose after_bytes is at most this has
+// fired for good and needs no fresh sum of the shards.
+static _Atomic uint64_t bytes_reached;
 
-// Random number generator seeded?
-static bool rng_seeded = false;
+// Operation number and byte total at the last (re)load: count rules count
+// from there
+static _Atomic uint64_t sequence_base;
+static _Atomic uint64_t bytes_base;
+
+// Compiled plan owned by the fault injector (replaced by reloads)
+static fault_plan_t *compiled_plan = NULL;
+static pthread_mutex_t reload_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 // Initialize the fault injector
 void fault_injector_init(void) {
     LOG_INFO("Fault injector initialized");
     
-    // Seed random number generator
-    if (!rng_seeded) {
-        srand((unsigned int)time(NULL));
-        rng_seeded = true;
-    }
+    // Seed the per-thread random number generators from the master seed
+    rng_init(config_get_global()->random_seed);
     
     // Initialize operation statistics
-    memset(&stats, 0, sizeof(stats));
-    stats.start_time = time(NULL);
+    op_stats_init();
+    atomic_store(&bytes_reached, 0);
+    atomic_store(&sequence_base, 0);
+    atomic_store(&bytes_base, 0);
+    atomic_store(&start_time, time(NULL));
+    
+    // Compile the fault sections into the per-operation rule table
+    compiled_plan = fault_plan_compile(config_get_global());
+    if (compiled_plan) {
+        fault_plan_dump(compiled_plan);
+        fault_plan_activate(compiled_plan);
+    } else {
+        LOG_ERROR("Failed to compile fault plan, fault injection disabled");
+    }
+}
+
+// Replace the fault rules with those of a configuration file
+bool fault_injector_reload(const char *config_file) {
+    fs_config_t reloaded;
+    memset(&reloaded, 0, sizeof(reloaded));
+    config_init(&reloaded);
+    if (!config_load_from_file(&reloaded, config_file)) {
+        LOG_ERROR("Reload: cannot read %s, keeping the current fault rules", config_file);
+        config_cleanup(&reloaded);
+        return false;
+    }
+    fault_plan_t *plan = fault_plan_compile(&reloaded);
+    config_cleanup(&reloaded);
+    if (!plan) {
+        LOG_ERROR("Reload: failed to compile %s, keeping the current fault rules", config_file);
+        return false;
+    }
+
+    pthread_mutex_lock(&reload_mutex);
+    fault_plan_dump(plan);
+
+    // Timing and count rules of the new plan start from now
+    atomic_store(&start_time, time(NULL));
+    atomic_store(&sequence_base, op_stats_sequence());
+    atomic_store(&bytes_base, op_stats_bytes_total());
+    atomic_store(&bytes_reached, 0);
+
+    fault_plan_t *previous = compiled_plan;
+    compiled_plan = plan;
+    fault_plan_activate(plan);
+    LOG_INFO("Reload: fault rules loaded from %s (generation %u)", config_file, plan->generation);
+    fault_plan_retire(previous);
+    pthread_mutex_unlock(&reload_mutex);
+    return true;
 }
 
 // Clean up fault injector resources
 void fault_injector_cleanup(void) {
     LOG_INFO("Fault injector cleaned up");
-    LOG_INFO("Final operation stats: %d operations, %zu bytes read, %zu bytes written",
-             stats.operation_count, stats.bytes_read, stats.bytes_written);
+
+    pthread_mutex_lock(&reload_mutex);
+    fault_plan_activate(NULL);
+    fault_plan_retire(compiled_plan);
+    compiled_plan = NULL;
+    pthread_mutex_unlock(&reload_mutex);
+    size_t leaked = fault_plan_reclaim();
+    if (leaked > 0) {
+        LOG_WARN("%zu retired fault plans still in use at exit", leaked);
+    }
+
+    op_stats_snapshot_t snapshot;
+    op_stats_snapshot(&snapshot);
+    LOG_INFO("Final operation stats: %llu operations, %llu bytes read, %llu bytes written",
+             (unsigned long long)snapshot.operation_count,
+             (unsigned long long)snapshot.bytes_read,
+             (unsigned long long)snapshot.bytes_written);
+    LOG_INFO("  Permission checks: %llu from the inode mode cache, %llu with fstat",
+             (unsigned long long)snapshot.mode_cache_hits,
+             (unsigned long long)snapshot.mode_cache_misses);
+    for (int i = 0; i < FS_FAULT_COUNT; i++) {
+        if (snapshot.faults[i] > 0) {
+            LOG_INFO("  %s faults injected: %llu", fs_fault_names[i],
+                     (unsigned long long)snapshot.faults[i]);
+        }
+    }
 }
 
 // Helper function to check if a probability threshold is met
 bool check_probability(float probability) {
-    if (!rng_seeded) {
-        srand((unsigned int)time(NULL));
-        rng_seeded = true;
-        LOG_DEBUG("Random number generator seeded");
-    }
-    
     LOG_DEBUG("Checking probability: threshold=%.3f", probability);
     
     if (probability <= 0.0f) {
@@ -63,8 +135,8 @@ bool check_probability(float probability) {
         return true;
     }
     
-    // Generate random number between 0 and 1
-    float r = (float)rand() / (float)RAND_MAX;
+    // Draw from this thread's stream - no shared lock, unlike rand()
+    double r = rng_uniform();
     bool result = r < probability;
     LOG_DEBUG("Probability check: random=%.3f, threshold=%.3f, result=%s", 
               r, probability, result ? "TRIGGER" : "skip");
@@ -72,182 +144,160 @@ bool check_probability(float probability) {
 }
 
 // Helper to check if timing conditions are met
-bool check_timing_fault(fs_op_type_t operation) {
-    fs_config_t *config = config_get_global();
-    
-    if (!config->enable_fault_injection || !config->timing_fault || !config->timing_fault->enabled) {
+bool check_timing_fault(const fault_op_plan_t *plan) {
+    uint32_t count = plan->rule_counts[FS_FAULT_TIMING];
+    if (count == 0) {
         return false;
     }
     
-    // Check if the operation should be affected
-    if (!config_should_affect_operation(config->timing_fault->operations_mask, operation)) {
-        return false;
-    }
+    // Check time elapsed since start against each rule
+    time_t now = time(NULL);
+    double elapsed_minutes = difftime(now, atomic_load(&start_time)) / 60.0;
     
-    // Check time elapsed since start
-    if (config->timing_fault->after_minutes > 0) {
-        time_t now = time(NULL);
-        double elapsed_minutes = difftime(now, stats.start_time) / 60.0;
-        
-        if (elapsed_minutes < config->timing_fault->after_minutes) {
-            LOG_DEBUG("Timing fault: %s not triggered (only %.1f minutes elapsed, need %d)",
-                     fs_op_names[operation], elapsed_minutes, config->timing_fault->after_minutes);
-            return false;
+    const fault_rule_t *rules = plan->rules[FS_FAULT_TIMING];
+    for (uint32_t i = 0; i < count; i++) {
+        if (elapsed_minutes >= rules[i].after_minutes) {
+            LOG_INFO("Timing fault: %s triggered after %.1f minutes",
+                    fs_op_names[plan->operation], elapsed_minutes);
+            return true;
         }
-        
-        LOG_INFO("Timing fault: %s triggered after %.1f minutes",
-                fs_op_names[operation], elapsed_minutes);
-        return true;
+        LOG_DEBUG("Timing fault: %s not triggered (only %.1f minutes elapsed, need %d)",
+                 fs_op_names[plan->operation], elapsed_minutes, rules[i].after_minutes);
     }
     
     return false;
 }
 
 // Helper to check if operation count conditions are met
-bool check_operation_count_fault(fs_op_type_t operation) {
-    fs_config_t *config = config_get_global();
+// (sequence is the global operation number claimed by this operation)
+bool check_operation_count_fault(const fault_op_plan_t *plan, uint64_t sequence) {
+    uint32_t count = plan->rule_counts[FS_FAULT_OPCOUNT];
+    const fault_rule_t *rules = plan->rules[FS_FAULT_OPCOUNT];
     
-    if (!config->enable_fault_injection || !config->operation_count_fault || !config->operation_count_fault->enabled) {
-        return false;
-    }
-    
-    // Check if the operation should be affected
-    if (!config_should_affect_operation(config->operation_count_fault->operations_mask, operation)) {
-        return false;
-    }
-    
-    // Check operation count
-    if (config->operation_count_fault->every_n_operations > 0 &&
-        stats.operation_count % config->operation_count_fault->every_n_operations == 0) {
-        LOG_INFO("Operation count fault: %s triggered on operation #%d",
-                fs_op_names[operation], stats.operation_count);
-        return true;
-    }
-    
-    // Check byte count
-    if (config->operation_count_fault->after_bytes > 0 &&
-        (stats.bytes_read + stats.bytes_written) >= config->operation_count_fault->after_bytes) {
-        LOG_INFO("Operation count fault: %s triggered after %zu bytes processed",
-                fs_op_names[operation], (stats.bytes_read + stats.bytes_written));
-        return true;
+    for (uint32_t i = 0; i < count; i++) {
+        const fault_rule_t *rule = &rules[i];
+        
+        // Check operation count
+        if (rule->every_n_operations > 0 &&
+            (sequence - atomic_load_explicit(&sequence_base, memory_order_relaxed)) %
+                (uint64_t)rule->every_n_operations == 0) {
+            LOG_INFO("Operation count fault: %s triggered on operation #%llu",
+                    fs_op_names[plan->operation], (unsigned long long)sequence);
+            return true;
+        }
+        
+        // Check byte count (summing the shards only until this rule's
+        // threshold is known to be reached)
+        if (rule->after_bytes > 0) {
+            uint64_t reached = atomic_load_explicit(&bytes_reached, memory_order_relaxed);
+            if (reached < rule->after_bytes) {
+                uint64_t total = op_stats_bytes_total() -
+                                 atomic_load_explicit(&bytes_base, memory_order_relaxed);
+                if (total < rule->after_bytes) {
+                    continue;
+                }
+                while (reached < total &&
+                       !atomic_compare_exchange_weak_explicit(&bytes_reached, &reached, total,
+                                                              memory_order_relaxed,
+                                                              memory_order_relaxed)) {
+                }
+                LOG_INFO("Operation count fault: byte threshold reached after %llu bytes processed",
+                        (unsigned long long)total);
+            }
+            LOG_INFO("Operation count fault: %s triggered after %zu bytes threshold",
+                    fs_op_names[plan->operation], rule->after_bytes);
+            return true;
+        }
     }
     
     return false;
 }
 
 // Apply an error fault if configured
-bool apply_error_fault(fs_op_type_t operation, int *error_code) {
-    fs_config_t *config = config_get_global();
-    
-    if (!config->enable_fault_injection || !config->error_fault) {
-        return false;
-    }
-    
-    // Check if the operation should be affected
-    if (!config_should_affect_operation(config->error_fault->operations_mask, operation)) {
-        return false;
-    }
-    
-    // Check probability
-    if (!check_probability(config->error_fault->probability)) {
-        return false;
+bool apply_error_fault(const fault_op_plan_t *plan, int *error_code) {
+    uint32_t count = plan->rule_counts[FS_FAULT_ERROR];
+    const fault_rule_t *rules = plan->rules[FS_FAULT_ERROR];
+    
+    // The first rule whose probability check passes decides the error code
+    for (uint32_t i = 0; i < count; i++) {
+        if (check_probability(rules[i].probability)) {
+            *error_code = rules[i].error_code;
+            op_stats_count_fault(FS_FAULT_ERROR);
+            TRACE2(fault_error, plan->operation, *error_code);
+            LOG_INFO("Error fault injected for %s: error code %d",
+                     fs_op_names[plan->operation], *error_code);
+            return true;
+        }
     }
     
-    // Apply the error fault
-    *error_code = config->error_fault->error_code;
-    LOG_INFO("Error fault injected for %s: error code %d", fs_op_names[operation], *error_code);
-    return true;
+    return false;
 }
 
-// Apply a delay fault if configured
-bool apply_delay_fault(fs_op_type_t operation) {
-    //LOG_INFO("apply_delay_fault: START for operation %d", operation);
-    fs_config_t *config = config_get_global();
-    //LOG_INFO("apply_delay_fault: Got config");
-    
-    if (!config->enable_fault_injection || !config->delay_fault) {
-        //LOG_INFO("apply_delay_fault: No delay_fault config, returning false");
-        return false;
-    }
-    
-    //LOG_INFO("apply_delay_fault: Checking if operation should be affected...");
-    // Check if the operation should be affected
-    if (!config_should_affect_operation(config->delay_fault->operations_mask, operation)) {
-        //OG_INFO("apply_delay_fault: Operation not affected, returning false");
-        return false;
+// Decide whether a delay fault fires, without sleeping
+bool check_delay_fault(const fault_op_plan_t *plan, int *delay_ms) {
+    uint32_t count = plan->rule_counts[FS_FAULT_DELAY];
+    const fault_rule_t *rules = plan->rules[FS_FAULT_DELAY];
+    
+    for (uint32_t i = 0; i < count; i++) {
+        if (check_probability(rules[i].probability)) {
+            *delay_ms = rules[i].delay_ms > 0 ? rules[i].delay_ms : 0;
+            op_stats_count_fault(FS_FAULT_DELAY);
+            TRACE2(fault_delay, plan->operation, *delay_ms);
+            LOG_INFO("Delay fault injected for %s: %d ms",
+                     fs_op_names[plan->operation], *delay_ms);
+            return true;
+        }
     }
     
-    //LOG_INFO("apply_delay_fault: Checking probability...");
-    // Check probability
-    if (!check_probability(config->delay_fault->probability)) {
-        //LOG_INFO("apply_delay_fault: Probability check failed, returning false");
+    return false;
+}
+
+// Apply a delay fault if configured (blocks the calling thread)
+bool apply_delay_fault(const fault_op_plan_t *plan) {
+    int delay_ms;
+    if (!check_delay_fault(plan, &delay_ms)) {
         return false;
     }
-    
-    // Apply the delay fault
-    int delay_ms = config->delay_fault->delay_ms;
-    LOG_INFO("Delay fault injected for %s: sleeping for %d ms", fs_op_names[operation], delay_ms);
     usleep(delay_ms * 1000); // Convert ms to microseconds
-    //LOG_INFO("apply_delay_fault: Sleep completed, returning true");
     return true;
 }
 
-// Apply a corruption fault if configured
-bool apply_corruption_fault(fs_op_type_t operation, char *buffer, size_t size,
-                            corruption_detail_t *detail) {
-    fs_config_t *config = config_get_global();
-    
-    LOG_DEBUG("=== CORRUPTION FAULT CHECK for %s ===", fs_op_names[operation]);
-    LOG_DEBUG("Buffer: %p, Size: %zu", buffer, size);
-    
-    if (!config->enable_fault_injection || !config->corruption_fault) {
-        LOG_DEBUG("Corruption fault: config->corruption_fault is NULL");
-        return false;
-    }
-    
-    if (!buffer) {
-        LOG_DEBUG("Corruption fault: buffer is NULL");
-        return false;
-    }
+// Decide whether a corruption fault fires, without touching any data
+const fault_rule_t *check_corruption_fault(const fault_op_plan_t *plan, size_t size) {
+    LOG_DEBUG("=== CORRUPTION FAULT CHECK for %s ===", fs_op_names[plan->operation]);
     
     if (size == 0) {
         LOG_DEBUG("Corruption fault: size is 0");
-        return false;
-    }
-    
-    LOG_DEBUG("Corruption fault config: probability=%.3f, percentage=%.1f, operations_mask=0x%x",
-              config->corruption_fault->probability, 
-              config->corruption_fault->percentage, 
-              config->corruption_fault->operations_mask);
-    
-    // Check if the operation should be affected
-    bool should_affect = config_should_affect_operation(config->corruption_fault->operations_mask, operation);
-    LOG_DEBUG("Operation %s should be affected: %s", fs_op_names[operation], should_affect ? "YES" : "NO");
-    if (!should_affect) {
-        return false;
-    }
-    
-    // Check probability
-    LOG_DEBUG("Checking corruption probability...");
-    bool prob_triggered = check_probability(config->corruption_fault->probability);
-    LOG_DEBUG("Corruption probability result: %s", prob_triggered ? "TRIGGERED" : "not triggered");
-    if (!prob_triggered) {
-        return false;
-    }
-    
-    // Validate corruption percentage
-    if (config->corruption_fault->percentage < 0.0 || config->corruption_fault->percentage > 100.0) {
-        LOG_ERROR("Invalid corruption percentage: %.1f%% (must be 0-100)", config->corruption_fault->percentage);
-        return false;
+        return NULL;
+    }
+    
+    // Find the first rule whose probability check passes
+    uint32_t count = plan->rule_counts[FS_FAULT_CORRUPTION];
+    const fault_rule_t *rule = NULL;
+    for (uint32_t i = 0; i < count && !rule; i++) {
+        const fault_rule_t *candidate = &plan->rules[FS_FAULT_CORRUPTION][i];
+        LOG_DEBUG("Corruption fault rule: probability=%.3f, percentage=%.1f",
+                  candidate->probability, candidate->percentage);
+        if (check_probability(candidate->probability)) {
+            rule = candidate;
+        }
     }
+    LOG_DEBUG("Corruption probability result: %s", rule ? "TRIGGERED" : "not triggered");
+    return rule;
+}
+
+// Corrupt a buffer according to a rule returned by check_corruption_fault()
+void corrupt_buffer(const fault_op_plan_t *plan, const fault_rule_t *rule, char *buffer,
+                    size_t size, corruption_detail_t *detail) {
+    LOG_DEBUG("Buffer: %p, Size: %zu", buffer, size);
     
     // Calculate how many bytes to corrupt
-    size_t corrupt_bytes = (size_t)(size * config->corruption_fault->percentage / 100.0);
+    size_t corrupt_bytes = (size_t)(size * rule->percentage / 100.0);
     LOG_DEBUG("Calculated corrupt_bytes: %zu (%.1f%% of %zu)", 
-              corrupt_bytes, config->corruption_fault->percentage, size);
+              corrupt_bytes, rule->percentage, size);
     
-    // Corrupt at least one byte if percentage is non-zero
-    if (corrupt_bytes == 0 && config->corruption_fault->percentage > 0) {
+    // Corrupt at least one byte (compiled rules always have a non-zero percentage)
+    if (corrupt_bytes == 0) {
         corrupt_bytes = 1;
         LOG_DEBUG("Adjusted corrupt_bytes to 1 (minimum for non-zero percentage)");
     }
@@ -258,9 +308,11 @@ bool apply_corruption_fault(fs_op_type_t operation, char *buffer, size_t size,
         LOG_DEBUG("Capped corrupt_bytes to buffer size: %zu", corrupt_bytes);
     }
     
+    op_stats_count_fault(FS_FAULT_CORRUPTION);
+    TRACE3(fault_corruption, plan->operation, size, corrupt_bytes);
     LOG_INFO("=== APPLYING CORRUPTION ===");
     LOG_INFO("Corruption fault injected for %s: corrupting %zu of %zu bytes (%.1f%%)",
-            fs_op_names[operation], corrupt_bytes, size, config->corruption_fault->percentage);
+            fs_op_names[plan->operation], corrupt_bytes, size, rule->percentage);
     
     // Log original data sample (first 32 bytes)
     LOG_DEBUG("Original data sample (first 32 bytes):");
@@ -269,110 +321,89 @@ bool apply_corruption_fault(fs_op_type_t operation, char *buffer, size_t size,
                   (buffer[i] >= 32 && buffer[i] < 127) ? buffer[i] : '.');
     }
     
-    // Initialize detail tracking if provided
-    if (detail) {
-        detail->count = 0;
-    }
-
-    // Corrupt random bytes in the buffer
-    for (size_t i = 0; i < corrupt_bytes && size > 0; i++) {
-        size_t pos = rand() % size;
-        char original = buffer[pos];
-        char corrupted = (char)(rand() % 256);
-        buffer[pos] = corrupted;
-        LOG_DEBUG("Corrupted byte at pos %zu: 0x%02x -> 0x%02x",
-                  pos, (unsigned char)original, (unsigned char)corrupted);
-
-        // Track corruption details for event emission
-        if (detail && detail->count < MAX_CORRUPTION_TRACK) {
-            detail->positions[detail->count] = pos;
-            detail->original[detail->count] = (unsigned char)original;
-            detail->corrupted[detail->count] = (unsigned char)corrupted;
-            detail->count++;
-        }
-    }
+    // Corrupt exactly corrupt_bytes distinct bytes (positions recorded in ascending order)
+    corruption_apply((unsigned char *)buffer, size, corrupt_bytes, detail);
     
     LOG_INFO("=== CORRUPTION COMPLETE ===");
-    return true;
 }
 
-// Get partial size for partial operation faults
-size_t apply_partial_fault(fs_op_type_t operation, size_t original_size) {
-    fs_config_t *config = config_get_global();
-    
-    if (!config->enable_fault_injection || !config->partial_fault || original_size == 0) {
-        return original_size;
+// Apply a corruption fault if configured
+bool apply_corruption_fault(const fault_op_plan_t *plan, char *buffer, size_t size,
+                            corruption_detail_t *detail) {
+    if (!buffer) {
+        LOG_DEBUG("Corruption fault: buffer is NULL");
+        return false;
     }
     
-    // Check if the operation should be affected
-    if (!config_should_affect_operation(config->partial_fault->operations_mask, operation)) {
-        return original_size;
+    const fault_rule_t *rule = check_corruption_fault(plan, size);
+    if (!rule) {
+        return false;
     }
     
-    // Check probability
-    if (!check_probability(config->partial_fault->probability)) {
+    corrupt_buffer(plan, rule, buffer, size, detail);
+    return true;
+}
+
+// Get partial size for partial operation faults
+size_t apply_partial_fault(const fault_op_plan_t *plan, size_t original_size) {
+    if (original_size == 0) {
         return original_size;
     }
     
-    // Calculate reduced size
-    size_t new_size = (size_t)(original_size * config->partial_fault->factor);
+    uint32_t count = plan->rule_counts[FS_FAULT_PARTIAL];
+    const fault_rule_t *rules = plan->rules[FS_FAULT_PARTIAL];
     
-    // Ensure at least 1 byte is processed
-    if (new_size == 0) {
-        new_size = 1;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!check_probability(rules[i].probability)) {
+            continue;
+        }
+        
+        // Calculate reduced size
+        size_t new_size = (size_t)(original_size * rules[i].factor);
+        
+        // Ensure at least 1 byte is processed
+        if (new_size == 0) {
+            new_size = 1;
+        }
+        
+        op_stats_count_fault(FS_FAULT_PARTIAL);
+        TRACE3(fault_partial, plan->operation, original_size, new_size);
+        LOG_INFO("Partial fault injected for %s: reduced size from %zu to %zu bytes (factor: %.2f)",
+                fs_op_names[plan->operation], original_size, new_size, rules[i].factor);
+        
+        return new_size;
     }
     
-    LOG_INFO("Partial fault injected for %s: reduced size from %zu to %zu bytes (factor: %.2f)",
-            fs_op_names[operation], original_size, new_size, config->partial_fault->factor);
-    
-    return new_size;
+    return original_size;
 }
 
-// Check if a fault should be triggered for an operation
-bool should_trigger_fault(fs_op_type_t operation) {
-    //LOG_INFO("should_trigger_fault: START for operation %d", operation);
-    fs_config_t *config = config_get_global();
-    //LOG_INFO("should_trigger_fault: Got config, enable_fault_injection=%s", config->enable_fault_injection ? "true" : "false");
-    
-    if (!config->enable_fault_injection) {
-        //LOG_INFO("should_trigger_fault: Fault injection disabled, returning false");
-        return false;
+// Check if a timing/count fault should be triggered for an operation
+bool should_trigger_fault(const fault_op_plan_t *plan) {
+    // Number this operation (the gate has already counted it). The sequence
+    // number claimed here is the count *before* this operation, which is
+    // what the operation count check uses to avoid off-by-one errors in
+    // fault triggering.
+    uint64_t sequence = 0;
+    if (plan->claims_sequence) {
+        sequence = op_stats_next_sequence();
     }
     
-    //LOG_INFO("should_trigger_fault: Counting operation...");
-    // Count this operation - but be careful about timing/count-based faults
-    // We'll count the operation, but check conditions with the OLD count
-    // to avoid off-by-one errors in fault triggering
-    int old_count = stats.operation_count;
-    
-    stats.operation_count++;
-    stats.op_counts[operation]++;
-    
-    //LOG_INFO("should_trigger_fault: Operation counted: %d -> %d", old_count, stats.operation_count);
-    
-    //LOG_INFO("should_trigger_fault: Checking timing conditions...");
     // Check if any timing condition is met (using current time)
-    if (check_timing_fault(operation)) {
-        //LOG_INFO("Fault triggered for %s due to timing condition", fs_op_names[operation]);
+    if (check_timing_fault(plan)) {
+        op_stats_count_fault(FS_FAULT_TIMING);
+        TRACE1(fault_timing, plan->operation);
         return true;
     }
-    //LOG_INFO("should_trigger_fault: No timing fault");
-    
-    //LOG_INFO("should_trigger_fault: Checking operation count conditions...");
-    // Check if any operation count condition is met (using the OLD count to avoid off-by-one)
-    // Temporarily restore old count for the check
-    int new_count = stats.operation_count;
-    stats.operation_count = old_count;
-    bool count_fault = check_operation_count_fault(operation);
-    stats.operation_count = new_count;
-    
-    if (count_fault) {
-        LOG_INFO("Fault triggered for %s due to operation count condition", fs_op_names[operation]);
+    
+    // Check if any operation count condition is met
+    if (check_operation_count_fault(plan, sequence)) {
+        op_stats_count_fault(FS_FAULT_OPCOUNT);
+        TRACE1(fault_opcount, plan->operation);
+        LOG_INFO("Fault triggered for %s due to operation count condition",
+                 fs_op_names[plan->operation]);
         return true;
     }
-    //LOG_INFO("should_trigger_fault: No operation count fault");
     
-    //LOG_INFO("should_trigger_fault: END - returning false");
     // For all other fault types, we'll check them at the point of use
     // rather than here, since they need different handling
     
@@ -381,12 +412,7 @@ bool should_trigger_fault(fs_op_type_t operation) {
 
 // Update operation statistics (e.g., bytes processed)
 void update_operation_stats(fs_op_type_t operation, size_t bytes) {
-    if (operation == FS_OP_READ) {
-        stats.bytes_read += bytes;
-    } else if (operation == FS_OP_WRITE) {
-        stats.bytes_written += bytes;
-    }
+    op_stats_add_bytes(operation, bytes);
     
-    LOG_DEBUG("Operation stats: %s processed %zu bytes (total: read=%zu, written=%zu)",
-             fs_op_names[operation], bytes, stats.bytes_read, stats.bytes_written);
-}
\ No newline at end of file
+    LOG_DEBUG("Operation stats: %s processed %zu bytes", fs_op_names[operation], bytes);
+}
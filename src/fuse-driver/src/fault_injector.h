@@ -3,7 +3,9 @@
 
 #include <stdbool.h>
 #include <stddef.h>  /* For size_t */
+#include <stdint.h>  /* For uint64_t */
 #include "fs_common.h"
+#include "fault_plan.h"
 #include "event_emitter.h"
 
 // Initialize the fault injector
@@ -12,30 +14,55 @@ void fault_injector_init(void);
 // Clean up fault injector resources
 void fault_injector_cleanup(void);
 
-// Check if a fault should be triggered for an operation
-bool should_trigger_fault(fs_op_type_t operation);
+// Replace the active fault rules with those of a configuration file, without
+// remounting. Only the fault sections are applied; the rest of the file
+// (logging, events, [fuse]) keeps its mount-time values. Timing and count
+// rules start counting again. Returns false, keeping the current rules, if
+// the file cannot be read or compiled.
+bool fault_injector_reload(const char *config_file);
+
+// All checks below take the compiled rules for the operation, as returned by
+// fault_plan_lookup(). Callers skip them entirely when that is NULL.
+
+// Check if a timing/count fault should be triggered for an operation
+bool should_trigger_fault(const fault_op_plan_t *plan);
 
 // Update operation statistics (e.g., bytes processed)
 void update_operation_stats(fs_op_type_t operation, size_t bytes);
 
 // Apply an error fault if configured
-bool apply_error_fault(fs_op_type_t operation, int *error_code);
+bool apply_error_fault(const fault_op_plan_t *plan, int *error_code);
+
+// Decide whether a delay fault fires and for how long, without sleeping.
+// Callers that can defer their reply park the operation on the delay
+// scheduler (delay_sched.h) instead of blocking a worker thread.
+bool check_delay_fault(const fault_op_plan_t *plan, int *delay_ms);
+
+// Apply a delay fault if configured (blocks the calling thread)
+bool apply_delay_fault(const fault_op_plan_t *plan);
+
+// Decide whether a corruption fault fires for a buffer of the given size
+// (returns the rule to apply, NULL if none). Nothing is copied or modified,
+// so callers only need a writable copy of the data when this fires.
+const fault_rule_t *check_corruption_fault(const fault_op_plan_t *plan, size_t size);
 
-// Apply a delay fault if configured
-bool apply_delay_fault(fs_op_type_t operation);
+// Corrupt a buffer according to a rule returned by check_corruption_fault()
+// (detail may be NULL if not needed)
+void corrupt_buffer(const fault_op_plan_t *plan, const fault_rule_t *rule, char *buffer,
+                    size_t size, corruption_detail_t *detail);
 
-// Apply a corruption fault if configured (detail may be NULL if not needed)
-bool apply_corruption_fault(fs_op_type_t operation, char *buffer, size_t size,
+// Check and apply a corruption fault in place (detail may be NULL if not needed)
+bool apply_corruption_fault(const fault_op_plan_t *plan, char *buffer, size_t size,
                             corruption_detail_t *detail);
 
 // Get partial size for partial operation faults
-size_t apply_partial_fault(fs_op_type_t operation, size_t original_size);
+size_t apply_partial_fault(const fault_op_plan_t *plan, size_t original_size);
 
 // Helper function to check if a probability threshold is met (for internal use)
 bool check_probability(float probability);
 
 // Individual fault type checkers (for new priority system)
-bool check_timing_fault(fs_op_type_t operation);
-bool check_operation_count_fault(fs_op_type_t operation);
+bool check_timing_fault(const fault_op_plan_t *plan);
+bool check_operation_count_fault(const fault_op_plan_t *plan, uint64_t sequence);
 
 #endif // FAULT_INJECTOR_H
\ No newline at end of file
@@ -0,0 +1,540 @@
+#include "fault_plan.h"
+#include "epoch.h"
+#include "log.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Plan used before one is activated: no operation has rules
+static const fault_plan_t empty_plan;
+
+// Currently active plan
+_Atomic(const fault_plan_t *) fault_plan_active = &empty_plan;
+
+// Plans replaced by a reload, waiting for their readers to finish
+static pthread_mutex_t retired_mutex = PTHREAD_MUTEX_INITIALIZER;
+static fault_plan_t *retired_plans;
+
+// Generation of the last compiled plan
+static atomic_uint_fast32_t last_generation;
+
+// Serializes view compilation (lookups are lock-free)
+static pthread_mutex_t view_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Rule collected from the configuration together with the operations and
+// path pattern it targets
+struct fault_plan_source {
+    fault_rule_t rule;
+    uint32_t operations_mask;
+    int path_index;                 // Bit in the scope (-1 = all paths)
+};
+typedef fault_plan_source_t source_rule_t;
+
+// One compiled view, published by storing key (scope + 1) after view
+struct fault_plan_view_slot {
+    _Atomic uint64_t key;           // 0 = empty
+    _Atomic(fault_plan_t *) view;
+};
+
+// Index of a path pattern, registering it on first use (-1 = all paths, -2
+// = the pattern could not be added)
+static int add_path(fault_plan_t *plan, const char *pattern) {
+    if (!pattern) {
+        return -1;
+    }
+    for (unsigned int i = 0; i < plan->path_count; i++) {
+        if (strcmp(plan->path_patterns[i], pattern) == 0) {
+            return (int)i;
+        }
+    }
+    if (plan->path_count == PATH_MATCH_MAX_PATTERNS) {
+        LOG_ERROR("Fault plan: more than %d distinct path patterns (at %s)",
+                  PATH_MATCH_MAX_PATTERNS, pattern);
+        return -2;
+    }
+    if (!plan->paths && !(plan->paths = path_matcher_create())) {
+        LOG_ERROR("Fault plan: memory allocation failed");
+        return -2;
+    }
+    char *copy = strdup(pattern);
+    if (!copy) {
+        LOG_ERROR("Fault plan: memory allocation failed");
+        return -2;
+    }
+    int res = path_matcher_add(plan->paths, pattern, plan->path_count);
+    if (res != 0) {
+        LOG_ERROR("Fault plan: invalid path pattern '%s'", pattern);
+        free(copy);
+        return -2;
+    }
+    plan->path_patterns[plan->path_count] = copy;
+    return (int)plan->path_count++;
+}
+
+// Append a rule to the source list if it can ever fire. Returns false if
+// its path pattern could not be added.
+static bool add_source(fault_plan_t *plan, source_rule_t *sources, size_t *count,
+                       const fault_rule_t *rule, uint32_t operations_mask, const char *path) {
+    if (operations_mask == 0) {
+        return true;
+    }
+    int path_index = add_path(plan, path);
+    if (path_index == -2) {
+        return false;
+    }
+    sources[*count].rule = *rule;
+    sources[*count].operations_mask = operations_mask;
+    sources[*count].path_index = path_index;
+    (*count)++;
+    return true;
+}
+
+// Count the rules of every fault type in the configuration
+static size_t count_config_rules(const fs_config_t *config) {
+    size_t count = 0;
+    for (const fault_error_t *f = config->error_fault; f; f = f->next) count++;
+    for (const fault_corruption_t *f = config->corruption_fault; f; f = f->next) count++;
+    for (const fault_delay_t *f = config->delay_fault; f; f = f->next) count++;
+    for (const fault_timing_t *f = config->timing_fault; f; f = f->next) count++;
+    for (const fault_operation_count_t *f = config->operation_count_fault; f; f = f->next) count++;
+    for (const fault_partial_t *f = config->partial_fault; f; f = f->next) count++;
+    return count;
+}
+
+// Collect every rule that can fire, dropping the ones that never can.
+// Returns false if a rule's path pattern could not be added: the rule
+// would otherwise be missing from the views of the paths it matches.
+static bool collect_sources(fault_plan_t *plan, const fs_config_t *config,
+                            source_rule_t *sources, size_t *count_out) {
+    size_t count = 0;
+    bool ok = true;
+
+    for (const fault_timing_t *f = config->timing_fault; f; f = f->next) {
+        if (!f->enabled || f->after_minutes <= 0) continue;
+        fault_rule_t rule = { .type = FS_FAULT_TIMING, .after_minutes = f->after_minutes };
+        ok = add_source(plan, sources, &count, &rule, f->operations_mask, f->path) && ok;
+    }
+
+    for (const fault_operation_count_t *f = config->operation_count_fault; f; f = f->next) {
+        if (!f->enabled || (f->every_n_operations <= 0 && f->after_bytes == 0)) continue;
+        fault_rule_t rule = {
+            .type = FS_FAULT_OPCOUNT,
+            .every_n_operations = f->every_n_operations,
+            .after_bytes = f->after_bytes
+        };
+        ok = add_source(plan, sources, &count, &rule, f->operations_mask, f->path) && ok;
+    }
+
+    for (const fault_error_t *f = config->error_fault; f; f = f->next) {
+        if (f->probability <= 0.0f) continue;
+        fault_rule_t rule = {
+            .type = FS_FAULT_ERROR,
+            .probability = f->probability,
+            .error_code = f->error_code
+        };
+        ok = add_source(plan, sources, &count, &rule, f->operations_mask, f->path) && ok;
+    }
+
+    for (const fault_delay_t *f = config->delay_fault; f; f = f->next) {
+        if (f->probability <= 0.0f) continue;
+        fault_rule_t rule = {
+            .type = FS_FAULT_DELAY,
+            .probability = f->probability,
+            .delay_ms = f->delay_ms
+        };
+        ok = add_source(plan, sources, &count, &rule, f->operations_mask, f->path) && ok;
+    }
+
+    for (const fault_partial_t *f = config->partial_fault; f; f = f->next) {
+        if (f->probability <= 0.0f) continue;
+        fault_rule_t rule = {
+            .type = FS_FAULT_PARTIAL,
+            .probability = f->probability,
+            .factor = f->factor
+        };
+        ok = add_source(plan, sources, &count, &rule, f->operations_mask, f->path) && ok;
+    }
+
+    for (const fault_corruption_t *f = config->corruption_fault; f; f = f->next) {
+        if (f->probability <= 0.0f) continue;
+        if (f->percentage < 0.0f || f->percentage > 100.0f) {
+            LOG_ERROR("Invalid corruption percentage: %.1f%% (must be 0-100), rule ignored",
+                      f->percentage);
+            continue;
+        }
+        if (f->percentage == 0.0f) continue;  // Would never change a byte
+        fault_rule_t rule = {
+            .type = FS_FAULT_CORRUPTION,
+            .probability = f->probability,
+            .percentage = f->percentage
+        };
+        ok = add_source(plan, sources, &count, &rule, f->operations_mask, f->path) && ok;
+    }
+
+    *count_out = count;
+    return ok;
+}
+
+// Does a source rule apply to an operation within a scope?
+static bool source_applies(const source_rule_t *source, fs_op_type_t op, bool all_paths,
+                           uint32_t scope) {
+    if (!config_should_affect_operation(source->operations_mask, op)) {
+        return false;
+    }
+    return all_paths || source->path_index < 0 || (scope & (1u << source->path_index));
+}
+
+// Fill plan's rule table from the sources: every rule (all_paths), or the
+// rules of one scope. Returns false on allocation failure.
+static bool build_rules(fault_plan_t *plan, const source_rule_t *sources, size_t source_count,
+                        bool all_paths, uint32_t scope) {
+    for (int op = 0; op < FS_OP_COUNT; op++) {
+        plan->op_plans[op].operation = (fs_op_type_t)op;
+    }
+
+    // An every-N-operations rule numbers *all* operations, so every
+    // operation has to claim a sequence number even if no rule targets it
+    // (on any path, so that views number operations like the full plan)
+    bool claims_sequence = false;
+    for (size_t i = 0; i < source_count; i++) {
+        if (sources[i].rule.type == FS_FAULT_OPCOUNT &&
+            sources[i].rule.every_n_operations > 0) {
+            claims_sequence = true;
+        }
+    }
+
+    // First pass: size the flat rule table
+    size_t total = 0;
+    for (int op = 0; op < FS_OP_COUNT; op++) {
+        for (size_t i = 0; i < source_count; i++) {
+            if (source_applies(&sources[i], (fs_op_type_t)op, all_paths, scope)) {
+                total++;
+            }
+        }
+    }
+
+    if (total > 0) {
+        plan->rules = calloc(total, sizeof(fault_rule_t));
+        if (!plan->rules) {
+            return false;
+        }
+    }
+
+    // Second pass: copy rules grouped by operation, then by fault type
+    size_t next = 0;
+    for (int op = 0; op < FS_OP_COUNT; op++) {
+        fault_op_plan_t *op_plan = &plan->op_plans[op];
+        size_t op_rules = 0;
+
+        for (int type = 0; type < FS_FAULT_COUNT; type++) {
+            op_plan->rules[type] = &plan->rules[next];
+            for (size_t i = 0; i < source_count; i++) {
+                if (sources[i].rule.type == (fs_fault_type_t)type &&
+                    source_applies(&sources[i], (fs_op_type_t)op, all_paths, scope)) {
+                    plan->rules[next++] = sources[i].rule;
+                    op_plan->rule_counts[type]++;
+                    op_rules++;
+                    if (all_paths && sources[i].path_index >= 0) {
+                        op_plan->path_scoped = true;
+                    }
+                }
+            }
+        }
+
+        op_plan->claims_sequence = claims_sequence;
+        if (op_rules > 0 || claims_sequence) {
+            plan->ops[op] = op_plan;
+        }
+    }
+    plan->rule_count = next;
+    return true;
+}
+
+// Compile a configuration into a new plan
+fault_plan_t *fault_plan_compile(const fs_config_t *config) {
+    fault_plan_t *plan = calloc(1, sizeof(fault_plan_t));
+    if (!plan) {
+        LOG_ERROR("Fault plan: memory allocation failed");
+        return NULL;
+    }
+    plan->generation = (uint32_t)atomic_fetch_add(&last_generation, 1) + 1;
+
+    for (int op = 0; op < FS_OP_COUNT; op++) {
+        plan->op_plans[op].operation = (fs_op_type_t)op;
+    }
+
+    if (!config->enable_fault_injection) {
+        return plan;
+    }
+
+    size_t max_sources = count_config_rules(config);
+    if (max_sources == 0) {
+        return plan;
+    }
+
+    plan->sources = calloc(max_sources, sizeof(source_rule_t));
+    if (!plan->sources) {
+        LOG_ERROR("Fault plan: memory allocation failed");
+        fault_plan_free(plan);
+        return NULL;
+    }
+    if (!collect_sources(plan, config, plan->sources, &plan->source_count)) {
+        fault_plan_free(plan);
+        return NULL;
+    }
+    plan->path_scoped = plan->path_count > 0;
+
+    if (plan->path_scoped) {
+        plan->views = calloc(FAULT_PLAN_VIEW_SLOTS, sizeof(fault_plan_view_slot_t));
+    }
+    if ((plan->path_scoped && !plan->views) ||
+        !build_rules(plan, plan->sources, plan->source_count, true, 0)) {
+        LOG_ERROR("Fault plan: memory allocation failed");
+        fault_plan_free(plan);
+        return NULL;
+    }
+
+    if (!plan->path_scoped) {
+        free(plan->sources);
+        plan->sources = NULL;
+        plan->source_count = 0;
+    } else if (fault_plan_view(plan, 0) == plan) {
+        // The view of paths no pattern matches is the fallback of every
+        // other view; compile it up front
+        LOG_ERROR("Fault plan: memory allocation failed");
+        fault_plan_free(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+// Path patterns matching a path
+uint32_t fault_plan_match(const fault_plan_t *plan, const char *path) {
+    return plan->paths && path[0] != '\0' ? path_matcher_match(plan->paths, path) : 0;
+}
+
+static inline size_t view_slot_of(uint32_t scope) {
+    return (size_t)((scope * 0x9E3779B1u) >> 24) & (FAULT_PLAN_VIEW_SLOTS - 1);
+}
+
+// Compiled view for a scope (NULL if not compiled yet). Slots are probed
+// linearly from the scope's hash; views are never removed.
+static const fault_plan_t *find_view(const fault_plan_t *plan, uint32_t scope,
+                                     size_t *free_slot) {
+    uint64_t key = (uint64_t)scope + 1;
+    size_t slot = view_slot_of(scope);
+    for (size_t i = 0; i < FAULT_PLAN_VIEW_SLOTS; i++) {
+        fault_plan_view_slot_t *entry = &plan->views[(slot + i) & (FAULT_PLAN_VIEW_SLOTS - 1)];
+        uint64_t entry_key = atomic_load_explicit(&entry->key, memory_order_acquire);
+        if (entry_key == key) {
+            return atomic_load_explicit(&entry->view, memory_order_relaxed);
+        }
+        if (entry_key == 0) {
+            if (free_slot) {
+                *free_slot = (slot + i) & (FAULT_PLAN_VIEW_SLOTS - 1);
+            }
+            return NULL;
+        }
+    }
+    if (free_slot) {
+        *free_slot = FAULT_PLAN_VIEW_SLOTS;  // Table full
+    }
+    return NULL;
+}
+
+// Rules that apply within a scope
+const fault_plan_t *fault_plan_view(const fault_plan_t *plan, uint32_t scope) {
+    if (!plan->path_scoped) {
+        return plan;
+    }
+
+    const fault_plan_t *view = find_view(plan, scope, NULL);
+    if (view) {
+        return view;
+    }
+
+    pthread_mutex_lock(&view_mutex);
+    size_t slot;
+    view = find_view(plan, scope, &slot);
+    if (!view && slot < FAULT_PLAN_VIEW_SLOTS) {
+        fault_plan_t *compiled = calloc(1, sizeof(fault_plan_t));
+        if (compiled && build_rules(compiled, plan->sources, plan->source_count, false, scope)) {
+            compiled->generation = plan->generation;
+            fault_plan_view_slot_t *entry = &plan->views[slot];
+            atomic_store_explicit(&entry->view, compiled, memory_order_relaxed);
+            atomic_store_explicit(&entry->key, (uint64_t)scope + 1, memory_order_release);
+            view = compiled;
+        } else {
+            fault_plan_free(compiled);
+        }
+    }
+    pthread_mutex_unlock(&view_mutex);
+
+    if (!view) {
+        // No memory (every scope has a slot): only the rules without a path
+        // apply (scope 0 is compiled with the plan)
+        if (scope == 0) {
+            return plan;
+        }
+        static atomic_bool warned;
+        if (!atomic_exchange(&warned, true)) {
+            LOG_WARN("Fault plan: no view for path scope 0x%x, applying unscoped rules only", scope);
+        }
+        return fault_plan_view(plan, 0);
+    }
+    return view;
+}
+
+// A cached match: [plan generation 32][serial 24][scope 8]. Generation 0
+// is the empty plan, which has no paths, so a zeroed cache never hits.
+_Static_assert(PATH_MATCH_MAX_PATTERNS <= 8, "scope must fit the cache word");
+
+#define CACHE_SERIAL_MASK 0xFFFFFFu
+
+static inline uint64_t cache_key(const fault_plan_t *plan, uint32_t serial) {
+    return ((uint64_t)plan->generation << 32) | ((uint64_t)(serial & CACHE_SERIAL_MASK) << 8);
+}
+
+// Scope cached for the plan and serial
+bool fault_plan_cached_scope(const fault_plan_t *plan, const _Atomic uint64_t *cache,
+                             uint32_t serial, uint32_t *scope) {
+    uint64_t cached = atomic_load_explicit(cache, memory_order_relaxed);
+    if ((cached & ~(uint64_t)0xFF) != cache_key(plan, serial)) {
+        return false;
+    }
+    *scope = (uint32_t)(cached & 0xFF);
+    return true;
+}
+
+// Remember a match for the plan and serial
+void fault_plan_cache_scope(const fault_plan_t *plan, _Atomic uint64_t *cache,
+                            uint32_t serial, uint32_t scope) {
+    atomic_store_explicit(cache, cache_key(plan, serial) | scope, memory_order_relaxed);
+}
+
+// View for a path with a per-handle match cache
+const fault_plan_t *fault_plan_view_cached(const fault_plan_t *plan, _Atomic uint64_t *cache,
+                                           const char *path) {
+    if (!plan->path_scoped) {
+        return plan;
+    }
+
+    uint32_t scope;
+    if (!fault_plan_cached_scope(plan, cache, 0, &scope)) {
+        scope = fault_plan_match(plan, path);
+        fault_plan_cache_scope(plan, cache, 0, scope);
+    }
+    return fault_plan_view(plan, scope);
+}
+
+// Free a compiled plan
+void fault_plan_free(fault_plan_t *plan) {
+    if (!plan) {
+        return;
+    }
+    if (plan->views) {
+        for (size_t i = 0; i < FAULT_PLAN_VIEW_SLOTS; i++) {
+            fault_plan_free(atomic_load(&plan->views[i].view));
+        }
+        free(plan->views);
+    }
+    for (unsigned int i = 0; i < plan->path_count; i++) {
+        free(plan->path_patterns[i]);
+    }
+    path_matcher_free(plan->paths);
+    free(plan->sources);
+    free(plan->rules);
+    free(plan);
+}
+
+// Called after each activation
+static void (*activate_hook)(void);
+
+// Make a compiled plan the active one
+void fault_plan_activate(const fault_plan_t *plan) {
+    atomic_store_explicit(&fault_plan_active, plan ? plan : &empty_plan, memory_order_release);
+    if (activate_hook) {
+        activate_hook();
+    }
+}
+
+// Queue a replaced plan for reclamation. Readers that load the active plan
+// after the new epoch starts get its replacement.
+void fault_plan_retire(fault_plan_t *plan) {
+    if (!plan) {
+        return;
+    }
+    pthread_mutex_lock(&retired_mutex);
+    plan->retired_epoch = epoch_advance();
+    plan->retired_next = retired_plans;
+    retired_plans = plan;
+    pthread_mutex_unlock(&retired_mutex);
+    fault_plan_reclaim();
+}
+
+// Free the retired plans no reader or parked call uses anymore. The pin
+// count is checked after the epochs: a pin is taken inside a section, so a
+// plan whose sections have all ended has every pin it will ever get.
+size_t fault_plan_reclaim(void) {
+    size_t remaining = 0;
+    pthread_mutex_lock(&retired_mutex);
+    fault_plan_t **link = &retired_plans;
+    while (*link) {
+        fault_plan_t *plan = *link;
+        if (epoch_passed(plan->retired_epoch) && atomic_load(&plan->pins) == 0) {
+            *link = plan->retired_next;
+            LOG_INFO("Fault plan: freed retired plan (generation %u)", plan->generation);
+            fault_plan_free(plan);
+        } else {
+            link = &plan->retired_next;
+            remaining++;
+        }
+    }
+    pthread_mutex_unlock(&retired_mutex);
+    return remaining;
+}
+
+// Pin a plan for a parked call (the empty plan is never freed)
+void fault_plan_pin(const fault_plan_t *plan) {
+    if (plan != &empty_plan) {
+        atomic_fetch_add(&((fault_plan_t *)plan)->pins, 1);
+    }
+}
+
+// Release a pin
+void fault_plan_unpin(const fault_plan_t *plan) {
+    if (plan != &empty_plan) {
+        atomic_fetch_sub(&((fault_plan_t *)plan)->pins, 1);
+    }
+}
+
+// Set the activation hook
+void fault_plan_set_activate_hook(void (*hook)(void)) {
+    activate_hook = hook;
+}
+
+// Log a summary of a compiled plan
+void fault_plan_dump(const fault_plan_t *plan) {
+    int targeted = 0;
+    for (int op = 0; op < FS_OP_COUNT; op++) {
+        const fault_op_plan_t *op_plan = plan->ops[op];
+        if (!op_plan) {
+            continue;
+        }
+        targeted++;
+        LOG_INFO("Fault plan: %-15s error=%u delay=%u partial=%u corruption=%u timing=%u opcount=%u%s",
+                 fs_op_names[op],
+                 op_plan->rule_counts[FS_FAULT_ERROR],
+                 op_plan->rule_counts[FS_FAULT_DELAY],
+                 op_plan->rule_counts[FS_FAULT_PARTIAL],
+                 op_plan->rule_counts[FS_FAULT_CORRUPTION],
+                 op_plan->rule_counts[FS_FAULT_TIMING],
+                 op_plan->rule_counts[FS_FAULT_OPCOUNT],
+                 op_plan->path_scoped ? " (path-scoped)" : "");
+    }
+    for (unsigned int i = 0; i < plan->path_count; i++) {
+        LOG_INFO("Fault plan: path pattern %u: %s", i, plan->path_patterns[i]);
+    }
+    LOG_INFO("Fault plan: %zu rules, %d of %d operations targeted",
+             plan->rule_count, targeted, FS_OP_COUNT);
+}
@@ -0,0 +1,161 @@
+#ifndef FAULT_PLAN_H
+#define FAULT_PLAN_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "fs_common.h"
+#include "config.h"
+#include "path_match.h"
+
+// Compiled fault plan.
+//
+// At load time the fs_config_t fault sections are compiled into a flat,
+// immutable table indexed by fs_op_type_t. Each entry lists the rules that
+// target the operation, grouped by fault type in priority order. Rules that
+// can never fire (probability <= 0, disabled timing/count sections, masks
+// that exclude the operation) are dropped, so an operation no rule targets
+// has a NULL entry and the wrappers take the passthrough fast path after a
+// single indexed load.
+//
+// Rules with a "path =" pattern only apply to matching paths. The plan's
+// own table holds every rule (what may fire anywhere); the rules for one
+// combination of matching patterns form a view, a plan of its own compiled
+// on first use and kept until the plan is freed. Operations none of whose
+// rules have a path never need a view.
+//
+// A reload compiles a new plan and swaps it in with one atomic store, so
+// readers never lock. Code that reads the active plan runs inside an epoch
+// section (epoch.h); the plan it replaced is retired and freed once every
+// section that may still use it has ended and no parked call pins it.
+
+// One compiled fault rule
+typedef struct {
+    fs_fault_type_t type;     // Fault type this rule injects
+    float probability;        // Error/delay/partial/corruption trigger probability
+    int error_code;           // FS_FAULT_ERROR: error code to return
+    int delay_ms;             // FS_FAULT_DELAY: delay in milliseconds
+    float factor;             // FS_FAULT_PARTIAL: size multiplier
+    float percentage;         // FS_FAULT_CORRUPTION: percentage of bytes to corrupt
+    int after_minutes;        // FS_FAULT_TIMING: trigger after X minutes
+    int every_n_operations;   // FS_FAULT_OPCOUNT: trigger on every Nth operation
+    size_t after_bytes;       // FS_FAULT_OPCOUNT: trigger after X bytes processed
+} fault_rule_t;
+
+// Rules targeting one operation type
+typedef struct {
+    fs_op_type_t operation;
+    const fault_rule_t *rules[FS_FAULT_COUNT];  // First rule of each fault type
+    uint32_t rule_counts[FS_FAULT_COUNT];       // Number of rules of each fault type
+    bool claims_sequence;                       // Operation consumes a sequence number
+    bool path_scoped;                           // Some rule has a path: use the call's view
+} fault_op_plan_t;
+
+// Views a plan can hold (distinct combinations of matching path patterns).
+// A configuration with more than PATH_MATCH_MAX_PATTERNS distinct patterns
+// is rejected (any number of rules can share one).
+#define FAULT_PLAN_VIEW_SLOTS (1u << PATH_MATCH_MAX_PATTERNS)
+
+typedef struct fault_plan_source fault_plan_source_t;
+typedef struct fault_plan_view_slot fault_plan_view_slot_t;
+
+// Complete compiled plan
+typedef struct fault_plan {
+    const fault_op_plan_t *ops[FS_OP_COUNT];  // NULL = no rule targets the operation
+    fault_op_plan_t op_plans[FS_OP_COUNT];
+    fault_rule_t *rules;                      // Flat storage, grouped by operation then type
+    size_t rule_count;
+
+    // Path scoping (unused when no rule has a path)
+    uint32_t generation;                      // Unique per compiled plan (0 = empty plan)
+    bool path_scoped;                         // Some rule has a path pattern
+    path_matcher_t *paths;                    // Patterns, bit i = path_patterns[i]
+    char *path_patterns[PATH_MATCH_MAX_PATTERNS];
+    unsigned int path_count;
+    fault_plan_source_t *sources;             // Rules as configured, to compile views from
+    size_t source_count;
+    fault_plan_view_slot_t *views;            // FAULT_PLAN_VIEW_SLOTS, keyed by scope
+
+    // Reclamation after a reload
+    _Atomic unsigned int pins;                // Parked calls still using the plan
+    uint64_t retired_epoch;                   // Epoch its replacement started
+    struct fault_plan *retired_next;
+} fault_plan_t;
+
+// Currently active plan (an empty plan until one is activated). Read it with
+// fault_plan_current() inside an epoch section.
+extern _Atomic(const fault_plan_t *) fault_plan_active;
+
+// Compile a configuration into a new plan (NULL on allocation failure or
+// when a path pattern is invalid or one too many)
+fault_plan_t *fault_plan_compile(const fs_config_t *config);
+
+// Free a compiled plan
+void fault_plan_free(fault_plan_t *plan);
+
+// Make a compiled plan the active one (NULL reverts to the empty plan).
+// Readers switch with their next lookup; the previous plan stays valid
+// until it is retired and reclaimed.
+void fault_plan_activate(const fault_plan_t *plan);
+
+// Hand over a plan that is no longer active; it is freed by
+// fault_plan_reclaim() once no reader or parked call can still use it
+void fault_plan_retire(fault_plan_t *plan);
+
+// Free the retired plans nothing uses anymore. Returns how many remain.
+size_t fault_plan_reclaim(void);
+
+// Keep the active plan alive across an epoch section, for a call parked
+// past the end of the one it was dispatched in. Each pin needs an unpin.
+void fault_plan_pin(const fault_plan_t *plan);
+void fault_plan_unpin(const fault_plan_t *plan);
+
+// Function called after every fault_plan_activate() (NULL = none), e.g. to
+// drop state cached under the previous rules
+void fault_plan_set_activate_hook(void (*hook)(void));
+
+// Log a summary of a compiled plan
+void fault_plan_dump(const fault_plan_t *plan);
+
+// Active plan
+static inline const fault_plan_t *fault_plan_current(void) {
+    return atomic_load_explicit(&fault_plan_active, memory_order_acquire);
+}
+
+// Rules targeting an operation on any path (NULL = passthrough, no fault
+// can fire). Decisions for a specific call or file use its view.
+static inline const fault_op_plan_t *fault_plan_lookup(fs_op_type_t operation) {
+    return fault_plan_current()->ops[operation];
+}
+
+// Path patterns matching a mount-relative path (the view's scope). An empty
+// path (one the inode table could not build) matches none.
+uint32_t fault_plan_match(const fault_plan_t *plan, const char *path);
+
+// Rules that apply within a scope: the unscoped rules plus those of the
+// matching patterns. The plan itself when it has no path rules; only the
+// unscoped rules if the view cannot be allocated.
+const fault_plan_t *fault_plan_view(const fault_plan_t *plan, uint32_t scope);
+
+// View for a path whose match is cached in *cache (an open handle's, zero
+// initialized). The cache holds the plan generation and the scope, so the
+// path is matched once per handle and again only after the rules change.
+const fault_plan_t *fault_plan_view_cached(const fault_plan_t *plan, _Atomic uint64_t *cache,
+                                           const char *path);
+
+// The same cache for a path that is costly to build, keyed by a serial as
+// well (its low 24 bits), e.g. inode_table_link_generation() read before
+// building the path. fault_plan_cached_scope() returns false when the
+// cache was filled for another plan or serial.
+bool fault_plan_cached_scope(const fault_plan_t *plan, const _Atomic uint64_t *cache,
+                             uint32_t serial, uint32_t *scope);
+void fault_plan_cache_scope(const fault_plan_t *plan, _Atomic uint64_t *cache,
+                            uint32_t serial, uint32_t scope);
+
+// Does the operation plan contain rules of the given fault type?
+static inline bool fault_plan_has(const fault_op_plan_t *op_plan, fs_fault_type_t type) {
+    return op_plan && op_plan->rule_counts[type] > 0;
+}
+
+#endif // FAULT_PLAN_H
@@ -18,5 +18,20 @@ const char *fs_op_names[FS_OP_COUNT] = {
     "chmod",
     "chown",
     "truncate",
-    "utimens"
-};
\ No newline at end of file
+    "utimens",
+    "copy_file_range",
+    "fallocate",
+    "fsync",
+    "flush",
+    "statfs"
+};
+
+// String representation of fault types (for logging and events)
+const char *fs_fault_names[FS_FAULT_COUNT] = {
+    "error",
+    "delay",
+    "partial",
+    "corruption",
+    "timing",
+    "opcount"
+};
@@ -20,11 +20,30 @@ typedef enum {
     FS_OP_CHOWN,
     FS_OP_TRUNCATE,
     FS_OP_UTIMENS,
+    FS_OP_COPY_FILE_RANGE,
+    FS_OP_FALLOCATE,
+    FS_OP_FSYNC,
+    FS_OP_FLUSH,
+    FS_OP_STATFS,
     /* Add new operations here */
     FS_OP_COUNT  /* Total number of operations */
 } fs_op_type_t;
 
+// Fault types (for statistics and event emission)
+typedef enum {
+    FS_FAULT_ERROR = 0,
+    FS_FAULT_DELAY,
+    FS_FAULT_PARTIAL,
+    FS_FAULT_CORRUPTION,
+    FS_FAULT_TIMING,
+    FS_FAULT_OPCOUNT,
+    FS_FAULT_COUNT  /* Total number of fault types */
+} fs_fault_type_t;
+
 // String representation of operation types (for logging and config)
 extern const char *fs_op_names[FS_OP_COUNT];
 
+// String representation of fault types (for logging and events)
+extern const char *fs_fault_names[FS_FAULT_COUNT];
+
 #endif // FS_COMMON_H
\ No newline at end of file
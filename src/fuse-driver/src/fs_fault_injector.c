@@ -1,6 +1,6 @@
-#define FUSE_USE_VERSION 26
+#define FUSE_USE_VERSION 34
 
-#include <fuse.h>
+#include <fuse_lowlevel.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,12 +8,23 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <stddef.h>  /* For offsetof macro */
+#include <stdint.h>
+#include <limits.h>
+#include <linux/falloc.h>  /* FALLOC_FL_KEEP_SIZE */
 
 #include "fs_operations.h"
+#include "inode_table.h"
 #include "fault_injector.h"
+#include "op_stats.h"
 #include "log.h"
 #include "config.h"
 #include "event_emitter.h"
+#include "fault_plan.h"
+#include "buf_pool.h"
+#include "delay_sched.h"
+#include "epoch.h"
+#include "config_reload.h"
+#include "trace.h"
 
 // Define our own help key that doesn't conflict with FUSE's constants
 #define NAS_OPT_KEY_HELP -100
@@ -24,571 +35,1233 @@ struct fs_fault_options {
     char *log_file;
     int log_level;
     char *config_file;
+    char *reload_status;
     int show_help;
 };
 
 // Global configuration
 static fs_config_t *config;
 
-// Wrapper functions that can inject faults
-static int fs_fault_getattr(const char *path, struct stat *stbuf) {
-    LOG_DEBUG(">>> ENTER getattr: %s", path);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_GETATTR);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_GETATTR, &error_code)) {
-        LOG_INFO("Error fault active for getattr: %s, returning error %d", path, error_code);
-        LOG_DEBUG("<<< EXIT getattr: %s (error fault: %d)", path, error_code);
-        return error_code;
+// Nodeids handed to the kernel are inode table pointers (root is FUSE_ROOT_ID)
+static inline fs_inode_t *get_inode(fuse_ino_t ino) {
+    return ino == FUSE_ROOT_ID ? inode_table_root() : (fs_inode_t *)(uintptr_t)ino;
+}
+
+static inline fuse_ino_t get_nodeid(const fs_inode_t *inode) {
+    return inode == inode_table_root() ? FUSE_ROOT_ID : (fuse_ino_t)(uintptr_t)inode;
+}
+
+// One request on its way through the fault gate.
+//
+// Every wrapper fills one of these with its arguments and hands it to
+// fs_call_dispatch(), which applies the fault checks in priority order and
+// then runs the backend step (run), which sends the reply. A delay fault
+// parks a copy of the call on the delay scheduler instead of sleeping, so the
+// worker thread goes back to serving requests; names and write data are
+// copied with it because libfuse only keeps them valid during the callback.
+//
+// The fault gate and the backend step run inside an epoch section, so a
+// reload cannot free the rules under them; a parked call pins its plan.
+typedef struct fs_call fs_call_t;
+typedef void (*fs_call_fn)(fs_call_t *call);
+
+struct fs_call {
+    fs_op_type_t op;             // Operation whose fault rules apply
+    fuse_req_t req;
+    fuse_ino_t ino;              // Target inode (parent for entry operations)
+    const char *name;
+    fuse_ino_t newparent;
+    const char *newname;
+    unsigned int flags;
+    mode_t mode;
+    dev_t rdev;
+    int mask;
+    struct stat attr;            // setattr values
+    int to_set;                  // setattr FUSE_SET_ATTR_* bits
+    size_t size;
+    off_t offset;
+    fs_file_t *file_in;          // copy_file_range source (destination is fi)
+    off_t offset_in;
+    const char *buf;             // write data
+    struct fuse_bufvec *bufv;    // write data left with libfuse (fd path)
+    struct fuse_file_info fi;
+    bool has_fi;
+    const fault_op_plan_t *plan; // Set by fs_call_dispatch()
+    const fault_plan_t *plan_source; // Compiled plan `plan` belongs to
+    fs_call_fn run;              // Backend step, sends the reply
+    fs_call_fn abort;            // Optional: cleanup when a fault fails the call
+    int error;                   // Error for abort
+};
+
+// File handle of a call
+static inline fs_file_t *call_file(const fs_call_t *call) {
+    return call->has_fi ? (fs_file_t *)(uintptr_t)call->fi.fh : NULL;
+}
+
+// Rules for an operation on an open file (path rules matched once per handle)
+static const fault_op_plan_t *file_plan(fs_file_t *file, fs_op_type_t op) {
+    const fault_plan_t *active = fault_plan_current();
+    const fault_op_plan_t *plan = active->ops[op];
+    if (!plan || !plan->path_scoped) {
+        return plan;
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_GETATTR);
-    
-    // Perform the actual operation
-    int result = fs_op_getattr(path, stbuf);
-    LOG_DEBUG("<<< EXIT getattr: %s (result: %d)", path, result);
-    return result;
+    return fault_plan_view_cached(active, &file->fault_scope, file->path)->ops[op];
 }
 
-static int fs_fault_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
-                           off_t offset, struct fuse_file_info *fi) {
-    LOG_DEBUG(">>> ENTER readdir: %s (offset: %ld)", path, offset);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_READDIR);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_READDIR, &error_code)) {
-        LOG_INFO("Error fault active for readdir: %s, returning error %d", path, error_code);
-        LOG_DEBUG("<<< EXIT readdir: %s (error fault: %d)", path, error_code);
-        return error_code;
+// Path patterns matching a path from the inode table. A path it could not
+// build (longer than PATH_MAX, or an inode only known as "." or "..")
+// matches no pattern: only the unscoped rules apply to the call.
+static uint32_t match_built_path(const fault_plan_t *active, const char *path, size_t length) {
+    if (length == 0) {
+        static atomic_bool warned;
+        if (!atomic_exchange(&warned, true)) {
+            LOG_WARN("Path of an inode unknown or longer than %d bytes: "
+                     "path-scoped fault rules do not apply to it", PATH_MAX);
+        }
+        return 0;
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_READDIR);
-    
-    // Perform the actual operation
-    int result = fs_op_readdir(path, buf, filler, offset, fi);
-    LOG_DEBUG("<<< EXIT readdir: %s (result: %d)", path, result);
-    return result;
+    return fault_plan_match(active, path);
 }
 
-static int fs_fault_create(const char *path, mode_t mode, struct fuse_file_info *fi) {
-    LOG_DEBUG(">>> ENTER create: %s (mode: %o)", path, mode);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_CREATE);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_CREATE, &error_code)) {
-        LOG_INFO("Error fault active for create: %s, returning error %d", path, error_code);
-        LOG_DEBUG("<<< EXIT create: %s (error fault: %d)", path, error_code);
-        return error_code;
+// View for an inode's path (the match is cached in the inode until the
+// rules or some parent link change)
+static const fault_plan_t *inode_view(const fault_plan_t *active, fs_inode_t *inode) {
+    uint32_t links = inode_table_link_generation();
+    uint32_t scope;
+    if (!fault_plan_cached_scope(active, &inode->fault_scope, links, &scope)) {
+        char path[PATH_MAX];
+        size_t length = inode_table_path(inode, path, sizeof(path));
+        scope = match_built_path(active, path, length);
+        fault_plan_cache_scope(active, &inode->fault_scope, links, scope);
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_CREATE);
-    
-    // First, check access permissions if the file already exists
-    struct stat st;
-    if (fs_op_getattr(path, &st) == 0) {
-        int res = fs_op_access(path, W_OK);
-        if (res != 0) {
-            LOG_DEBUG("Create denied due to permission check: %s", path);
-            LOG_DEBUG("<<< EXIT create: %s (permission denied: %d)", path, res);
-            return res;
+    return fault_plan_view(active, scope);
+}
+
+// Rules for a call. Path rules are matched against the path the call
+// works on: the open file (cached in its handle), the name in the parent
+// directory for entry operations, or the inode (cached in the inode until
+// the rules or some parent link change).
+static const fault_op_plan_t *call_plan(const fault_plan_t *active, const fs_call_t *call) {
+    const fault_op_plan_t *plan = active->ops[call->op];
+    if (!plan || !plan->path_scoped) {
+        return plan;
+    }
+    if (call->has_fi && call->op != FS_OP_READDIR) {
+        fs_file_t *file = call_file(call);
+        return fault_plan_view_cached(active, &file->fault_scope, file->path)->ops[call->op];
+    }
+
+    if (!call->name) {
+        return inode_view(active, get_inode(call->ino))->ops[call->op];
+    }
+    char path[PATH_MAX];
+    size_t length = inode_table_child_path(get_inode(call->ino), call->name, path, sizeof(path));
+    return fault_plan_view(active, match_built_path(active, path, length))->ops[call->op];
+}
+
+// How long the kernel may cache the attributes and names of an inode
+// ([fuse] attr_timeout, entry_timeout). While a rule targets getattr (which
+// also gates lookup) on the inode's path, nothing about it is cached, so
+// every stat and lookup reaches the fault gate and the rule fires as
+// configured; paths no getattr rule matches keep the configured timeouts.
+static bool getattr_faulted(fs_inode_t *inode) {
+    const fault_plan_t *active = fault_plan_current();
+    const fault_op_plan_t *plan = active->ops[FS_OP_GETATTR];
+    if (!plan || !plan->path_scoped) {
+        return plan != NULL;
+    }
+    return inode_view(active, inode)->ops[FS_OP_GETATTR] != NULL;
+}
+
+static inline double attr_timeout(fs_inode_t *inode) {
+    return getattr_faulted(inode) ? 0.0 : config->attr_timeout;
+}
+
+static inline double entry_timeout(fs_inode_t *inode) {
+    return getattr_faulted(inode) ? 0.0 : config->entry_timeout;
+}
+
+// Reply with a new entry, dropping the lookup reference if the reply fails
+static void reply_entry(fuse_req_t req, fs_inode_t *inode, const struct stat *attr) {
+    struct fuse_entry_param e;
+    memset(&e, 0, sizeof(e));
+    e.ino = get_nodeid(inode);
+    e.attr = *attr;
+    e.attr_timeout = attr_timeout(inode);
+    e.entry_timeout = entry_timeout(inode);
+
+    if (fuse_reply_entry(req, &e) != 0) {
+        inode_table_forget(inode, 1);
+    }
+}
+
+// Scheduler callback: finish a parked call
+static void fs_call_resume(void *arg) {
+    fs_call_t *call = arg;
+    // A setattr dispatches its next gate from run and replaces plan_source
+    const fault_plan_t *pinned = call->plan_source;
+    epoch_enter();
+    TRACE1(stage_entry, call->op);
+    call->run(call);
+    TRACE1(stage_exit, call->op);
+    TRACE2(op_exit, call->op, 0);
+    epoch_exit();
+    fault_plan_unpin(pinned);
+    free(call);
+}
+
+// Park a copy of the call for delay_ms (names and data are copied into the
+// same allocation). Returns 0 or a negative errno if it could not be parked;
+// a write whose data is still in libfuse's buffers cannot be.
+static int fs_call_defer(const fs_call_t *call, int delay_ms) {
+    if (call->bufv) {
+        return -EAGAIN;  // The data is only valid during the callback
+    }
+
+    size_t buf_len = call->buf ? call->size : 0;
+    size_t name_len = call->name ? strlen(call->name) + 1 : 0;
+    size_t newname_len = call->newname ? strlen(call->newname) + 1 : 0;
+
+    fs_call_t *copy = malloc(sizeof(fs_call_t) + buf_len + name_len + newname_len);
+    if (!copy) {
+        return -ENOMEM;
+    }
+    *copy = *call;
+
+    char *extra = (char *)(copy + 1);
+    if (call->buf) {
+        memcpy(extra, call->buf, buf_len);
+        copy->buf = extra;
+        extra += buf_len;
+    }
+    if (call->name) {
+        memcpy(extra, call->name, name_len);
+        copy->name = extra;
+        extra += name_len;
+    }
+    if (call->newname) {
+        memcpy(extra, call->newname, newname_len);
+        copy->newname = extra;
+    }
+
+    // Pinned before submitting: the call may resume before this returns
+    fault_plan_pin(copy->plan_source);
+    int res = delay_sched_submit((unsigned int)delay_ms, fs_call_resume, copy);
+    if (res != 0) {
+        fault_plan_unpin(copy->plan_source);
+        free(copy);
+    }
+    return res;
+}
+
+// Apply the fault checks for a call in priority order, then run it
+static void fs_call_gate(fs_call_t *call) {
+    LOG_DEBUG(">>> ENTER %s", fs_op_names[call->op]);
+    TRACE3(op_entry, call->op, fs_op_names[call->op], call->ino);
+    op_stats_count_op(call->op);
+
+    // Look up the compiled fault rules (NULL = no rule targets this operation)
+    call->plan_source = fault_plan_current();
+    const fault_op_plan_t *plan = call_plan(call->plan_source, call);
+    call->plan = plan;
+    if (plan) {
+        bool data_op = (call->op == FS_OP_READ || call->op == FS_OP_WRITE ||
+                        call->op == FS_OP_COPY_FILE_RANGE || call->op == FS_OP_FALLOCATE);
+
+        // Check timing/count-based faults first
+        bool timing_count_fault = should_trigger_fault(plan);
+
+        // 1. Try error fault (highest precedence - returns error to caller)
+        int error_code = -EIO;
+        if (timing_count_fault || apply_error_fault(plan, &error_code)) {
+            LOG_INFO("Error fault active for %s, returning error %d",
+                     fs_op_names[call->op], error_code);
+            if (data_op) {
+                event_emit_fault(call->op, call_file(call)->path, call->offset, call->size,
+                                 FS_FAULT_ERROR, error_code);
+            }
+            if (call->abort) {
+                call->error = error_code;
+                call->abort(call);
+            } else {
+                fuse_reply_err(call->req, -error_code);
+            }
+            LOG_DEBUG("<<< EXIT %s (error fault: %d)", fs_op_names[call->op], error_code);
+            TRACE2(op_exit, call->op, error_code);
+            return;
+        }
+
+        // 2. Apply delay fault if applicable. The reply is deferred rather
+        // than blocking this worker; if the scheduler cannot take the call,
+        // fall back to sleeping here.
+        int delay_ms = 0;
+        if (check_delay_fault(plan, &delay_ms)) {
+            if (data_op) {
+                event_emit_fault(call->op, call_file(call)->path, call->offset, call->size,
+                                 FS_FAULT_DELAY, 0);
+            }
+            if (delay_ms > 0) {
+                if (fs_call_defer(call, delay_ms) == 0) {
+                    TRACE2(op_defer, call->op, delay_ms);
+                    LOG_DEBUG("<<< EXIT %s (deferred %d ms)", fs_op_names[call->op], delay_ms);
+                    return;
+                }
+                usleep(delay_ms * 1000); // Convert ms to microseconds
+            }
         }
     }
-    
-    int result = fs_op_create(path, mode, fi);
-    LOG_DEBUG("<<< EXIT create: %s (result: %d)", path, result);
-    return result;
+
+    // Perform the actual operation and reply
+    TRACE1(stage_entry, call->op);
+    call->run(call);
+    TRACE1(stage_exit, call->op);
+    LOG_DEBUG("<<< EXIT %s", fs_op_names[call->op]);
+    TRACE2(op_exit, call->op, 0);
 }
 
-static int fs_fault_mknod(const char *path, mode_t mode, dev_t rdev) {
-    LOG_DEBUG(">>> ENTER mknod: %s (mode: %o)", path, mode);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_MKNOD);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_MKNOD, &error_code)) {
-        LOG_INFO("Error fault active for mknod: %s, returning error %d", path, error_code);
-        LOG_DEBUG("<<< EXIT mknod: %s (error fault: %d)", path, error_code);
-        return error_code;
+// Run a call through the fault gate with the active rules
+static void fs_call_dispatch(fs_call_t *call) {
+    epoch_enter();
+    fs_call_gate(call);
+    epoch_exit();
+}
+
+// Run only the backend step of a call that skips the fault gate (it still
+// reads the active rules, e.g. for cache timeouts)
+static void fs_call_run(fs_call_t *call) {
+    epoch_enter();
+    call->run(call);
+    epoch_exit();
+}
+
+// Backend steps. Each runs the passthrough operation for a call that made it
+// through the fault gate and sends the reply.
+
+static void run_lookup(fs_call_t *call) {
+    fs_inode_t *inode;
+    struct stat attr;
+    int res = fs_op_lookup(get_inode(call->ino), call->name, &inode, &attr);
+    // The kernel may remember a missing name ([fuse] negative_timeout) unless
+    // a getattr rule, which gates lookup, matches it (call->plan is the
+    // name's view)
+    double negative = res == -ENOENT && !call->plan ? config->negative_timeout : 0.0;
+    if (negative > 0.0) {
+        // Let the kernel remember the missing name (nodeid 0)
+        struct fuse_entry_param e;
+        memset(&e, 0, sizeof(e));
+        e.entry_timeout = negative;
+        fuse_reply_entry(call->req, &e);
+        return;
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_MKNOD);
-    
-    int result = fs_op_mknod(path, mode, rdev);
-    LOG_DEBUG("<<< EXIT mknod: %s (result: %d)", path, result);
-    return result;
+    if (res != 0) {
+        fuse_reply_err(call->req, -res);
+        return;
+    }
+    reply_entry(call->req, inode, &attr);
 }
 
-static int fs_fault_read(const char *path, char *buf, size_t size, off_t offset,
-                        struct fuse_file_info *fi) {
-    LOG_DEBUG(">>> ENTER read: %s (size: %zu, offset: %ld)", path, size, offset);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_READ);
-    
-    // 1. Try error fault (highest precedence)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_READ, &error_code)) {
-        LOG_INFO("Error fault active for read: %s, returning error %d", path, error_code);
-        LOG_DEBUG("<<< EXIT read: %s (error fault: %d)", path, error_code);
-        event_emit_fault(FS_OP_READ, path, offset, size, "error", error_code);
-        return error_code;
+// With a handle (fstat() from the kernel, or setattr on an open file) the
+// attributes come from the open fd
+static void run_getattr(fs_call_t *call) {
+    struct stat attr;
+    int res = fs_op_getattr(get_inode(call->ino), call_file(call), &attr);
+    if (res != 0) {
+        fuse_reply_err(call->req, -res);
+        return;
     }
-    
-    // 2. Apply delay fault if applicable
-    if (apply_delay_fault(FS_OP_READ)) {
-        event_emit_fault(FS_OP_READ, path, offset, size, "delay", 0);
+    fuse_reply_attr(call->req, &attr, attr_timeout(get_inode(call->ino)));
+}
+
+// setattr is split into the operations the high-level API used to call for
+// it, in the same order (chmod, chown, truncate, utimens), and each one goes
+// through its own fault gate. Returns FS_OP_COUNT when nothing is left.
+static fs_op_type_t setattr_next_op(int to_set, fs_op_type_t after) {
+    if (after < FS_OP_CHMOD && (to_set & FUSE_SET_ATTR_MODE)) {
+        return FS_OP_CHMOD;
     }
-    
-    // Check read permission if no file handle
-    if (fi == NULL) {
-        int res = fs_op_access(path, R_OK);
-        if (res != 0) {
-            LOG_DEBUG("Read denied due to permission check: %s", path);
-            LOG_DEBUG("<<< EXIT read: %s (permission denied: %d)", path, res);
-            return res;
+    if (after < FS_OP_CHOWN && (to_set & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID))) {
+        return FS_OP_CHOWN;
+    }
+    if (after < FS_OP_TRUNCATE && (to_set & FUSE_SET_ATTR_SIZE)) {
+        return FS_OP_TRUNCATE;
+    }
+    if (after < FS_OP_UTIMENS &&
+        (to_set & (FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME |
+                   FUSE_SET_ATTR_ATIME_NOW | FUSE_SET_ATTR_MTIME_NOW))) {
+        return FS_OP_UTIMENS;
+    }
+    return FS_OP_COUNT;
+}
+
+static void run_setattr(fs_call_t *call) {
+    fs_inode_t *inode = get_inode(call->ino);
+    fs_file_t *file = call_file(call);
+    int res = 0;
+
+    switch (call->op) {
+        case FS_OP_CHMOD:
+            res = fs_op_chmod(inode, call->attr.st_mode);
+            break;
+
+        case FS_OP_CHOWN: {
+            uid_t uid = (call->to_set & FUSE_SET_ATTR_UID) ? call->attr.st_uid : (uid_t)-1;
+            gid_t gid = (call->to_set & FUSE_SET_ATTR_GID) ? call->attr.st_gid : (gid_t)-1;
+            res = fs_op_chown(inode, uid, gid);
+            break;
         }
+
+        case FS_OP_TRUNCATE:
+            res = fs_op_truncate(inode, file, call->attr.st_size);
+            break;
+
+        case FS_OP_UTIMENS: {
+            struct timespec ts[2];
+            ts[0].tv_sec = 0;
+            ts[0].tv_nsec = UTIME_OMIT;
+            ts[1] = ts[0];
+            if (call->to_set & FUSE_SET_ATTR_ATIME_NOW) {
+                ts[0].tv_nsec = UTIME_NOW;
+            } else if (call->to_set & FUSE_SET_ATTR_ATIME) {
+                ts[0] = call->attr.st_atim;
+            }
+            if (call->to_set & FUSE_SET_ATTR_MTIME_NOW) {
+                ts[1].tv_nsec = UTIME_NOW;
+            } else if (call->to_set & FUSE_SET_ATTR_MTIME) {
+                ts[1] = call->attr.st_mtim;
+            }
+            res = fs_op_utimens(inode, file, ts);
+            break;
+        }
+
+        default:
+            break;  // Nothing to change, just report the attributes
     }
-    
+
+    if (res != 0) {
+        fuse_reply_err(call->req, -res);
+        return;
+    }
+
+    // Continue with the next attribute change through its own fault gate
+    fs_op_type_t next = setattr_next_op(call->to_set, call->op);
+    if (next != FS_OP_COUNT) {
+        call->op = next;
+        fs_call_dispatch(call);
+        return;
+    }
+
+    run_getattr(call);
+}
+
+// Directory listing context for the readdir filler
+typedef struct {
+    fuse_req_t req;
+    char *buf;
+    size_t size;
+    size_t used;
+    bool plus;
+} readdir_ctx_t;
+
+static int readdir_fill(void *ctx, const char *name, fs_inode_t *inode,
+                        const struct stat *st, off_t next_offset) {
+    readdir_ctx_t *rd = ctx;
+    char *dst = rd->buf + rd->used;
+    size_t room = rd->size - rd->used;
+    size_t entry_size;
+
+    if (rd->plus) {
+        struct fuse_entry_param e;
+        memset(&e, 0, sizeof(e));
+        e.attr = *st;
+        if (inode) {
+            e.ino = get_nodeid(inode);
+            e.attr_timeout = attr_timeout(inode);
+            e.entry_timeout = entry_timeout(inode);
+        }
+        entry_size = fuse_add_direntry_plus(rd->req, dst, room, name, &e, next_offset);
+    } else {
+        entry_size = fuse_add_direntry(rd->req, dst, room, name, st, next_offset);
+    }
+    if (entry_size > room) {
+        return 1;
+    }
+    rd->used += entry_size;
+    return 0;
+}
+
+// readdir and readdirplus (call->flags = 1)
+static void run_readdir(fs_call_t *call) {
+    readdir_ctx_t rd = {
+        .req = call->req,
+        .buf = buf_pool_get(call->size),
+        .size = call->size,
+        .used = 0,
+        .plus = call->flags != 0
+    };
+    if (!rd.buf) {
+        fuse_reply_err(call->req, ENOMEM);
+        return;
+    }
+
+    fs_dir_t *dir = (fs_dir_t *)(uintptr_t)call->fi.fh;
+    int res = fs_op_readdir(dir, call->offset, rd.plus, readdir_fill, &rd);
+    if (res != 0 && rd.used == 0) {
+        fuse_reply_err(call->req, -res);
+    } else {
+        fuse_reply_buf(call->req, rd.buf, rd.used);
+    }
+    buf_pool_put(rd.buf, call->size);
+}
+
+static void run_create(fs_call_t *call) {
+    fs_file_t *file;
+    fs_inode_t *inode;
+    struct fuse_entry_param e;
+    memset(&e, 0, sizeof(e));
+
+    int res = fs_op_create(get_inode(call->ino), call->name, call->mode, call->fi.flags,
+                           &file, &inode, &e.attr);
+    if (res != 0) {
+        fuse_reply_err(call->req, -res);
+        return;
+    }
+
+    e.ino = get_nodeid(inode);
+    e.attr_timeout = attr_timeout(inode);
+    e.entry_timeout = entry_timeout(inode);
+    call->fi.fh = (uint64_t)(uintptr_t)file;
+    call->fi.direct_io = config->direct_io;
+    if (fuse_reply_create(call->req, &e, &call->fi) != 0) {
+        // Request was interrupted: the kernel never saw the file or the entry
+        fs_op_release(file);
+        inode_table_forget(inode, 1);
+    }
+}
+
+static void run_mknod(fs_call_t *call) {
+    fs_inode_t *inode;
+    struct stat attr;
+    int res = fs_op_mknod(get_inode(call->ino), call->name, call->mode, call->rdev,
+                          &inode, &attr);
+    if (res != 0) {
+        fuse_reply_err(call->req, -res);
+        return;
+    }
+    reply_entry(call->req, inode, &attr);
+}
+
+static void run_mkdir(fs_call_t *call) {
+    fs_inode_t *inode;
+    struct stat attr;
+    int res = fs_op_mkdir(get_inode(call->ino), call->name, call->mode, &inode, &attr);
+    if (res != 0) {
+        fuse_reply_err(call->req, -res);
+        return;
+    }
+    reply_entry(call->req, inode, &attr);
+}
+
+// Writes no partial or corruption rule can touch let libfuse move the data
+// from /dev/fuse into the backing fd (splice when the kernel allows it)
+// instead of copying it through a buffer here. Writes that a delay rule
+// could park also need the data in memory.
+static bool write_needs_memory(const fault_op_plan_t *plan) {
+    return fault_plan_has(plan, FS_FAULT_PARTIAL) ||
+           fault_plan_has(plan, FS_FAULT_CORRUPTION) ||
+           fault_plan_has(plan, FS_FAULT_DELAY);
+}
+
+// Read replies are spliced to the kernel (FUSE_CAP_SPLICE_WRITE granted in
+// init); without it libfuse would copy an fd reply through a buffer anyway
+static bool reply_splice;
+
+// Splice an unfaulted read from the backing fd through the thread's pipe
+// into the reply. The count reported is what the splice moved, so a file
+// another writer truncated or extended is counted right. Returns false
+// (nothing replied) when this read has to go through memory instead.
+static bool run_read_pipe(fs_call_t *call) {
+    fs_file_t *file = call_file(call);
+    int pipe_fd;
+    int res = fs_op_read_pipe(file, call->size, call->offset, &pipe_fd);
+    if (res == -EOPNOTSUPP) {
+        return false;
+    }
+
+    event_emit_op(FS_OP_READ, file->path, call->offset, call->size, res);
+
+    if (res > 0) {
+        update_operation_stats(FS_OP_READ, res);
+    }
+    if (res < 0) {
+        fuse_reply_err(call->req, -res);
+        return true;
+    }
+    if (res == 0) {
+        fuse_reply_buf(call->req, NULL, 0);
+        return true;
+    }
+
+    struct fuse_bufvec data = FUSE_BUFVEC_INIT(res);
+    data.buf[0].flags = FUSE_BUF_IS_FD;
+    data.buf[0].fd = pipe_fd;
+    if (fuse_reply_data(call->req, &data, FUSE_BUF_SPLICE_MOVE) != 0) {
+        fs_op_read_pipe_reset();  // Interrupted: the data is still in the pipe
+    }
+    return true;
+}
+
+static void run_read(fs_call_t *call) {
+    fs_file_t *file = call_file(call);
+
+    if (reply_splice && !fault_plan_has(call->plan, FS_FAULT_PARTIAL) &&
+        file->inode->type == S_IFREG && run_read_pipe(call)) {
+        return;
+    }
+
     // 3. Apply partial operation fault if applicable
-    size_t adjusted_size = apply_partial_fault(FS_OP_READ, size);
-    bool had_partial = (adjusted_size != size);
-    
+    size_t adjusted_size = call->plan ? apply_partial_fault(call->plan, call->size) : call->size;
+    bool had_partial = (adjusted_size != call->size);
+
+    char *buf = buf_pool_get(adjusted_size);
+    if (!buf) {
+        fuse_reply_err(call->req, ENOMEM);
+        return;
+    }
+
     // 4. Perform the actual operation
-    int res = fs_op_read(path, buf, adjusted_size, offset, fi);
-    
+    int res = fs_op_read(file, buf, adjusted_size, call->offset);
+
     // Emit events
     if (had_partial) {
-        event_emit_fault(FS_OP_READ, path, offset, size, "partial", res);
+        event_emit_fault(FS_OP_READ, file->path, call->offset, call->size, FS_FAULT_PARTIAL, res);
     } else {
-        event_emit_op(FS_OP_READ, path, offset, size, res);
+        event_emit_op(FS_OP_READ, file->path, call->offset, call->size, res);
     }
-    
-    // Update stats and return
+
+    // Update stats and reply
     if (res > 0) {
         update_operation_stats(FS_OP_READ, res);
     }
-    LOG_DEBUG("<<< EXIT read: %s (result: %d)", path, res);
-    return res;
+    if (res < 0) {
+        fuse_reply_err(call->req, -res);
+    } else {
+        fuse_reply_buf(call->req, buf, res);
+    }
+    buf_pool_put(buf, adjusted_size);
 }
 
-static int fs_fault_write(const char *path, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi) {
-    LOG_DEBUG(">>> ENTER write: %s (size: %zu, offset: %ld)", path, size, offset);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_WRITE);
-    
-    // 1. Try error fault (highest precedence)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_WRITE, &error_code)) {
-        LOG_INFO("Error fault active for write: %s, returning error %d", path, error_code);
-        LOG_DEBUG("<<< EXIT write: %s (error fault: %d)", path, error_code);
-        event_emit_fault(FS_OP_WRITE, path, offset, size, "error", error_code);
-        return error_code;
-    }
-    
-    // 2. Apply delay fault if applicable
-    if (apply_delay_fault(FS_OP_WRITE)) {
-        event_emit_fault(FS_OP_WRITE, path, offset, size, "delay", 0);
-    }
-    
-    // Check write permission if no file handle
-    if (fi == NULL) {
-        int res = fs_op_access(path, W_OK);
-        if (res != 0) {
-            LOG_DEBUG("Write denied due to permission check: %s", path);
-            LOG_DEBUG("<<< EXIT write: %s (permission denied: %d)", path, res);
-            return res;
-        }
-    }
-    
+static void run_write(fs_call_t *call) {
+    fs_file_t *file = call_file(call);
+    const fault_op_plan_t *plan = call->plan;
+
     // 3. Apply partial operation fault if applicable
-    size_t adjusted_size = apply_partial_fault(FS_OP_WRITE, size);
-    bool had_partial = (adjusted_size != size);
-    
-    // 4. Apply corruption fault if applicable
+    size_t adjusted_size = plan ? apply_partial_fault(plan, call->size) : call->size;
+    bool had_partial = (adjusted_size != call->size);
+
+    // 4. Apply corruption fault if applicable. The decision is made first;
+    // only a corrupted write needs a private copy of the caller's data,
+    // taken from the per-thread scratch pool. Untouched writes go straight
+    // through with the request buffer.
     corruption_detail_t corr_detail;
     corr_detail.count = 0;
-    char *corrupted_buf = NULL;
-    char *temp_buf = malloc(adjusted_size);
-    if (temp_buf) {
-        memcpy(temp_buf, buf, adjusted_size);
-        if (apply_corruption_fault(FS_OP_WRITE, temp_buf, adjusted_size, &corr_detail)) {
-            corrupted_buf = temp_buf;
-            temp_buf = NULL;
-        } else {
-            free(temp_buf);
-        }
+    const fault_rule_t *corruption = fault_plan_has(plan, FS_FAULT_CORRUPTION)
+        ? check_corruption_fault(plan, adjusted_size) : NULL;
+    char *corrupted_buf = corruption ? buf_pool_get(adjusted_size) : NULL;
+    if (corrupted_buf) {
+        memcpy(corrupted_buf, call->buf, adjusted_size);
+        corrupt_buffer(plan, corruption, corrupted_buf, adjusted_size, &corr_detail);
+    } else if (corruption) {
+        LOG_ERROR("Corruption fault for write: %s skipped, no scratch buffer", file->path);
     }
-    
+
     // 5. Perform the actual operation
-    const char *final_buf = corrupted_buf ? corrupted_buf : buf;
-    int res = fs_op_write(path, final_buf, adjusted_size, offset, fi);
-    
+    const char *final_buf = corrupted_buf ? corrupted_buf : call->buf;
+    int res = fs_op_write(file, final_buf, adjusted_size, call->offset);
+
     // Emit events
     if (corrupted_buf) {
-        event_emit_corruption(FS_OP_WRITE, path, offset, adjusted_size, &corr_detail);
+        event_emit_corruption(FS_OP_WRITE, file->path, call->offset, adjusted_size, &corr_detail);
     } else if (had_partial) {
-        event_emit_fault(FS_OP_WRITE, path, offset, size, "partial", res);
+        event_emit_fault(FS_OP_WRITE, file->path, call->offset, call->size, FS_FAULT_PARTIAL, res);
     } else {
-        event_emit_op(FS_OP_WRITE, path, offset, size, res);
+        event_emit_op(FS_OP_WRITE, file->path, call->offset, call->size, res);
     }
-    
+
     // Cleanup
-    if (corrupted_buf) {
-        free(corrupted_buf);
-    }
-    
-    // Update stats and return
+    buf_pool_put(corrupted_buf, adjusted_size);
+
+    // Update stats and reply
     if (res > 0) {
         update_operation_stats(FS_OP_WRITE, res);
     }
-    LOG_DEBUG("<<< EXIT write: %s (result: %d)", path, res);
-    return res;
+    if (res < 0) {
+        fuse_reply_err(call->req, -res);
+    } else {
+        fuse_reply_write(call->req, res);
+    }
 }
 
-static int fs_fault_open(const char *path, struct fuse_file_info *fi) {
-    LOG_DEBUG(">>> ENTER open: %s (flags: 0x%x)", path, fi->flags);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_OPEN);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_OPEN, &error_code)) {
-        LOG_DEBUG("<<< EXIT open: %s (error fault: %d)", path, error_code);
-        return error_code;
+static void run_write_fd(fs_call_t *call) {
+    fs_file_t *file = call_file(call);
+    int res = fs_op_write_check(file);
+    if (res == 0) {
+        struct fuse_bufvec dst = FUSE_BUFVEC_INIT(call->size);
+        dst.buf[0].flags = FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK;
+        dst.buf[0].fd = file->fd;
+        dst.buf[0].pos = call->offset;
+        TRACE3(write_entry, file->fd, call->size, call->offset);
+        ssize_t written = fuse_buf_copy(&dst, call->bufv, 0);
+        TRACE2(write_exit, file->fd, (int)written);
+        res = (int)written;
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_OPEN);
-    
-    // Check permissions based on flags
-    if ((fi->flags & O_ACCMODE) == O_RDONLY) {
-        int res = fs_op_access(path, R_OK);
-        if (res != 0) {
-            LOG_DEBUG("<<< EXIT open: %s (permission denied: %d)", path, res);
-            return res;
-        }
-    } else if ((fi->flags & O_ACCMODE) == O_WRONLY) {
-        int res = fs_op_access(path, W_OK);
-        if (res != 0) {
-            LOG_DEBUG("<<< EXIT open: %s (permission denied: %d)", path, res);
-            return res;
-        }
-    } else if ((fi->flags & O_ACCMODE) == O_RDWR) {
-        int res = fs_op_access(path, R_OK | W_OK);
-        if (res != 0) {
-            LOG_DEBUG("<<< EXIT open: %s (permission denied: %d)", path, res);
-            return res;
-        }
+
+    event_emit_op(FS_OP_WRITE, file->path, call->offset, call->size, res);
+
+    if (res > 0) {
+        update_operation_stats(FS_OP_WRITE, res);
+    }
+    if (res < 0) {
+        fuse_reply_err(call->req, -res);
+    } else {
+        fuse_reply_write(call->req, res);
     }
-    
-    int result = fs_op_open(path, fi);
-    LOG_DEBUG("<<< EXIT open: %s (result: %d)", path, result);
-    return result;
 }
 
-static int fs_fault_release(const char *path, struct fuse_file_info *fi) {
-    LOG_DEBUG(">>> ENTER release: %s", path);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_RELEASE);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_RELEASE, &error_code)) {
-        LOG_DEBUG("<<< EXIT release: %s (error fault: %d)", path, error_code);
-        return error_code;
+// Server-side copy: the backing store copies (or shares extents) without the
+// data passing through here. A partial rule shortens the copy, which the
+// caller sees as a short count, like a short write.
+static void run_copy_file_range(fs_call_t *call) {
+    fs_file_t *out = call_file(call);
+
+    // 3. Apply partial operation fault if applicable
+    size_t adjusted_size = call->plan ? apply_partial_fault(call->plan, call->size) : call->size;
+    bool had_partial = (adjusted_size != call->size);
+
+    // 4. Perform the actual operation
+    ssize_t res = fs_op_copy_file_range(call->file_in, call->offset_in, out, call->offset,
+                                        adjusted_size, call->flags);
+
+    // Emit events (destination path and offset)
+    int event_res = res > INT_MAX ? INT_MAX : (int)res;
+    if (had_partial) {
+        event_emit_fault(FS_OP_COPY_FILE_RANGE, out->path, call->offset, call->size,
+                         FS_FAULT_PARTIAL, event_res);
+    } else {
+        event_emit_op(FS_OP_COPY_FILE_RANGE, out->path, call->offset, call->size, event_res);
+    }
+
+    if (res > 0) {
+        update_operation_stats(FS_OP_COPY_FILE_RANGE, (size_t)res);
+    }
+    if (res < 0) {
+        fuse_reply_err(call->req, (int)-res);
+    } else {
+        fuse_reply_write(call->req, (size_t)res);
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_RELEASE);
-    
-    int result = fs_op_release(path, fi);
-    LOG_DEBUG("<<< EXIT release: %s (result: %d)", path, result);
-    return result;
 }
 
-static int fs_fault_mkdir(const char *path, mode_t mode) {
-    LOG_DEBUG(">>> ENTER mkdir: %s (mode: %o)", path, mode);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_MKDIR);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_MKDIR, &error_code)) {
-        LOG_DEBUG("<<< EXIT mkdir: %s (error fault: %d)", path, error_code);
-        return error_code;
+// fallocate has no short count: a partial rule allocates the shortened
+// range and then fails with ENOSPC, as when the disk fills up part way.
+// Only plain allocations (optionally FALLOC_FL_KEEP_SIZE) are shortened.
+static void run_fallocate(fs_call_t *call) {
+    fs_file_t *file = call_file(call);
+    int mode = (int)call->flags;
+
+    // 3. Apply partial operation fault if applicable
+    size_t adjusted_size = call->size;
+    if (call->plan && (mode & ~FALLOC_FL_KEEP_SIZE) == 0) {
+        adjusted_size = apply_partial_fault(call->plan, call->size);
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_MKDIR);
-    
-    int result = fs_op_mkdir(path, mode);
-    LOG_DEBUG("<<< EXIT mkdir: %s (result: %d)", path, result);
-    return result;
+    bool had_partial = (adjusted_size != call->size);
+
+    // 4. Perform the actual operation
+    int res = adjusted_size > 0 ? fs_op_fallocate(file, mode, call->offset, (off_t)adjusted_size) : 0;
+    if (had_partial && res == 0) {
+        res = -ENOSPC;
+    }
+
+    if (had_partial) {
+        event_emit_fault(FS_OP_FALLOCATE, file->path, call->offset, call->size,
+                         FS_FAULT_PARTIAL, res);
+    } else {
+        event_emit_op(FS_OP_FALLOCATE, file->path, call->offset, call->size, res);
+    }
+
+    fuse_reply_err(call->req, -res);
 }
 
-static int fs_fault_rmdir(const char *path) {
-    LOG_DEBUG(">>> ENTER rmdir: %s", path);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_RMDIR);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_RMDIR, &error_code)) {
-        LOG_DEBUG("<<< EXIT rmdir: %s (error fault: %d)", path, error_code);
-        return error_code;
+static void run_open(fs_call_t *call) {
+    fs_file_t *file;
+    int res = fs_op_open(get_inode(call->ino), call->fi.flags, &file);
+    if (res != 0) {
+        fuse_reply_err(call->req, -res);
+        return;
+    }
+
+    call->fi.fh = (uint64_t)(uintptr_t)file;
+    call->fi.direct_io = config->direct_io;
+    if (fuse_reply_open(call->req, &call->fi) != 0) {
+        fs_op_release(file);  // Request was interrupted
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_RMDIR);
-    
-    int result = fs_op_rmdir(path);
-    LOG_DEBUG("<<< EXIT rmdir: %s (result: %d)", path, result);
-    return result;
 }
 
-static int fs_fault_unlink(const char *path) {
-    LOG_DEBUG(">>> ENTER unlink: %s", path);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_UNLINK);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_UNLINK, &error_code)) {
-        LOG_DEBUG("<<< EXIT unlink: %s (error fault: %d)", path, error_code);
-        return error_code;
+static void run_release(fs_call_t *call) {
+    int res = fs_op_release(call_file(call));
+    fuse_reply_err(call->req, -res);
+}
+
+// A faulted release still has to close the handle: the kernel never
+// sends another release for it
+static void abort_release(fs_call_t *call) {
+    fs_op_release(call_file(call));
+    fuse_reply_err(call->req, -call->error);
+}
+
+static void run_fsync(fs_call_t *call) {
+    fuse_reply_err(call->req, -fs_op_fsync(call_file(call), call->flags != 0));
+}
+
+static void run_flush(fs_call_t *call) {
+    fuse_reply_err(call->req, -fs_op_flush(call_file(call)));
+}
+
+static void run_statfs(fs_call_t *call) {
+    struct statvfs stbuf;
+    int res = fs_op_statfs(get_inode(call->ino), &stbuf);
+    if (res != 0) {
+        fuse_reply_err(call->req, -res);
+        return;
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_UNLINK);
-    
-    int result = fs_op_unlink(path);
-    LOG_DEBUG("<<< EXIT unlink: %s (result: %d)", path, result);
-    return result;
+    fuse_reply_statfs(call->req, &stbuf);
 }
 
-static int fs_fault_rename(const char *path, const char *newpath) {
-    LOG_DEBUG(">>> ENTER rename: %s to %s", path, newpath);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_RENAME);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_RENAME, &error_code)) {
-        LOG_DEBUG("<<< EXIT rename: %s to %s (error fault: %d)", path, newpath, error_code);
-        return error_code;
+static void run_rmdir(fs_call_t *call) {
+    fuse_reply_err(call->req, -fs_op_rmdir(get_inode(call->ino), call->name));
+}
+
+static void run_unlink(fs_call_t *call) {
+    fuse_reply_err(call->req, -fs_op_unlink(get_inode(call->ino), call->name));
+}
+
+static void run_rename(fs_call_t *call) {
+    fuse_reply_err(call->req, -fs_op_rename(get_inode(call->ino), call->name,
+                                            get_inode(call->newparent), call->newname,
+                                            call->flags));
+}
+
+static void run_access(fs_call_t *call) {
+    fuse_reply_err(call->req, -fs_op_access(get_inode(call->ino), call->mask));
+}
+
+// Low-level operation wrappers. Each captures its arguments and goes through
+// the fault gate for the operation the high-level driver used to expose.
+
+// Session the kernel cache notifications go to (set while mounted)
+static struct fuse_session *session;
+
+// Inodes and names collected for invalidation
+typedef struct {
+    fuse_ino_t *inodes;
+    size_t inode_count;
+    size_t inode_capacity;
+    fuse_ino_t *parents;         // Parent of names[i]
+    char **names;
+    size_t name_count;
+    size_t name_capacity;
+    bool failed;
+} cache_walk_t;
+
+static void cache_walk_collect(const fs_inode_t *inode, void *ctx) {
+    cache_walk_t *walk = ctx;
+    if (walk->failed) {
+        return;
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_RENAME);
-    
-    int result = fs_op_rename(path, newpath);
-    LOG_DEBUG("<<< EXIT rename: %s to %s (result: %d)", path, newpath, result);
-    return result;
+
+    if (walk->inode_count == walk->inode_capacity) {
+        size_t capacity = walk->inode_capacity ? walk->inode_capacity * 2 : 256;
+        fuse_ino_t *inodes = realloc(walk->inodes, capacity * sizeof(*inodes));
+        if (!inodes) {
+            walk->failed = true;
+            return;
+        }
+        walk->inodes = inodes;
+        walk->inode_capacity = capacity;
+    }
+    walk->inodes[walk->inode_count++] = get_nodeid(inode);
+
+    if (!inode->parent || !inode->name || !inode->name[0]) {
+        return;
+    }
+    if (walk->name_count == walk->name_capacity) {
+        size_t capacity = walk->name_capacity ? walk->name_capacity * 2 : 256;
+        fuse_ino_t *parents = realloc(walk->parents, capacity * sizeof(*parents));
+        if (parents) {
+            walk->parents = parents;
+        }
+        char **names = realloc(walk->names, capacity * sizeof(*names));
+        if (names) {
+            walk->names = names;
+        }
+        if (!parents || !names) {
+            walk->failed = true;
+            return;
+        }
+        walk->name_capacity = capacity;
+    }
+    char *name = strdup(inode->name);
+    if (!name) {
+        walk->failed = true;
+        return;
+    }
+    walk->parents[walk->name_count] = get_nodeid(inode->parent);
+    walk->names[walk->name_count++] = name;
 }
 
-static int fs_fault_access(const char *path, int mode) {
-    LOG_DEBUG(">>> ENTER access: %s (mode: %d)", path, mode);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_ACCESS);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_ACCESS, &error_code)) {
-        LOG_DEBUG("<<< EXIT access: %s (error fault: %d)", path, error_code);
-        return error_code;
+// Drop what the kernel caches about our inodes (attributes, data, names)
+// when the fault rules change, so the next access goes through the new
+// rules and timeouts. Cached missing names expire after negative_timeout.
+// The notifications are sent without the inode table locked: invalidating a
+// name takes the directory lock in the kernel, which a lookup waiting on
+// the table may hold.
+static void kernel_cache_invalidate(void) {
+    if (!session) {
+        return;
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_ACCESS);
-    
-    int result = fs_op_access(path, mode);
-    LOG_DEBUG("<<< EXIT access: %s (result: %d)", path, result);
-    return result;
+
+    cache_walk_t walk;
+    memset(&walk, 0, sizeof(walk));
+    inode_table_foreach(cache_walk_collect, &walk);
+    if (walk.failed) {
+        LOG_WARN("Kernel cache invalidation incomplete: out of memory");
+    }
+
+    for (size_t i = 0; i < walk.name_count; i++) {
+        fuse_lowlevel_notify_inval_entry(session, walk.parents[i], walk.names[i],
+                                         strlen(walk.names[i]));
+        free(walk.names[i]);
+    }
+    for (size_t i = 0; i < walk.inode_count; i++) {
+        fuse_lowlevel_notify_inval_inode(session, walk.inodes[i], 0, 0);
+    }
+    LOG_INFO("Fault rules changed: invalidated %zu kernel inodes and %zu names",
+             walk.inode_count, walk.name_count);
+
+    free(walk.inodes);
+    free(walk.parents);
+    free(walk.names);
 }
 
-static int fs_fault_chmod(const char *path, mode_t mode) {
-    LOG_DEBUG(">>> ENTER chmod: %s (mode: %o)", path, mode);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_CHMOD);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_CHMOD, &error_code)) {
-        LOG_DEBUG("<<< EXIT chmod: %s (error fault: %d)", path, error_code);
-        return error_code;
+// Let libfuse splice read replies, and write requests too unless the rules
+// loaded at mount time keep write data in memory anyway (splicing a request
+// into a pipe costs an extra copy for everything that is not a write_buf).
+// Ask for readdirplus (the kernel picks it adaptively).
+static void fs_fault_init(void *userdata, struct fuse_conn_info *conn) {
+    (void)userdata;
+
+    unsigned int want = FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE |
+                        FUSE_CAP_READDIRPLUS | FUSE_CAP_READDIRPLUS_AUTO;
+    epoch_enter();
+    if (!write_needs_memory(fault_plan_lookup(FS_OP_WRITE))) {
+        want |= FUSE_CAP_SPLICE_READ;
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_CHMOD);
-    
-    // Check write permission
-    int res = fs_op_access(path, W_OK);
-    if (res != 0) {
-        LOG_DEBUG("<<< EXIT chmod: %s (permission denied: %d)", path, res);
-        return res;
+    epoch_exit();
+    if (config->writeback_cache) {
+        want |= FUSE_CAP_WRITEBACK_CACHE;
     }
-    
-    int result = fs_op_chmod(path, mode);
-    LOG_DEBUG("<<< EXIT chmod: %s (result: %d)", path, result);
-    return result;
+    conn->want |= conn->capable & want;
+    reply_splice = (conn->want & FUSE_CAP_SPLICE_WRITE) != 0;
+    LOG_INFO("FUSE splice: reply %s, write requests %s",
+             (conn->want & FUSE_CAP_SPLICE_WRITE) ? "on" : "off",
+             (conn->want & FUSE_CAP_SPLICE_READ) ? "on" : "off");
+
+    // [fuse] tuning; 0 keeps what libfuse and the kernel chose
+    if (config->max_write) {
+        conn->max_write = config->max_write;
+    }
+    if (config->max_read) {
+        conn->max_read = config->max_read;  // Also passed as the max_read mount option
+    }
+    if (config->max_background) {
+        conn->max_background = config->max_background;
+    }
+    if (config->congestion_threshold) {
+        conn->congestion_threshold = config->congestion_threshold;
+    }
+    bool writeback = (conn->want & FUSE_CAP_WRITEBACK_CACHE) != 0;
+    if (config->writeback_cache && !writeback) {
+        LOG_WARN("Kernel does not offer the write-back cache, writes stay write-through");
+    }
+    fs_ops_set_writeback(writeback);
+    LOG_INFO("FUSE tuning: max_write %u, max_read %u, max_background %u, congestion_threshold %u, "
+             "write-back cache %s, direct_io %s",
+             conn->max_write, conn->max_read, conn->max_background, conn->congestion_threshold,
+             writeback ? "on" : "off", config->direct_io ? "on" : "off");
 }
 
-static int fs_fault_chown(const char *path, uid_t uid, gid_t gid) {
-    LOG_DEBUG(">>> ENTER chown: %s (uid: %d, gid: %d)", path, uid, gid);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_CHOWN);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_CHOWN, &error_code)) {
-        LOG_DEBUG("<<< EXIT chown: %s (error fault: %d)", path, error_code);
-        return error_code;
+static void fs_fault_lookup(fuse_req_t req, fuse_ino_t parent, const char *name) {
+    // The high-level API resolved names with getattr, so getattr rules apply
+    fs_call_t call = { .op = FS_OP_GETATTR, .req = req, .ino = parent, .name = name,
+                       .run = run_lookup };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_forget(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup) {
+    inode_table_forget(get_inode(ino), nlookup);
+    fuse_reply_none(req);
+}
+
+static void fs_fault_forget_multi(fuse_req_t req, size_t count, struct fuse_forget_data *forgets) {
+    for (size_t i = 0; i < count; i++) {
+        inode_table_forget(get_inode(forgets[i].ino), forgets[i].nlookup);
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_CHOWN);
-    
-    // Check write permission
-    int res = fs_op_access(path, W_OK);
-    if (res != 0) {
-        LOG_DEBUG("<<< EXIT chown: %s (permission denied: %d)", path, res);
-        return res;
+    fuse_reply_none(req);
+}
+
+static void fs_fault_getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    fs_call_t call = { .op = FS_OP_GETATTR, .req = req, .ino = ino, .run = run_getattr };
+    if (fi) {
+        call.fi = *fi;
+        call.has_fi = true;
     }
-    
-    int result = fs_op_chown(path, uid, gid);
-    LOG_DEBUG("<<< EXIT chown: %s (result: %d)", path, result);
-    return result;
+    fs_call_dispatch(&call);
 }
 
-static int fs_fault_truncate(const char *path, off_t size) {
-    LOG_DEBUG(">>> ENTER truncate: %s (size: %ld)", path, size);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_TRUNCATE);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_TRUNCATE, &error_code)) {
-        LOG_DEBUG("<<< EXIT truncate: %s (error fault: %d)", path, error_code);
-        return error_code;
+static void fs_fault_setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr,
+                             int to_set, struct fuse_file_info *fi) {
+    fs_call_t call = { .req = req, .ino = ino, .attr = *attr, .to_set = to_set,
+                       .run = run_setattr };
+    if (fi) {
+        call.fi = *fi;
+        call.has_fi = true;
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_TRUNCATE);
-    
-    // Check write permission
-    int res = fs_op_access(path, W_OK);
+
+    call.op = setattr_next_op(to_set, FS_OP_GETATTR);
+    if (call.op == FS_OP_COUNT) {
+        call.op = FS_OP_GETATTR;  // No change we model, only report attributes
+    }
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    fs_dir_t *dir;
+    int res = fs_op_opendir(get_inode(ino), &dir);
     if (res != 0) {
-        LOG_DEBUG("<<< EXIT truncate: %s (permission denied: %d)", path, res);
-        return res;
+        fuse_reply_err(req, -res);
+        return;
+    }
+
+    fi->fh = (uint64_t)(uintptr_t)dir;
+    if (fuse_reply_open(req, fi) != 0) {
+        fs_op_releasedir(dir);  // Request was interrupted
     }
-    
-    int result = fs_op_truncate(path, size);
-    LOG_DEBUG("<<< EXIT truncate: %s (result: %d)", path, result);
-    return result;
 }
 
-static int fs_fault_utimens(const char *path, const struct timespec ts[2]) {
-    LOG_DEBUG(">>> ENTER utimens: %s", path);
-    
-    // Check timing/count-based faults first
-    bool timing_count_fault = should_trigger_fault(FS_OP_UTIMENS);
-    
-    // Try each fault type in order of precedence
-    
-    // 1. Try error fault (highest precedence - returns error to caller)
-    int error_code = -EIO;
-    if (timing_count_fault || apply_error_fault(FS_OP_UTIMENS, &error_code)) {
-        LOG_DEBUG("<<< EXIT utimens: %s (error fault: %d)", path, error_code);
-        return error_code;
+static void fs_fault_readdir_common(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                                    struct fuse_file_info *fi, bool plus) {
+    fs_call_t call = { .op = FS_OP_READDIR, .req = req, .ino = ino, .size = size,
+                       .offset = off, .flags = plus, .fi = *fi, .has_fi = true,
+                       .run = run_readdir };
+
+    // The high-level API listed a directory with one readdir call; only the
+    // first chunk of a listing goes through the fault gate
+    if (off == 0) {
+        fs_call_dispatch(&call);
+    } else {
+        fs_call_run(&call);
     }
-    
-    // 2. Apply delay fault if applicable
-    apply_delay_fault(FS_OP_UTIMENS);
-    
-    // Check write permission
-    int res = fs_op_access(path, W_OK);
-    if (res != 0) {
-        LOG_DEBUG("<<< EXIT utimens: %s (permission denied: %d)", path, res);
-        return res;
-    }
-    
-    int result = fs_op_utimens(path, ts);
-    LOG_DEBUG("<<< EXIT utimens: %s (result: %d)", path, result);
-    return result;
-}
-
-static struct fuse_operations fs_fault_oper = {
-    .getattr  = fs_fault_getattr,
-    .readdir  = fs_fault_readdir,
-    .mknod    = fs_fault_mknod,
-    .mkdir    = fs_fault_mkdir,
-    .unlink   = fs_fault_unlink,
-    .rmdir    = fs_fault_rmdir,
-    .rename   = fs_fault_rename,
-    .open     = fs_fault_open,
-    .read     = fs_fault_read,
-    .write    = fs_fault_write,
-    .release  = fs_fault_release,
-    .create   = fs_fault_create,
-    .chmod    = fs_fault_chmod,
-    .chown    = fs_fault_chown,
-    .truncate = fs_fault_truncate,
-    .utimens  = fs_fault_utimens,
-    .access   = fs_fault_access,
+}
+
+static void fs_fault_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                             struct fuse_file_info *fi) {
+    fs_fault_readdir_common(req, ino, size, off, fi, false);
+}
+
+static void fs_fault_readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                                 struct fuse_file_info *fi) {
+    fs_fault_readdir_common(req, ino, size, off, fi, true);
+}
+
+static void fs_fault_releasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    (void)ino;
+    fuse_reply_err(req, -fs_op_releasedir((fs_dir_t *)(uintptr_t)fi->fh));
+}
+
+static void fs_fault_create(fuse_req_t req, fuse_ino_t parent, const char *name,
+                            mode_t mode, struct fuse_file_info *fi) {
+    fs_call_t call = { .op = FS_OP_CREATE, .req = req, .ino = parent, .name = name,
+                       .mode = mode, .fi = *fi, .has_fi = true, .run = run_create };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_mknod(fuse_req_t req, fuse_ino_t parent, const char *name,
+                           mode_t mode, dev_t rdev) {
+    fs_call_t call = { .op = FS_OP_MKNOD, .req = req, .ino = parent, .name = name,
+                       .mode = mode, .rdev = rdev, .run = run_mknod };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode) {
+    fs_call_t call = { .op = FS_OP_MKDIR, .req = req, .ino = parent, .name = name,
+                       .mode = mode, .run = run_mkdir };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                          struct fuse_file_info *fi) {
+    fs_call_t call = { .op = FS_OP_READ, .req = req, .ino = ino, .size = size,
+                       .offset = off, .fi = *fi, .has_fi = true, .run = run_read };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_write_buf(fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec *bufv,
+                               off_t off, struct fuse_file_info *fi) {
+    fs_call_t call = { .op = FS_OP_WRITE, .req = req, .ino = ino, .size = fuse_buf_size(bufv),
+                       .offset = off, .fi = *fi, .has_fi = true, .run = run_write };
+
+    // A reload landing between this check and the dispatch can send the write
+    // down the fd path with rules that want its data; it then skips their
+    // partial and corruption faults (error and delay faults still apply)
+    epoch_enter();
+    bool needs_memory = write_needs_memory(file_plan(call_file(&call), FS_OP_WRITE));
+    epoch_exit();
+    if (!needs_memory) {
+        call.bufv = bufv;
+        call.run = run_write_fd;
+        fs_call_dispatch(&call);
+        return;
+    }
+
+    // The data may be changed or parked: hand run_write a memory buffer.
+    // libfuse passes one when it did not read the request with splice.
+    const struct fuse_buf *in = &bufv->buf[bufv->idx];
+    if (bufv->count - bufv->idx == 1 && !(in->flags & FUSE_BUF_IS_FD)) {
+        call.buf = (const char *)in->mem + bufv->off;
+        fs_call_dispatch(&call);
+        return;
+    }
+
+    size_t capacity = call.size;
+    char *buf = buf_pool_get(capacity);
+    if (!buf) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    struct fuse_bufvec mem = FUSE_BUFVEC_INIT(capacity);
+    mem.buf[0].mem = buf;
+    ssize_t copied = fuse_buf_copy(&mem, bufv, 0);
+    if (copied < 0) {
+        fuse_reply_err(req, (int)-copied);
+    } else {
+        call.buf = buf;
+        call.size = (size_t)copied;
+        fs_call_dispatch(&call);
+    }
+    buf_pool_put(buf, capacity);
+}
+
+static void fs_fault_copy_file_range(fuse_req_t req, fuse_ino_t ino_in, off_t off_in,
+                                     struct fuse_file_info *fi_in, fuse_ino_t ino_out,
+                                     off_t off_out, struct fuse_file_info *fi_out,
+                                     size_t len, int flags) {
+    (void)ino_in;
+    fs_call_t call = { .op = FS_OP_COPY_FILE_RANGE, .req = req, .ino = ino_out, .size = len,
+                       .offset = off_out, .file_in = (fs_file_t *)(uintptr_t)fi_in->fh,
+                       .offset_in = off_in, .flags = (unsigned int)flags, .fi = *fi_out,
+                       .has_fi = true, .run = run_copy_file_range };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_fallocate(fuse_req_t req, fuse_ino_t ino, int mode, off_t offset,
+                               off_t length, struct fuse_file_info *fi) {
+    fs_call_t call = { .op = FS_OP_FALLOCATE, .req = req, .ino = ino, .size = (size_t)length,
+                       .offset = offset, .flags = (unsigned int)mode, .fi = *fi, .has_fi = true,
+                       .run = run_fallocate };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    fs_call_t call = { .op = FS_OP_OPEN, .req = req, .ino = ino, .fi = *fi, .has_fi = true,
+                       .run = run_open };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    fs_call_t call = { .op = FS_OP_RELEASE, .req = req, .ino = ino, .fi = *fi, .has_fi = true,
+                       .run = run_release, .abort = abort_release };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_fsync(fuse_req_t req, fuse_ino_t ino, int datasync,
+                           struct fuse_file_info *fi) {
+    fs_call_t call = { .op = FS_OP_FSYNC, .req = req, .ino = ino, .flags = datasync != 0,
+                       .fi = *fi, .has_fi = true, .run = run_fsync };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_flush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    fs_call_t call = { .op = FS_OP_FLUSH, .req = req, .ino = ino, .fi = *fi, .has_fi = true,
+                       .run = run_flush };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_statfs(fuse_req_t req, fuse_ino_t ino) {
+    fs_call_t call = { .op = FS_OP_STATFS, .req = req, .ino = ino, .run = run_statfs };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_rmdir(fuse_req_t req, fuse_ino_t parent, const char *name) {
+    fs_call_t call = { .op = FS_OP_RMDIR, .req = req, .ino = parent, .name = name,
+                       .run = run_rmdir };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_unlink(fuse_req_t req, fuse_ino_t parent, const char *name) {
+    fs_call_t call = { .op = FS_OP_UNLINK, .req = req, .ino = parent, .name = name,
+                       .run = run_unlink };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_rename(fuse_req_t req, fuse_ino_t parent, const char *name,
+                            fuse_ino_t newparent, const char *newname, unsigned int flags) {
+    fs_call_t call = { .op = FS_OP_RENAME, .req = req, .ino = parent, .name = name,
+                       .newparent = newparent, .newname = newname, .flags = flags,
+                       .run = run_rename };
+    fs_call_dispatch(&call);
+}
+
+static void fs_fault_access(fuse_req_t req, fuse_ino_t ino, int mask) {
+    fs_call_t call = { .op = FS_OP_ACCESS, .req = req, .ino = ino, .mask = mask,
+                       .run = run_access };
+    fs_call_dispatch(&call);
+}
+
+static const struct fuse_lowlevel_ops fs_fault_oper = {
+    .init         = fs_fault_init,
+    .lookup       = fs_fault_lookup,
+    .forget       = fs_fault_forget,
+    .forget_multi = fs_fault_forget_multi,
+    .getattr      = fs_fault_getattr,
+    .setattr      = fs_fault_setattr,
+    .mknod        = fs_fault_mknod,
+    .mkdir        = fs_fault_mkdir,
+    .unlink       = fs_fault_unlink,
+    .rmdir        = fs_fault_rmdir,
+    .rename       = fs_fault_rename,
+    .open         = fs_fault_open,
+    .read         = fs_fault_read,
+    .write_buf    = fs_fault_write_buf,
+    .copy_file_range = fs_fault_copy_file_range,
+    .fallocate    = fs_fault_fallocate,
+    .flush        = fs_fault_flush,
+    .release      = fs_fault_release,
+    .fsync        = fs_fault_fsync,
+    .opendir      = fs_fault_opendir,
+    .readdir      = fs_fault_readdir,
+    .readdirplus  = fs_fault_readdirplus,
+    .releasedir   = fs_fault_releasedir,
+    .create       = fs_fault_create,
+    .access       = fs_fault_access,
+    .statfs       = fs_fault_statfs,
 };
 
 // Helper function to display usage information
@@ -600,15 +1273,13 @@ static void show_help(const char *progname) {
     printf("    --log=PATH             Path to log file (default: stdout)\n");
     printf("    --loglevel=LEVEL       Log level (0-3, default: 2)\n");
     printf("    --config=PATH          Path to configuration file\n");
+    printf("    --reload-status=PATH   File where each SIGHUP reload publishes its outcome\n");
     printf("    -h, --help             Display this help message\n\n");
     printf("FUSE options:\n");
     
     // Let FUSE print its help message
-    struct fuse_args args = FUSE_ARGS_INIT(0, NULL);
-    fuse_opt_add_arg(&args, progname);
-    fuse_opt_add_arg(&args, "-h");
-    fuse_parse_cmdline(&args, NULL, NULL, NULL);
-    fuse_opt_free_args(&args);
+    fuse_cmdline_help();
+    fuse_lowlevel_help();
 }
 
 // FUSE option processing function
@@ -644,18 +1315,23 @@ static struct fuse_opt fs_fault_opts[] = {
     {"--log=%s", offsetof(struct fs_fault_options, log_file), 0},
     {"--loglevel=%d", offsetof(struct fs_fault_options, log_level), 0},
     {"--config=%s", offsetof(struct fs_fault_options, config_file), 0},
+    {"--reload-status=%s", offsetof(struct fs_fault_options, reload_status), 0},
     {"-h", NAS_OPT_KEY_HELP, 0}, // Using our custom help key
     {"--help", NAS_OPT_KEY_HELP, 0}, // Using our custom help key
     FUSE_OPT_END
 };
 
+
 int main(int argc, char *argv[]) {
-    int ret;
+    int ret = 1;
     struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
     struct fs_fault_options options;
+    struct fuse_cmdline_opts opts;
+    struct fuse_session *se = NULL;
     
     // Set default option values
     memset(&options, 0, sizeof(options));
+    memset(&opts, 0, sizeof(opts));
     
     // Parse command line options
     if (fuse_opt_parse(&args, &options, fs_fault_opts, fs_fault_opt_proc) == -1) {
@@ -669,6 +1345,17 @@ int main(int argc, char *argv[]) {
         return 0;
     }
     
+    // Parse the generic FUSE options (mountpoint, -f, -s, -d, clone_fd, ...)
+    if (fuse_parse_cmdline(&args, &opts) != 0) {
+        fuse_opt_free_args(&args);
+        return 1;
+    }
+    if (!opts.mountpoint) {
+        fprintf(stderr, "Usage: %s mountpoint [options] (see --help)\n", argv[0]);
+        fuse_opt_free_args(&args);
+        return 1;
+    }
+    
     // Initialize global configuration
     config = config_get_global();
     config_init(config);
@@ -699,31 +1386,100 @@ int main(int argc, char *argv[]) {
     config_print(config);
     
     // Initialize logging
+    log_set_binary(config->log_binary);
     log_init(config->log_file, config->log_level);
     LOG_INFO("Filesystem Fault Injector initializing...");
     LOG_INFO("Log level set to: %d (0=ERROR, 1=WARN, 2=INFO, 3=DEBUG)", config->log_level);
     LOG_INFO("Using storage path: %s", config->storage_path);
     
-    // Create storage directory if it doesn't exist
-    mkdir(config->storage_path, 0755);
-    
-    // Initialize filesystem operations
-    fs_ops_init(config->storage_path);
+    // Initialize filesystem operations (creates the storage directory and
+    // opens the inode table root)
+    if (fs_ops_init(config->storage_path) != 0) {
+        LOG_ERROR("Cannot use storage path %s", config->storage_path);
+        goto out_config;
+    }
     
     // Initialize fault injector
     fault_injector_init();
     
+    // Initialize scratch buffers for reads and corrupted writes
+    buf_pool_init(config->hugepage_buffers);
+    
     // Initialize event emitter
     event_emitter_init(config->event_socket_path);
     
+    // The kernel caps read requests by the max_read mount option
+    if (config->max_read) {
+        char max_read_opt[32];
+        snprintf(max_read_opt, sizeof(max_read_opt), "-omax_read=%u", config->max_read);
+        if (fuse_opt_add_arg(&args, max_read_opt) != 0) {
+            LOG_WARN("Cannot add mount option %s", max_read_opt);
+        }
+    }
+    
+    // Create the FUSE session and mount
+    se = fuse_session_new(&args, &fs_fault_oper, sizeof(fs_fault_oper), NULL);
+    if (!se) {
+        LOG_ERROR("Failed to create FUSE session");
+        goto out_cleanup;
+    }
+    
+    if (fuse_set_signal_handlers(se) != 0) {
+        LOG_ERROR("Failed to install signal handlers");
+        goto out_session;
+    }
+    
+    if (fuse_session_mount(se, opts.mountpoint) != 0) {
+        LOG_ERROR("Failed to mount at %s", opts.mountpoint);
+        goto out_signals;
+    }
+    
+    fuse_daemonize(opts.foreground);
+    session = se;
+    fault_plan_set_activate_hook(kernel_cache_invalidate);
+    
+    // Start the delay scheduler after daemonizing (threads do not survive fork)
+    if (delay_sched_init() != 0) {
+        LOG_WARN("Delay scheduler unavailable, delay faults will block worker threads");
+    }
+    if (event_emitter_start() != 0) {
+        LOG_WARN("Event flusher unavailable, events will be sent synchronously");
+    }
+    
+    // Reload the fault rules on SIGHUP instead of ending the session
+    if (config->config_file && config_reload_start(config->config_file, options.reload_status) != 0) {
+        LOG_WARN("Fault rule reload unavailable, SIGHUP will unmount");
+    }
+    
     // Run FUSE main loop
-    ret = fuse_main(args.argc, args.argv, &fs_fault_oper, NULL);
+    if (opts.singlethread) {
+        ret = fuse_session_loop(se);
+    } else {
+        struct fuse_loop_config loop_config = {
+            .clone_fd = opts.clone_fd,
+            .max_idle_threads = opts.max_idle_threads
+        };
+        ret = fuse_session_loop_mt(se, &loop_config);
+    }
     
+    // No more reloads; reply to operations still parked by delay faults
+    // while the session is up
+    config_reload_stop();
+    delay_sched_cleanup();
+    fault_plan_set_activate_hook(NULL);
+    session = NULL;
+    
+    fuse_session_unmount(se);
+out_signals:
+    fuse_remove_signal_handlers(se);
+out_session:
+    fuse_session_destroy(se);
+out_cleanup:
     // Clean up resources
     fs_ops_cleanup();
     fault_injector_cleanup();
     event_emitter_cleanup();
-    
+out_config:
     // Clean up logging
     log_close();
     
@@ -734,9 +1490,11 @@ int main(int argc, char *argv[]) {
     free(options.storage_path);
     free(options.log_file);
     free(options.config_file);
+    free(options.reload_status);
+    free(opts.mountpoint);
     
     // Free FUSE arguments
     fuse_opt_free_args(&args);
     
-    return ret;
-}
\ No newline at end of file
+    return ret ? 1 : 0;
+}
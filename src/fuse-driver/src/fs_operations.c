@@ -1,719 +1,806 @@
+#define _GNU_SOURCE  /* O_PATH, AT_EMPTY_PATH, renameat2, copy_file_range, fallocate, splice */
+
 #include "fs_operations.h"
 #include "log.h"
+#include "op_stats.h"
+#include "trace.h"
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
-#include <sys/time.h>
-#include <utime.h>
 #include <sys/types.h>
 #include <unistd.h>
 
-// Static storage path variable
-static char *storage_path = NULL;
-
-// Initialize storage path
-void fs_ops_init(const char *storage_dir) {
-    if (storage_dir) {
-        storage_path = strdup(storage_dir);
-        LOG_INFO("Filesystem operations initialized with storage path: %s", storage_path);
-        
-        // Create storage directory if it doesn't exist
-        mkdir(storage_path, 0755);
-    } else {
+// Room for "/proc/self/fd/<int>"
+#define PROC_FD_PATH_MAX 32
+
+// Kernel write-back cache in use (set once from FUSE init)
+static bool writeback_cache;
+
+// Initialize the storage root and the inode table
+int fs_ops_init(const char *storage_dir) {
+    if (!storage_dir) {
         LOG_ERROR("Invalid storage directory provided");
+        return -EINVAL;
     }
+
+    // Create storage directory if it doesn't exist
+    mkdir(storage_dir, 0755);
+
+    int res = inode_table_init(storage_dir);
+    if (res != 0) {
+        return res;
+    }
+
+    LOG_INFO("Filesystem operations initialized with storage path: %s", storage_dir);
+    return 0;
 }
 
 // Clean up resources
 void fs_ops_cleanup(void) {
-    if (storage_path) {
-        free(storage_path);
-        storage_path = NULL;
-    }
+    inode_table_cleanup();
 }
 
-// Helper function to build full paths
-char* get_full_path(const char *path) {
-    if (!storage_path) {
-        LOG_ERROR("Storage path not initialized");
-        return NULL;
-    }
-    
-    char *fullpath = malloc(PATH_MAX);
-    if (!fullpath) {
-        LOG_ERROR("Memory allocation failed for path: %s", path);
-        return NULL;
+void fs_ops_set_writeback(bool enabled) {
+    writeback_cache = enabled;
+}
+
+// Flags for opening a backing file. With the write-back cache the kernel
+// fills partial pages by reading from files the caller opened write-only,
+// and it computes append offsets itself.
+static int backing_open_flags(int flags) {
+    if (writeback_cache) {
+        if ((flags & O_ACCMODE) == O_WRONLY) {
+            flags = (flags & ~O_ACCMODE) | O_RDWR;
+        }
+        flags &= ~O_APPEND;
     }
-    
-    sprintf(fullpath, "%s%s", storage_path, path);
-    return fullpath;
+    return flags;
 }
 
-// Helper function to check permissions
-static int check_file_perms(const char *path, int mode) {
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    struct stat stbuf;
-    int ret = lstat(fullpath, &stbuf);
-    
-    if (ret == -1) {
-        ret = -errno;
-        free(fullpath);
-        return ret;
-    }
-    
-    // Check owner permissions (we only care about the owner in this simplified model)
-    if ((mode & R_OK) && !(stbuf.st_mode & S_IRUSR)) {
-        LOG_DEBUG("Permission check failed: no read permission for %s", path);
-        free(fullpath);
+// Path that reopens an O_PATH fd with real access modes. Used for the few
+// calls that have no AT_EMPTY_PATH form (open, chmod, truncate, utimens).
+static void proc_fd_path(int fd, char *buf) {
+    snprintf(buf, PROC_FD_PATH_MAX, "/proc/self/fd/%d", fd);
+}
+
+// Check owner permissions (we only care about the owner in this simplified model)
+static int check_mode(mode_t st_mode, ino_t ino, int mode) {
+    if ((mode & R_OK) && !(st_mode & S_IRUSR)) {
+        LOG_DEBUG("Permission check failed: no read permission for inode %llu",
+                  (unsigned long long)ino);
         return -EACCES;
     }
-    
-    if ((mode & W_OK) && !(stbuf.st_mode & S_IWUSR)) {
-        LOG_DEBUG("Permission check failed: no write permission for %s", path);
-        free(fullpath);
+
+    if ((mode & W_OK) && !(st_mode & S_IWUSR)) {
+        LOG_DEBUG("Permission check failed: no write permission for inode %llu",
+                  (unsigned long long)ino);
         return -EACCES;
     }
-    
-    if ((mode & X_OK) && !(stbuf.st_mode & S_IXUSR)) {
-        LOG_DEBUG("Permission check failed: no execute permission for %s", path);
-        free(fullpath);
+
+    if ((mode & X_OK) && !(st_mode & S_IXUSR)) {
+        LOG_DEBUG("Permission check failed: no execute permission for inode %llu",
+                  (unsigned long long)ino);
         return -EACCES;
     }
-    
-    free(fullpath);
+
     return 0;
 }
 
-// Implementation of filesystem operations
+// Check permissions of an inode. Uses the mode cached in the inode table
+// entry when there is one and refreshes it with fstat() otherwise.
+static int check_inode_perms(fs_inode_t *inode, int mode) {
+    uint32_t cached = atomic_load_explicit(&inode->mode, memory_order_relaxed);
+    if (cached & INODE_MODE_VALID) {
+        op_stats_count_mode_check(true);
+        return check_mode((mode_t)(cached & ~INODE_MODE_VALID), inode->ino, mode);
+    }
 
-int fs_op_getattr(const char *path, struct stat *stbuf) {
-    LOG_DEBUG("getattr: %s", path);
-    LOG_DEBUG("GETATTR_STEP_1: Starting getattr operation for %s", path);
-    
-    int res = 0;
-    LOG_DEBUG("GETATTR_STEP_2: Getting full path for %s", path);
-    char *fullpath = get_full_path(path);
-    
-    if (!fullpath) {
-        LOG_DEBUG("GETATTR_STEP_3: Failed to get full path for %s", path);
+    op_stats_count_mode_check(false);
+    struct stat stbuf;
+    if (fstatat(inode->fd, "", &stbuf, AT_EMPTY_PATH | AT_SYMLINK_NOFOLLOW) == -1) {
+        return -errno;
+    }
+    inode_mode_store(inode, stbuf.st_mode);
+    return check_mode(stbuf.st_mode, stbuf.st_ino, mode);
+}
+
+// Check permissions of a name inside a directory inode
+static int check_child_perms(fs_inode_t *parent, const char *name, int mode) {
+    struct stat stbuf;
+    if (fstatat(parent->fd, name, &stbuf, AT_SYMLINK_NOFOLLOW) == -1) {
+        return -errno;
+    }
+    return check_mode(stbuf.st_mode, stbuf.st_ino, mode);
+}
+
+// Wrap an open fd in a file handle (closes fd on failure). The path is
+// stored in the same allocation.
+static int make_file(int fd, fs_inode_t *inode, fs_file_t **file) {
+    char path[PATH_MAX];
+    size_t length = inode_table_path(inode, path, sizeof(path));
+
+    fs_file_t *handle = malloc(sizeof(fs_file_t) + length + 1);
+    if (!handle) {
+        LOG_ERROR("Memory allocation failed for file handle");
+        close(fd);
         return -ENOMEM;
     }
-    
-    LOG_DEBUG("GETATTR_STEP_4: Full path is %s, initializing stat buffer", fullpath);
+
+    handle->fd = fd;
+    handle->path = (char *)(handle + 1);
+    memcpy(handle->path, path, length);
+    handle->path[length] = '\0';
+    handle->inode = inode;
+    atomic_init(&handle->fault_scope, 0);
+    *file = handle;
+    return 0;
+}
+
+// Implementation of filesystem operations
+
+int fs_op_lookup(fs_inode_t *parent, const char *name, fs_inode_t **inode, struct stat *attr) {
+    LOG_DEBUG("lookup: %s in inode %llu", name, (unsigned long long)parent->ino);
+
+    int res = inode_table_lookup(parent, name, inode, attr);
+    if (res != 0) {
+        LOG_DEBUG("lookup failed: %s, error: %s", name, strerror(-res));
+    }
+    return res;
+}
+
+int fs_op_getattr(fs_inode_t *inode, fs_file_t *file, struct stat *stbuf) {
+    LOG_DEBUG("getattr: inode %llu", (unsigned long long)inode->ino);
+
     memset(stbuf, 0, sizeof(struct stat));
-    
-    LOG_DEBUG("GETATTR_STEP_5: About to call lstat() for %s", fullpath);
-    res = lstat(fullpath, stbuf);
-    LOG_DEBUG("GETATTR_STEP_6: lstat() returned %d for %s", res, fullpath);
-    
-    LOG_DEBUG("GETATTR_STEP_7: Freeing fullpath for %s", path);
-    free(fullpath);
-    
+    int res = file ? fstat(file->fd, stbuf)
+                   : fstatat(inode->fd, "", stbuf, AT_EMPTY_PATH | AT_SYMLINK_NOFOLLOW);
     if (res == -1) {
-        res = -errno;
-        LOG_DEBUG("GETATTR_STEP_8: lstat failed for %s, errno=%d (%s)", path, -res, strerror(errno));
-        LOG_DEBUG("getattr failed: %s, error: %s", path, strerror(errno));
-        return res;
+        int err = -errno;
+        LOG_DEBUG("getattr failed: inode %llu, error: %s",
+                  (unsigned long long)inode->ino, strerror(errno));
+        return err;
     }
-    
-    LOG_DEBUG("GETATTR_STEP_9: getattr operation complete for %s, returning success", path);
+
+    inode_mode_store(inode, stbuf->st_mode);
     return 0;
 }
 
-int fs_op_readdir(const char *path, void *buf, fuse_fill_dir_t filler, off_t offset, struct fuse_file_info *fi) {
-    LOG_DEBUG("readdir: %s", path);
-    
-    // Mark unused parameters
-    (void)offset;
-    (void)fi;
-    
-    DIR *dp;
-    struct dirent *de;
-    char *fullpath = get_full_path(path);
-    
-    if (!fullpath) return -ENOMEM;
-    
+int fs_op_opendir(fs_inode_t *inode, fs_dir_t **dir) {
+    LOG_DEBUG("opendir: inode %llu", (unsigned long long)inode->ino);
+
     // Check read permission
-    int perms = check_file_perms(path, R_OK | X_OK);
+    int perms = check_inode_perms(inode, R_OK | X_OK);
     if (perms != 0) {
-        free(fullpath);
         return perms;
     }
-    
-    dp = opendir(fullpath);
-    free(fullpath);
-    
-    if (dp == NULL) {
+
+    int fd = openat(inode->fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
         int err = -errno;
-        LOG_DEBUG("readdir failed to open: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("opendir failed: inode %llu, error: %s",
+                  (unsigned long long)inode->ino, strerror(errno));
         return err;
     }
-    
-    while ((de = readdir(dp)) != NULL) {
+
+    fs_dir_t *handle = calloc(1, sizeof(fs_dir_t));
+    if (!handle) {
+        close(fd);
+        LOG_ERROR("Memory allocation failed for directory handle");
+        return -ENOMEM;
+    }
+
+    handle->inode = inode;
+    handle->dp = fdopendir(fd);
+    if (!handle->dp) {
+        int err = -errno;
+        close(fd);
+        free(handle);
+        return err;
+    }
+
+    *dir = handle;
+    return 0;
+}
+
+// Entries come from readdir(), which reads the directory in getdents64()
+// batches. In plus mode each entry other than "." and ".." is looked up like
+// a lookup call (one fstatat(), plus an O_PATH open for an inode the table
+// does not hold yet), so the kernel needs no lookup or getattr per entry.
+int fs_op_readdir(fs_dir_t *dir, off_t offset, bool plus, fs_dir_filler_t filler, void *ctx) {
+    LOG_DEBUG("readdir%s: offset %ld", plus ? "plus" : "", (long)offset);
+
+    // The kernel continues from the offset of the last entry it received;
+    // anything else is a seek (or rewind)
+    if (offset != dir->offset) {
+        seekdir(dir->dp, offset);
+        dir->entry = NULL;
+        dir->offset = offset;
+    }
+
+    for (;;) {
+        if (!dir->entry) {
+            errno = 0;
+            dir->entry = readdir(dir->dp);
+            if (!dir->entry) {
+                return errno ? -errno : 0;
+            }
+        }
+
+        const char *name = dir->entry->d_name;
+        fs_inode_t *inode = NULL;
         struct stat st;
         memset(&st, 0, sizeof(st));
-        st.st_ino = de->d_ino;
-        st.st_mode = de->d_type << 12;
-        
-        if (filler(buf, de->d_name, &st, 0)) {
-            LOG_DEBUG("readdir: buffer full for %s", path);
-            break;
+        st.st_ino = dir->entry->d_ino;
+        st.st_mode = dir->entry->d_type << 12;
+
+        off_t next_offset = telldir(dir->dp);
+        bool dot = strcmp(name, ".") == 0 || strcmp(name, "..") == 0;
+        if (plus && !dot && inode_table_lookup(dir->inode, name, &inode, &st) != 0) {
+            // Removed since it was listed
+            dir->entry = NULL;
+            dir->offset = next_offset;
+            continue;
         }
+
+        if (filler(ctx, name, inode, &st, next_offset)) {
+            // Buffer full: keep the entry for the next call
+            if (inode) {
+                inode_table_forget(inode, 1);
+            }
+            LOG_DEBUG("readdir: buffer full at offset %ld", (long)dir->offset);
+            return 0;
+        }
+        dir->entry = NULL;
+        dir->offset = next_offset;
     }
-    
-    closedir(dp);
-    return 0;
 }
 
-int fs_op_create(const char *path, mode_t mode, struct fuse_file_info *fi) {
-    LOG_DEBUG("create: %s, mode: %o", path, mode);
-    
-    // Check if file exists, and if so, check for write permission
-    struct stat stbuf;
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    if (lstat(fullpath, &stbuf) == 0) {
-        // File exists, check write permission
-        int perms = check_file_perms(path, W_OK);
-        if (perms != 0) {
-            LOG_DEBUG("create denied: %s already exists and no write permission", path);
-            free(fullpath);
-            return perms;
-        }
+int fs_op_releasedir(fs_dir_t *dir) {
+    LOG_DEBUG("releasedir");
+
+    int res = closedir(dir->dp);
+    free(dir);
+    return res == -1 ? -errno : 0;
+}
+
+int fs_op_create(fs_inode_t *parent, const char *name, mode_t mode, int flags,
+                 fs_file_t **file, fs_inode_t **inode, struct stat *attr) {
+    LOG_DEBUG("create: %s, mode: %o, flags: 0x%x", name, mode, flags);
+
+    // If the file exists, check for write permission
+    int perms = check_child_perms(parent, name, W_OK);
+    if (perms != 0 && perms != -ENOENT) {
+        LOG_DEBUG("create denied: %s already exists and no write permission", name);
+        return perms;
     }
-    
-    int fd = creat(fullpath, mode);
-    free(fullpath);
-    
+
+    int fd = openat(parent->fd, name, backing_open_flags(flags) | O_CREAT | O_CLOEXEC, mode);
     if (fd == -1) {
         int err = -errno;
-        LOG_DEBUG("create failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("create failed: %s, error: %s", name, strerror(errno));
         return err;
     }
-    
-    fi->fh = fd;
-    return 0;
-}
 
-int fs_op_mknod(const char *path, mode_t mode, dev_t rdev) {
-    LOG_DEBUG("mknod: %s, mode: %o", path, mode);
-    
-    int res;
-    char *fullpath = get_full_path(path);
-    
-    if (!fullpath) return -ENOMEM;
-    
-    // If file exists, check write access to directory
-    char *dirpath = strdup(path);
-    char *last_slash = strrchr(dirpath, '/');
-    if (last_slash) {
-        *last_slash = '\0';
-        if (*dirpath == '\0') {
-            strcpy(dirpath, "/");
-        }
-    } else {
-        strcpy(dirpath, "/");
+    int res = inode_table_lookup(parent, name, inode, attr);
+    if (res != 0) {
+        close(fd);
+        return res;
     }
-    
-    int perms = check_file_perms(dirpath, W_OK);
-    free(dirpath);
-    
+
+    res = make_file(fd, *inode, file);
+    if (res != 0) {
+        inode_table_forget(*inode, 1);
+    }
+    return res;
+}
+
+int fs_op_mknod(fs_inode_t *parent, const char *name, mode_t mode, dev_t rdev,
+                fs_inode_t **inode, struct stat *attr) {
+    LOG_DEBUG("mknod: %s, mode: %o", name, mode);
+
+    // Check write access to the directory
+    int perms = check_inode_perms(parent, W_OK);
     if (perms != 0) {
-        LOG_DEBUG("mknod denied: no write permission to directory for %s", path);
-        free(fullpath);
+        LOG_DEBUG("mknod denied: no write permission to directory for %s", name);
         return perms;
     }
-    
-    // If it's a regular file
+
+    int res;
     if (S_ISREG(mode)) {
-        res = open(fullpath, O_CREAT | O_EXCL | O_WRONLY, mode);
+        res = openat(parent->fd, name, O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, mode);
         if (res >= 0)
             res = close(res);
     } else if (S_ISFIFO(mode)) {
-        res = mkfifo(fullpath, mode);
+        res = mkfifoat(parent->fd, name, mode);
     } else {
-        res = mknod(fullpath, mode, rdev);
+        res = mknodat(parent->fd, name, mode, rdev);
     }
-    
-    free(fullpath);
-    
+
     if (res == -1) {
         int err = -errno;
-        LOG_DEBUG("mknod failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("mknod failed: %s, error: %s", name, strerror(errno));
         return err;
     }
-    
-    return 0;
+
+    return inode_table_lookup(parent, name, inode, attr);
 }
 
-int fs_op_read(const char *path, char *buf, size_t size, off_t offset, struct fuse_file_info *fi) {
-    LOG_DEBUG("read: %s, size: %zu, offset: %ld", path, size, offset);
-    
-    int fd;
-    int res;
-    
-    if (fi == NULL) {
-        // No file handle provided, check read permission
-        int perms = check_file_perms(path, R_OK);
-        if (perms != 0) {
-            LOG_DEBUG("read denied: no read permission for %s", path);
-            return perms;
+int fs_op_read(fs_file_t *file, char *buf, size_t size, off_t offset) {
+    LOG_DEBUG("read: %s, size: %zu, offset: %ld", file->path, size, (long)offset);
+
+    TRACE3(read_entry, file->fd, size, offset);
+    int res = pread(file->fd, buf, size, offset);
+    TRACE2(read_exit, file->fd, res);
+    if (res == -1) {
+        res = -errno;
+        LOG_DEBUG("read failed: %s, error: %s", file->path, strerror(errno));
+    }
+
+    return res;
+}
+
+// Per-thread pipe reads are spliced into (closed when the thread exits)
+typedef struct {
+    int fds[2];          // Read and write end, -1 = not created yet
+    size_t capacity;     // Bytes the pipe holds
+} read_pipe_t;
+
+static __thread read_pipe_t tls_pipe = { { -1, -1 }, 0 };
+static __thread bool tls_pipe_registered = false;
+static pthread_key_t pipe_key;
+static pthread_once_t pipe_key_once = PTHREAD_ONCE_INIT;
+
+static void read_pipe_close(read_pipe_t *rp) {
+    if (rp->fds[0] != -1) {
+        close(rp->fds[0]);
+        close(rp->fds[1]);
+    }
+    rp->fds[0] = rp->fds[1] = -1;
+    rp->capacity = 0;
+}
+
+static void read_pipe_release(void *arg) {
+    read_pipe_close(arg);
+}
+
+static void pipe_key_create(void) {
+    pthread_key_create(&pipe_key, read_pipe_release);
+}
+
+// The calling thread's pipe, able to hold size bytes from any offset (NULL
+// if it cannot). A pipe holds whole pages, and a read that does not start on
+// a page boundary spans one page more.
+static read_pipe_t *read_pipe_get(size_t size) {
+    read_pipe_t *rp = &tls_pipe;
+    size += (size_t)sysconf(_SC_PAGESIZE);
+    if (rp->fds[0] == -1) {
+        if (!tls_pipe_registered) {
+            pthread_once(&pipe_key_once, pipe_key_create);
+            pthread_setspecific(pipe_key, rp);
+            tls_pipe_registered = true;
         }
-        
-        char *fullpath = get_full_path(path);
-        if (!fullpath) return -ENOMEM;
-        
-        fd = open(fullpath, O_RDONLY);
-        free(fullpath);
-        
-        if (fd == -1) {
-            int err = -errno;
-            LOG_DEBUG("read failed to open: %s, error: %s", path, strerror(errno));
-            return err;
+        if (pipe2(rp->fds, O_CLOEXEC | O_NONBLOCK) == -1) {
+            rp->fds[0] = rp->fds[1] = -1;
+            return NULL;
         }
-    } else {
-        fd = fi->fh;
+        int capacity = fcntl(rp->fds[0], F_GETPIPE_SZ);
+        rp->capacity = capacity > 0 ? (size_t)capacity : 0;
     }
-    
-    res = pread(fd, buf, size, offset);
-    if (res == -1) {
-        res = -errno;
-        LOG_DEBUG("read failed: %s, error: %s", path, strerror(errno));
+    if (rp->capacity < size) {
+        int capacity = fcntl(rp->fds[0], F_SETPIPE_SZ, (int)size);
+        if (capacity == -1) {
+            return NULL;
+        }
+        rp->capacity = (size_t)capacity;
     }
-    
-    if (fi == NULL) {
-        close(fd);
+    return rp;
+}
+
+int fs_op_read_pipe(fs_file_t *file, size_t size, off_t offset, int *pipe_fd) {
+    read_pipe_t *rp = read_pipe_get(size);
+    if (!rp) {
+        return -EOPNOTSUPP;
     }
-    
-    return res;
+
+    TRACE3(read_entry, file->fd, size, offset);
+    size_t total = 0;
+    while (total < size) {
+        loff_t pos = offset + (off_t)total;
+        ssize_t n = splice(file->fd, &pos, rp->fds[1], NULL, size - total,
+                           SPLICE_F_MOVE);
+        if (n == 0) {
+            break;  // End of file
+        }
+        if (n == -1) {
+            int err = errno;
+            if (total > 0) {
+                break;  // Reply with what was read, like a short pread()
+            }
+            TRACE2(read_exit, file->fd, -err);
+            if (err == EINVAL) {
+                return -EOPNOTSUPP;  // The backing filesystem cannot splice
+            }
+            LOG_DEBUG("read failed: %s, error: %s", file->path, strerror(err));
+            return -err;
+        }
+        total += (size_t)n;
+    }
+    TRACE2(read_exit, file->fd, (int)total);
+
+    *pipe_fd = rp->fds[0];
+    return (int)total;
+}
+
+void fs_op_read_pipe_reset(void) {
+    read_pipe_close(&tls_pipe);
+}
+
+int fs_op_write_check(fs_file_t *file) {
+    // Always check write permission, even though the file is open.
+    // This prevents root from bypassing permissions via shell redirection.
+    int perms = check_inode_perms(file->inode, W_OK);
+    if (perms != 0) {
+        LOG_DEBUG("write denied: no write permission for %s", file->path);
+    }
+    return perms;
 }
 
-int fs_op_write(const char *path, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi) {
-    LOG_DEBUG("write: %s, size: %zu, offset: %ld", path, size, offset);
-    LOG_DEBUG("WRITE_STEP_1: Starting write operation for %s", path);
-    
-    // Always check write permission, even if file handle is provided
-    // This prevents root from bypassing permissions via shell redirection
-    LOG_DEBUG("WRITE_STEP_1a: Checking write permissions for %s", path);
-    int perms = check_file_perms(path, W_OK);
+int fs_op_write(fs_file_t *file, const char *buf, size_t size, off_t offset) {
+    LOG_DEBUG("write: %s, size: %zu, offset: %ld", file->path, size, (long)offset);
+
+    int perms = fs_op_write_check(file);
     if (perms != 0) {
-        LOG_DEBUG("write denied: no write permission for %s", path);
         return perms;
     }
-    
-    int fd;
-    int res;
-    
-    LOG_DEBUG("WRITE_STEP_2: Checking file handle for %s (fi=%p)", path, fi);
-    if (fi == NULL) {
-        LOG_DEBUG("WRITE_STEP_3a: No file handle, opening file for %s", path);
-        LOG_DEBUG("WRITE_STEP_4a: Permissions OK, getting full path for %s", path);
-        
-        char *fullpath = get_full_path(path);
-        if (!fullpath) return -ENOMEM;
-        LOG_DEBUG("WRITE_STEP_5a: Full path: %s, calling open()", fullpath);
-        
-        fd = open(fullpath, O_WRONLY);
-        LOG_DEBUG("WRITE_STEP_6a: open() returned fd=%d for %s", fd, path);
-        free(fullpath);
-        
-        if (fd == -1) {
-            int err = -errno;
-            LOG_DEBUG("write failed to open: %s, error: %s", path, strerror(errno));
-            return err;
-        }
-    } else {
-        LOG_DEBUG("WRITE_STEP_3b: Using existing file handle fd=%d for %s", (int)fi->fh, path);
-        fd = fi->fh;
-    }
-    
-    LOG_DEBUG("WRITE_STEP_7: About to call pwrite() for %s (fd=%d, size=%zu, offset=%ld)", path, fd, size, offset);
-    res = pwrite(fd, buf, size, offset);
-    LOG_DEBUG("WRITE_STEP_8: pwrite() returned %d for %s", res, path);
-    
+
+    TRACE3(write_entry, file->fd, size, offset);
+    int res = pwrite(file->fd, buf, size, offset);
+    TRACE2(write_exit, file->fd, res);
     if (res == -1) {
         res = -errno;
-        LOG_DEBUG("write failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("write failed: %s, error: %s", file->path, strerror(errno));
     }
-    
-    LOG_DEBUG("WRITE_STEP_9: Checking if need to close fd for %s (fi=%p)", path, fi);
-    if (fi == NULL) {
-        LOG_DEBUG("WRITE_STEP_10a: Closing fd=%d for %s", fd, path);
-        close(fd);
-        LOG_DEBUG("WRITE_STEP_11a: Closed fd for %s", path);
-    } else {
-        LOG_DEBUG("WRITE_STEP_10b: Not closing fd (using file handle) for %s", path);
+
+    return res;
+}
+
+ssize_t fs_op_copy_file_range(fs_file_t *in, off_t offset_in, fs_file_t *out, off_t offset_out,
+                              size_t size, unsigned int flags) {
+    LOG_DEBUG("copy_file_range: %s to %s, size: %zu, offsets: %ld -> %ld",
+              in->path, out->path, size, (long)offset_in, (long)offset_out);
+
+    int perms = fs_op_write_check(out);
+    if (perms != 0) {
+        return perms;
+    }
+
+    // The backing filesystem shares extents (reflink on btrfs/XFS) or copies
+    // in the kernel; the data never passes through the driver
+    ssize_t res = copy_file_range(in->fd, &offset_in, out->fd, &offset_out, size, flags);
+    if (res == -1) {
+        int err = errno;
+        LOG_DEBUG("copy_file_range failed: %s to %s, error: %s", in->path, out->path, strerror(err));
+        // No in-kernel copy between these files: let the kernel fall back to
+        // its own read/write copy instead of failing the caller
+        return (err == EXDEV || err == ENOSYS) ? -EOPNOTSUPP : -err;
     }
-    
-    LOG_DEBUG("WRITE_STEP_12: Write operation complete for %s, returning %d", path, res);
+
     return res;
 }
 
-int fs_op_open(const char *path, struct fuse_file_info *fi) {
-    LOG_DEBUG("open: %s, flags: 0x%x", path, fi->flags);
-    
-    // Check permissions based on requested flags
-    if ((fi->flags & O_ACCMODE) == O_RDONLY) {
-        int perms = check_file_perms(path, R_OK);
-        if (perms != 0) {
-            LOG_DEBUG("open denied: no read permission for %s", path);
-            return perms;
-        }
-    } else if ((fi->flags & O_ACCMODE) == O_WRONLY) {
-        int perms = check_file_perms(path, W_OK);
-        if (perms != 0) {
-            LOG_DEBUG("open denied: no write permission for %s", path);
-            return perms;
-        }
-    } else if ((fi->flags & O_ACCMODE) == O_RDWR) {
-        int perms = check_file_perms(path, R_OK | W_OK);
-        if (perms != 0) {
-            LOG_DEBUG("open denied: no read/write permission for %s", path);
-            return perms;
-        }
+int fs_op_fallocate(fs_file_t *file, int mode, off_t offset, off_t length) {
+    LOG_DEBUG("fallocate: %s, mode: 0x%x, offset: %ld, length: %ld",
+              file->path, mode, (long)offset, (long)length);
+
+    int perms = fs_op_write_check(file);
+    if (perms != 0) {
+        return perms;
     }
-    
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    int fd = open(fullpath, fi->flags);
-    free(fullpath);
-    
-    if (fd == -1) {
+
+    if (fallocate(file->fd, mode, offset, length) == -1) {
         int err = -errno;
-        LOG_DEBUG("open failed: %s, flags: 0x%x, error: %s", path, fi->flags, strerror(errno));
+        LOG_DEBUG("fallocate failed: %s, error: %s", file->path, strerror(errno));
         return err;
     }
-    
-    fi->fh = fd;
+
     return 0;
 }
 
-int fs_op_release(const char *path, struct fuse_file_info *fi) {
-    LOG_DEBUG("release: %s", path);
-    
-    if (close(fi->fh) == -1) {
+int fs_op_fsync(fs_file_t *file, bool datasync) {
+    LOG_DEBUG("fsync: %s, datasync: %d", file->path, datasync);
+
+    if ((datasync ? fdatasync(file->fd) : fsync(file->fd)) == -1) {
         int err = -errno;
-        LOG_DEBUG("release failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("fsync failed: %s, error: %s", file->path, strerror(errno));
         return err;
     }
-    
+
     return 0;
 }
 
-int fs_op_mkdir(const char *path, mode_t mode) {
-    LOG_DEBUG("mkdir: %s, mode: %o", path, mode);
-    
-    // Check write permission on parent directory
-    char *dirpath = strdup(path);
-    char *last_slash = strrchr(dirpath, '/');
-    if (last_slash) {
-        *last_slash = '\0';
-        if (*dirpath == '\0') {
-            strcpy(dirpath, "/");
-        }
-    } else {
-        strcpy(dirpath, "/");
+int fs_op_flush(fs_file_t *file) {
+    LOG_DEBUG("flush: %s", file->path);
+
+    // Closing a duplicate reports deferred write errors (NFS, quota) the
+    // way close() of the caller's descriptor would, without closing ours
+    int fd = dup(file->fd);
+    if (fd == -1) {
+        return -errno;
     }
-    
-    int perms = check_file_perms(dirpath, W_OK);
-    free(dirpath);
-    
+    if (close(fd) == -1) {
+        int err = -errno;
+        LOG_DEBUG("flush failed: %s, error: %s", file->path, strerror(errno));
+        return err;
+    }
+
+    return 0;
+}
+
+int fs_op_statfs(fs_inode_t *inode, struct statvfs *stbuf) {
+    LOG_DEBUG("statfs: inode %llu", (unsigned long long)inode->ino);
+
+    if (fstatvfs(inode->fd, stbuf) == -1) {
+        int err = -errno;
+        LOG_DEBUG("statfs failed: inode %llu, error: %s",
+                  (unsigned long long)inode->ino, strerror(errno));
+        return err;
+    }
+
+    return 0;
+}
+
+int fs_op_open(fs_inode_t *inode, int flags, fs_file_t **file) {
+    LOG_DEBUG("open: inode %llu, flags: 0x%x", (unsigned long long)inode->ino, flags);
+
+    // Check permissions based on requested flags
+    int mode = 0;
+    if ((flags & O_ACCMODE) == O_RDONLY) {
+        mode = R_OK;
+    } else if ((flags & O_ACCMODE) == O_WRONLY) {
+        mode = W_OK;
+    } else if ((flags & O_ACCMODE) == O_RDWR) {
+        mode = R_OK | W_OK;
+    }
+    int perms = check_inode_perms(inode, mode);
     if (perms != 0) {
-        LOG_DEBUG("mkdir denied: no write permission to parent directory for %s", path);
+        LOG_DEBUG("open denied: inode %llu, flags: 0x%x", (unsigned long long)inode->ino, flags);
         return perms;
     }
-    
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    int res = mkdir(fullpath, mode);
-    free(fullpath);
-    
-    if (res == -1) {
+
+    char proc_path[PROC_FD_PATH_MAX];
+    proc_fd_path(inode->fd, proc_path);
+    int fd = open(proc_path, backing_open_flags(flags & ~(O_CREAT | O_EXCL | O_NOCTTY)) | O_CLOEXEC);
+    if (fd == -1) {
         int err = -errno;
-        LOG_DEBUG("mkdir failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("open failed: inode %llu, flags: 0x%x, error: %s",
+                  (unsigned long long)inode->ino, flags, strerror(errno));
         return err;
     }
-    
-    return 0;
+
+    return make_file(fd, inode, file);
 }
 
-int fs_op_rmdir(const char *path) {
-    LOG_DEBUG("rmdir: %s", path);
-    
+int fs_op_release(fs_file_t *file) {
+    LOG_DEBUG("release: %s", file->path);
+
+    int res = close(file->fd);
+    if (res == -1) {
+        res = -errno;
+        LOG_DEBUG("release failed: %s, error: %s", file->path, strerror(errno));
+    }
+
+    free(file);
+    return res;
+}
+
+int fs_op_mkdir(fs_inode_t *parent, const char *name, mode_t mode,
+                fs_inode_t **inode, struct stat *attr) {
+    LOG_DEBUG("mkdir: %s, mode: %o", name, mode);
+
     // Check write permission on parent directory
-    char *dirpath = strdup(path);
-    char *last_slash = strrchr(dirpath, '/');
-    if (last_slash) {
-        *last_slash = '\0';
-        if (*dirpath == '\0') {
-            strcpy(dirpath, "/");
-        }
-    } else {
-        strcpy(dirpath, "/");
+    int perms = check_inode_perms(parent, W_OK);
+    if (perms != 0) {
+        LOG_DEBUG("mkdir denied: no write permission to parent directory for %s", name);
+        return perms;
     }
-    
-    int perms = check_file_perms(dirpath, W_OK);
-    free(dirpath);
-    
+
+    if (mkdirat(parent->fd, name, mode) == -1) {
+        int err = -errno;
+        LOG_DEBUG("mkdir failed: %s, error: %s", name, strerror(errno));
+        return err;
+    }
+
+    return inode_table_lookup(parent, name, inode, attr);
+}
+
+int fs_op_rmdir(fs_inode_t *parent, const char *name) {
+    LOG_DEBUG("rmdir: %s", name);
+
+    // Check write permission on parent directory
+    int perms = check_inode_perms(parent, W_OK);
     if (perms != 0) {
-        LOG_DEBUG("rmdir denied: no write permission to parent directory for %s", path);
+        LOG_DEBUG("rmdir denied: no write permission to parent directory for %s", name);
         return perms;
     }
-    
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    int res = rmdir(fullpath);
-    free(fullpath);
-    
-    if (res == -1) {
+
+    if (unlinkat(parent->fd, name, AT_REMOVEDIR) == -1) {
         int err = -errno;
-        LOG_DEBUG("rmdir failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("rmdir failed: %s, error: %s", name, strerror(errno));
         return err;
     }
-    
+
     return 0;
 }
 
-int fs_op_unlink(const char *path) {
-    LOG_DEBUG("unlink: %s", path);
-    
+int fs_op_unlink(fs_inode_t *parent, const char *name) {
+    LOG_DEBUG("unlink: %s", name);
+
     // Check write permission on parent directory
-    char *dirpath = strdup(path);
-    char *last_slash = strrchr(dirpath, '/');
-    if (last_slash) {
-        *last_slash = '\0';
-        if (*dirpath == '\0') {
-            strcpy(dirpath, "/");
-        }
-    } else {
-        strcpy(dirpath, "/");
-    }
-    
-    int perms = check_file_perms(dirpath, W_OK);
-    free(dirpath);
-    
+    int perms = check_inode_perms(parent, W_OK);
     if (perms != 0) {
-        LOG_DEBUG("unlink denied: no write permission to parent directory for %s", path);
+        LOG_DEBUG("unlink denied: no write permission to parent directory for %s", name);
         return perms;
     }
-    
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    int res = unlink(fullpath);
-    free(fullpath);
-    
-    if (res == -1) {
+
+    if (unlinkat(parent->fd, name, 0) == -1) {
         int err = -errno;
-        LOG_DEBUG("unlink failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("unlink failed: %s, error: %s", name, strerror(errno));
         return err;
     }
-    
+
     return 0;
 }
 
-int fs_op_chmod(const char *path, mode_t mode) {
-    LOG_DEBUG("chmod: %s, mode: %o", path, mode);
-    
+int fs_op_chmod(fs_inode_t *inode, mode_t mode) {
+    LOG_DEBUG("chmod: inode %llu, mode: %o", (unsigned long long)inode->ino, mode);
+
     // Check write permission to the file
-    int perms = check_file_perms(path, W_OK);
+    int perms = check_inode_perms(inode, W_OK);
     if (perms != 0) {
-        LOG_DEBUG("chmod denied: no write permission for %s", path);
         return perms;
     }
-    
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    int res = chmod(fullpath, mode);
-    free(fullpath);
-    
-    if (res == -1) {
+
+    char proc_path[PROC_FD_PATH_MAX];
+    proc_fd_path(inode->fd, proc_path);
+    if (chmod(proc_path, mode) == -1) {
         int err = -errno;
-        LOG_DEBUG("chmod failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("chmod failed: inode %llu, error: %s",
+                  (unsigned long long)inode->ino, strerror(errno));
         return err;
     }
-    
+
+    inode_mode_invalidate(inode);
     return 0;
 }
 
-int fs_op_chown(const char *path, uid_t uid, gid_t gid) {
-    LOG_DEBUG("chown: %s, uid: %d, gid: %d", path, uid, gid);
-    
+int fs_op_chown(fs_inode_t *inode, uid_t uid, gid_t gid) {
+    LOG_DEBUG("chown: inode %llu, uid: %d, gid: %d", (unsigned long long)inode->ino, uid, gid);
+
     // Check write permission to the file
-    int perms = check_file_perms(path, W_OK);
+    int perms = check_inode_perms(inode, W_OK);
     if (perms != 0) {
-        LOG_DEBUG("chown denied: no write permission for %s", path);
         return perms;
     }
-    
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    int res = chown(fullpath, uid, gid);
-    free(fullpath);
-    
-    if (res == -1) {
+
+    if (fchownat(inode->fd, "", uid, gid, AT_EMPTY_PATH | AT_SYMLINK_NOFOLLOW) == -1) {
         int err = -errno;
-        LOG_DEBUG("chown failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("chown failed: inode %llu, error: %s",
+                  (unsigned long long)inode->ino, strerror(errno));
         return err;
     }
-    
+
+    inode_mode_invalidate(inode);
     return 0;
 }
 
-int fs_op_truncate(const char *path, off_t size) {
-    LOG_DEBUG("truncate: %s, size: %ld", path, size);
-    
+int fs_op_truncate(fs_inode_t *inode, fs_file_t *file, off_t size) {
+    LOG_DEBUG("truncate: inode %llu, size: %ld", (unsigned long long)inode->ino, (long)size);
+
     // Check write permission
-    int perms = check_file_perms(path, W_OK);
+    int perms = check_inode_perms(inode, W_OK);
     if (perms != 0) {
-        LOG_DEBUG("truncate denied: no write permission for %s", path);
         return perms;
     }
-    
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    int res = truncate(fullpath, size);
-    free(fullpath);
-    
+
+    int res;
+    if (file) {
+        res = ftruncate(file->fd, size);
+    } else {
+        char proc_path[PROC_FD_PATH_MAX];
+        proc_fd_path(inode->fd, proc_path);
+        res = truncate(proc_path, size);
+    }
+
     if (res == -1) {
         int err = -errno;
-        LOG_DEBUG("truncate failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("truncate failed: inode %llu, error: %s",
+                  (unsigned long long)inode->ino, strerror(errno));
         return err;
     }
-    
+
     return 0;
 }
 
-int fs_op_utimens(const char *path, const struct timespec ts[2]) {
-    LOG_DEBUG("utimens: %s", path);
-    
+int fs_op_utimens(fs_inode_t *inode, fs_file_t *file, const struct timespec ts[2]) {
+    LOG_DEBUG("utimens: inode %llu", (unsigned long long)inode->ino);
+
     // Check write permission
-    int perms = check_file_perms(path, W_OK);
+    int perms = check_inode_perms(inode, W_OK);
     if (perms != 0) {
-        LOG_DEBUG("utimens denied: no write permission for %s", path);
         return perms;
     }
-    
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    // FUSE passes timestamps in ts[0] (access) and ts[1] (modification)
-    // Convert to a format usable by utimes()
-    struct timeval tv[2];
-    tv[0].tv_sec = ts[0].tv_sec;
-    tv[0].tv_usec = ts[0].tv_nsec / 1000;
-    tv[1].tv_sec = ts[1].tv_sec;
-    tv[1].tv_usec = ts[1].tv_nsec / 1000;
-    
-    int res = utimes(fullpath, tv);
-    
-    free(fullpath);
-    
+
+    // ts[0] is the access time, ts[1] the modification time; either may be
+    // UTIME_NOW or UTIME_OMIT
+    int res;
+    if (file) {
+        res = futimens(file->fd, ts);
+    } else {
+        char proc_path[PROC_FD_PATH_MAX];
+        proc_fd_path(inode->fd, proc_path);
+        res = utimensat(AT_FDCWD, proc_path, ts, 0);
+    }
+
     if (res == -1) {
         int err = -errno;
-        LOG_DEBUG("utimens failed: %s, error: %s", path, strerror(errno));
+        LOG_DEBUG("utimens failed: inode %llu, error: %s",
+                  (unsigned long long)inode->ino, strerror(errno));
         return err;
     }
-    
+
     return 0;
 }
 
-int fs_op_rename(const char *path, const char *newpath) {
-    LOG_DEBUG("rename: %s to %s", path, newpath);
-    
+int fs_op_rename(fs_inode_t *parent, const char *name,
+                 fs_inode_t *newparent, const char *newname, unsigned int flags) {
+    LOG_DEBUG("rename: %s to %s, flags: 0x%x", name, newname, flags);
+
     // Check write permission on both files if they exist
     // and on both parent directories
-    
+
     // Source file permissions
-    int perms = check_file_perms(path, W_OK);
+    int perms = check_child_perms(parent, name, W_OK);
     if (perms != 0) {
-        LOG_DEBUG("rename denied: no write permission for source %s", path);
+        LOG_DEBUG("rename denied: no write permission for source %s", name);
         return perms;
     }
-    
+
     // Source directory permissions
-    char *dirpath = strdup(path);
-    char *last_slash = strrchr(dirpath, '/');
-    if (last_slash) {
-        *last_slash = '\0';
-        if (*dirpath == '\0') {
-            strcpy(dirpath, "/");
-        }
-    } else {
-        strcpy(dirpath, "/");
-    }
-    
-    perms = check_file_perms(dirpath, W_OK);
-    free(dirpath);
-    
+    perms = check_inode_perms(parent, W_OK);
     if (perms != 0) {
-        LOG_DEBUG("rename denied: no write permission to source directory for %s", path);
+        LOG_DEBUG("rename denied: no write permission to source directory for %s", name);
         return perms;
     }
-    
+
     // Destination directory permissions
-    dirpath = strdup(newpath);
-    last_slash = strrchr(dirpath, '/');
-    if (last_slash) {
-        *last_slash = '\0';
-        if (*dirpath == '\0') {
-            strcpy(dirpath, "/");
-        }
-    } else {
-        strcpy(dirpath, "/");
-    }
-    
-    perms = check_file_perms(dirpath, W_OK);
-    free(dirpath);
-    
+    perms = check_inode_perms(newparent, W_OK);
     if (perms != 0) {
-        LOG_DEBUG("rename denied: no write permission to destination directory for %s", newpath);
+        LOG_DEBUG("rename denied: no write permission to destination directory for %s", newname);
         return perms;
     }
-    
+
     // If destination file exists, check write permission
-    struct stat stbuf;
-    if (fs_op_getattr(newpath, &stbuf) == 0) {
-        perms = check_file_perms(newpath, W_OK);
-        if (perms != 0) {
-            LOG_DEBUG("rename denied: no write permission for destination %s", newpath);
-            return perms;
-        }
-    }
-    
-    char *fullpath = get_full_path(path);
-    if (!fullpath) return -ENOMEM;
-    
-    char *fullnewpath = get_full_path(newpath);
-    if (!fullnewpath) {
-        free(fullpath);
-        return -ENOMEM;
+    perms = check_child_perms(newparent, newname, W_OK);
+    if (perms != 0 && perms != -ENOENT) {
+        LOG_DEBUG("rename denied: no write permission for destination %s", newname);
+        return perms;
     }
-    
-    int res = rename(fullpath, fullnewpath);
-    
-    free(fullpath);
-    free(fullnewpath);
-    
+
+    int res = flags ? renameat2(parent->fd, name, newparent->fd, newname, flags)
+                    : renameat(parent->fd, name, newparent->fd, newname);
     if (res == -1) {
         res = -errno;
-        LOG_DEBUG("rename failed: %s to %s, error: %s", path, newpath, strerror(errno));
+        LOG_DEBUG("rename failed: %s to %s, error: %s", name, newname, strerror(errno));
+        return res;
     }
-    
-    return res;
+
+    inode_table_rename(parent, name, newparent, newname);
+    return 0;
 }
 
-int fs_op_access(const char *path, int mode) {
-    LOG_DEBUG("access: %s, mode: %d", path, mode);
-    
-    return check_file_perms(path, mode);
-}
\ No newline at end of file
+int fs_op_access(fs_inode_t *inode, int mode) {
+    LOG_DEBUG("access: inode %llu, mode: %d", (unsigned long long)inode->ino, mode);
+
+    return check_inode_perms(inode, mode);
+}
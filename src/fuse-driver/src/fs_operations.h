@@ -1,7 +1,8 @@
 #ifndef FS_OPERATIONS_H
 #define FS_OPERATIONS_H
 
-#include <fuse.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,37 +10,109 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/statvfs.h>
 #include <dirent.h>
 #include <limits.h>
 #include <sys/types.h>
 #include <time.h>  /* For struct timespec */
 
-// Initialize the filesystem operations
-void fs_ops_init(const char *storage_dir);
+#include "inode_table.h"
+
+// Backend operations. Every call works relative to inode table entries with
+// *at() syscalls; nothing here builds or walks absolute backing paths. All
+// functions return 0 (or a byte count) on success and a negative errno on
+// failure. The owner-bit permission checks of the original driver are done
+// here, once per operation.
+
+// Open file handle (stored in fuse_file_info.fh)
+typedef struct {
+    int fd;              // Backing file descriptor
+    char *path;          // Mount-relative path at open time (events and logs; same allocation)
+    fs_inode_t *inode;   // Inode opened (kept alive by the kernel while open)
+    _Atomic uint64_t fault_scope; // Path rules matching path (fault_plan_view_cached())
+} fs_file_t;
+
+// Open directory handle (stored in fuse_file_info.fh)
+typedef struct {
+    DIR *dp;
+    fs_inode_t *inode;   // Directory listed (kept alive by the kernel while open)
+    off_t offset;        // Offset of the next entry readdir() will return
+    struct dirent *entry; // Entry read but not yet delivered (buffer was full)
+} fs_dir_t;
+
+// Directory filler: returns non-zero when the reply buffer is full. With
+// plus, inode is the looked-up entry (NULL for "." and "..") and st its full
+// attributes; otherwise inode is NULL and st only has st_ino and the type.
+typedef int (*fs_dir_filler_t)(void *ctx, const char *name, fs_inode_t *inode,
+                               const struct stat *st, off_t next_offset);
+
+// Initialize the filesystem operations (0 or negative errno)
+int fs_ops_init(const char *storage_dir);
 
 // Clean up filesystem operations
 void fs_ops_cleanup(void);
 
-// Filesystem operations
-int fs_op_getattr(const char *path, struct stat *stbuf);
-int fs_op_readdir(const char *path, void *buf, fuse_fill_dir_t filler, off_t offset, struct fuse_file_info *fi);
-int fs_op_create(const char *path, mode_t mode, struct fuse_file_info *fi);
-int fs_op_mknod(const char *path, mode_t mode, dev_t rdev);
-int fs_op_read(const char *path, char *buf, size_t size, off_t offset, struct fuse_file_info *fi);
-int fs_op_write(const char *path, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi);
-int fs_op_open(const char *path, struct fuse_file_info *fi);
-int fs_op_release(const char *path, struct fuse_file_info *fi);
-int fs_op_mkdir(const char *path, mode_t mode);
-int fs_op_rmdir(const char *path);
-int fs_op_unlink(const char *path);
-int fs_op_chmod(const char *path, mode_t mode);
-int fs_op_chown(const char *path, uid_t uid, gid_t gid);
-int fs_op_truncate(const char *path, off_t size);
-int fs_op_utimens(const char *path, const struct timespec ts[2]);
-int fs_op_rename(const char *path, const char *newpath);
-int fs_op_access(const char *path, int mode);
-
-// Helper functions
-char* get_full_path(const char *path);
-
-#endif // FS_OPERATIONS_H
\ No newline at end of file
+// The kernel write-back cache is on: open backing files so the kernel can
+// also read from files opened write-only, and leave O_APPEND to the kernel
+void fs_ops_set_writeback(bool enabled);
+
+// Entry operations (return the new inode with a lookup reference and its attributes)
+int fs_op_lookup(fs_inode_t *parent, const char *name, fs_inode_t **inode, struct stat *attr);
+int fs_op_create(fs_inode_t *parent, const char *name, mode_t mode, int flags,
+                 fs_file_t **file, fs_inode_t **inode, struct stat *attr);
+int fs_op_mknod(fs_inode_t *parent, const char *name, mode_t mode, dev_t rdev,
+                fs_inode_t **inode, struct stat *attr);
+int fs_op_mkdir(fs_inode_t *parent, const char *name, mode_t mode,
+                fs_inode_t **inode, struct stat *attr);
+
+// Namespace operations
+int fs_op_rmdir(fs_inode_t *parent, const char *name);
+int fs_op_unlink(fs_inode_t *parent, const char *name);
+int fs_op_rename(fs_inode_t *parent, const char *name,
+                 fs_inode_t *newparent, const char *newname, unsigned int flags);
+
+// Attribute operations (file may be NULL when no handle is available)
+int fs_op_getattr(fs_inode_t *inode, fs_file_t *file, struct stat *stbuf);
+int fs_op_chmod(fs_inode_t *inode, mode_t mode);
+int fs_op_chown(fs_inode_t *inode, uid_t uid, gid_t gid);
+int fs_op_truncate(fs_inode_t *inode, fs_file_t *file, off_t size);
+int fs_op_utimens(fs_inode_t *inode, fs_file_t *file, const struct timespec ts[2]);
+int fs_op_access(fs_inode_t *inode, int mode);
+
+// File operations
+int fs_op_open(fs_inode_t *inode, int flags, fs_file_t **file);
+int fs_op_read(fs_file_t *file, char *buf, size_t size, off_t offset);
+int fs_op_write(fs_file_t *file, const char *buf, size_t size, off_t offset);
+int fs_op_release(fs_file_t *file);
+
+// Server-side copy between two open files on the backing store (bytes
+// copied, which may exceed INT_MAX) and space allocation (FALLOC_FL_* mode)
+ssize_t fs_op_copy_file_range(fs_file_t *in, off_t offset_in, fs_file_t *out, off_t offset_out,
+                              size_t size, unsigned int flags);
+int fs_op_fallocate(fs_file_t *file, int mode, off_t offset, off_t length);
+
+// Durability and space: fsync/fdatasync of the backing fd, the flush sent
+// at every close() of a descriptor, and statvfs of the backing filesystem
+int fs_op_fsync(fs_file_t *file, bool datasync);
+int fs_op_flush(fs_file_t *file);
+int fs_op_statfs(fs_inode_t *inode, struct statvfs *stbuf);
+
+// Reads that libfuse splices to the kernel: splice up to size bytes at
+// offset from file->fd into the calling thread's pipe and return how many
+// were moved (-errno on error), with *pipe_fd set to the pipe's read end.
+// -EOPNOTSUPP means the pipe or the backing file cannot splice this read;
+// use fs_op_read() instead. A reply that failed leaves data in the pipe:
+// fs_op_read_pipe_reset() discards it.
+int fs_op_read_pipe(fs_file_t *file, size_t size, off_t offset, int *pipe_fd);
+void fs_op_read_pipe_reset(void);
+
+// For writes where libfuse moves the data into file->fd itself: the write
+// permission check fs_op_write() makes
+int fs_op_write_check(fs_file_t *file);
+
+// Directory operations
+int fs_op_opendir(fs_inode_t *inode, fs_dir_t **dir);
+int fs_op_readdir(fs_dir_t *dir, off_t offset, bool plus, fs_dir_filler_t filler, void *ctx);
+int fs_op_releasedir(fs_dir_t *dir);
+
+#endif // FS_OPERATIONS_H
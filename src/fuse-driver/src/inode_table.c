@@ -0,0 +1,398 @@
+#define _GNU_SOURCE  /* O_PATH, AT_EMPTY_PATH */
+
+#include "inode_table.h"
+#include "log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define INODE_TABLE_INITIAL_BUCKETS 1024
+
+static pthread_mutex_t table_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Parent links (parent, name) and inode lifetime, for path building. Taken
+// for writing with table_mutex held, so path builders only take it to read
+// and do not wait for lookups that leave every link as it was.
+static pthread_rwlock_t link_lock = PTHREAD_RWLOCK_INITIALIZER;
+static _Atomic uint32_t link_generation = 0;  // Bumped on every link change
+static fs_inode_t **buckets = NULL;
+static size_t bucket_count = 0;      // Always a power of two
+static size_t inode_count = 0;
+static fs_inode_t root_inode = { .fd = -1 };
+
+static inline size_t bucket_of(ino_t ino, dev_t dev, size_t count) {
+    uint64_t h = ((uint64_t)ino * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)dev * 0xC2B2AE3D27D4EB4FULL);
+    return (size_t)(h ^ (h >> 32)) & (count - 1);
+}
+
+// Called with table_mutex held
+static fs_inode_t *hash_find(ino_t ino, dev_t dev) {
+    for (fs_inode_t *inode = buckets[bucket_of(ino, dev, bucket_count)]; inode; inode = inode->hash_next) {
+        if (inode->ino == ino && inode->dev == dev) {
+            return inode;
+        }
+    }
+    return NULL;
+}
+
+// Called with table_mutex held
+static void hash_grow(void) {
+    size_t new_count = bucket_count * 2;
+    fs_inode_t **new_buckets = calloc(new_count, sizeof(fs_inode_t *));
+    if (!new_buckets) {
+        return;  // Keep the current table; chains just get longer
+    }
+
+    for (size_t i = 0; i < bucket_count; i++) {
+        fs_inode_t *inode = buckets[i];
+        while (inode) {
+            fs_inode_t *next = inode->hash_next;
+            size_t b = bucket_of(inode->ino, inode->dev, new_count);
+            inode->hash_next = new_buckets[b];
+            new_buckets[b] = inode;
+            inode = next;
+        }
+    }
+    free(buckets);
+    buckets = new_buckets;
+    bucket_count = new_count;
+}
+
+// Called with table_mutex held
+static void hash_insert(fs_inode_t *inode) {
+    if (inode_count >= bucket_count) {
+        hash_grow();
+    }
+    size_t b = bucket_of(inode->ino, inode->dev, bucket_count);
+    inode->hash_next = buckets[b];
+    buckets[b] = inode;
+    inode_count++;
+}
+
+// Called with table_mutex held
+static void hash_remove(fs_inode_t *inode) {
+    fs_inode_t **link = &buckets[bucket_of(inode->ino, inode->dev, bucket_count)];
+    while (*link && *link != inode) {
+        link = &(*link)->hash_next;
+    }
+    if (*link) {
+        *link = inode->hash_next;
+        inode_count--;
+    }
+}
+
+// Free an inode (and then its ancestors) once nothing references it.
+// Called with table_mutex and link_lock (for writing) held.
+static void release_unused(fs_inode_t *inode) {
+    while (inode && inode != &root_inode && inode->nlookup == 0 && inode->children == 0) {
+        fs_inode_t *parent = inode->parent;
+        hash_remove(inode);
+        close(inode->fd);
+        free(inode->name);
+        free(inode);
+
+        if (parent) {
+            parent->children--;
+        }
+        inode = parent;
+    }
+}
+
+// Point an inode's parent link at parent/name. Called with table_mutex held.
+static void set_link(fs_inode_t *inode, fs_inode_t *parent, const char *name) {
+    if (inode == &root_inode || inode == parent) {
+        return;
+    }
+    if (inode->parent == parent && inode->name && strcmp(inode->name, name) == 0) {
+        return;
+    }
+
+    char *new_name = strdup(name);
+    if (!new_name) {
+        return;  // Keep the old link; it only affects event paths
+    }
+    pthread_rwlock_wrlock(&link_lock);
+    free(inode->name);
+    inode->name = new_name;
+
+    if (inode->parent != parent) {
+        fs_inode_t *old_parent = inode->parent;
+        parent->children++;
+        inode->parent = parent;
+        if (old_parent) {
+            old_parent->children--;
+            release_unused(old_parent);
+        }
+    }
+    atomic_fetch_add_explicit(&link_generation, 1, memory_order_release);
+    pthread_rwlock_unlock(&link_lock);
+}
+
+// Open the storage root and create the table
+int inode_table_init(const char *storage_path) {
+    int fd = open(storage_path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        int err = errno;
+        LOG_ERROR("Inode table: cannot open storage root %s: %s", storage_path, strerror(err));
+        return -err;
+    }
+
+    struct stat st;
+    if (fstatat(fd, "", &st, AT_EMPTY_PATH | AT_SYMLINK_NOFOLLOW) != 0) {
+        int err = errno;
+        LOG_ERROR("Inode table: cannot stat storage root %s: %s", storage_path, strerror(err));
+        close(fd);
+        return -err;
+    }
+
+    pthread_mutex_lock(&table_mutex);
+    buckets = calloc(INODE_TABLE_INITIAL_BUCKETS, sizeof(fs_inode_t *));
+    if (!buckets) {
+        pthread_mutex_unlock(&table_mutex);
+        close(fd);
+        LOG_ERROR("Inode table: memory allocation failed");
+        return -ENOMEM;
+    }
+    bucket_count = INODE_TABLE_INITIAL_BUCKETS;
+    inode_count = 0;
+
+    memset(&root_inode, 0, sizeof(root_inode));
+    root_inode.fd = fd;
+    root_inode.ino = st.st_ino;
+    root_inode.dev = st.st_dev;
+    root_inode.type = st.st_mode & S_IFMT;
+    inode_mode_store(&root_inode, st.st_mode);
+    root_inode.nlookup = 1;  // Never forgotten
+    hash_insert(&root_inode);
+    pthread_mutex_unlock(&table_mutex);
+
+    LOG_INFO("Inode table initialized for %s", storage_path);
+    return 0;
+}
+
+// Close every fd and free the table
+void inode_table_cleanup(void) {
+    pthread_mutex_lock(&table_mutex);
+    pthread_rwlock_wrlock(&link_lock);
+    for (size_t i = 0; i < bucket_count; i++) {
+        fs_inode_t *inode = buckets[i];
+        while (inode) {
+            fs_inode_t *next = inode->hash_next;
+            close(inode->fd);
+            if (inode != &root_inode) {
+                free(inode->name);
+                free(inode);
+            }
+            inode = next;
+        }
+    }
+    free(buckets);
+    buckets = NULL;
+    bucket_count = 0;
+    inode_count = 0;
+    root_inode.fd = -1;
+    pthread_rwlock_unlock(&link_lock);
+    pthread_mutex_unlock(&table_mutex);
+}
+
+// Root inode
+fs_inode_t *inode_table_root(void) {
+    return &root_inode;
+}
+
+// Count a lookup of an inode already in the table. Called with table_mutex held.
+static void take_reference(fs_inode_t *inode, fs_inode_t *parent, const char *name,
+                           const struct stat *attr) {
+    inode->nlookup++;
+    inode_mode_store(inode, attr->st_mode);
+    if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
+        set_link(inode, parent, name);
+    }
+}
+
+// Resolve name in parent. Most lookups hit an inode the table already holds
+// (the kernel looks names up again whenever its entry times out), so stat the
+// name first and only open an O_PATH fd for an inode that is new.
+int inode_table_lookup(fs_inode_t *parent, const char *name, fs_inode_t **inode,
+                       struct stat *attr) {
+    if (fstatat(parent->fd, name, attr, AT_SYMLINK_NOFOLLOW) != 0) {
+        return -errno;
+    }
+
+    pthread_mutex_lock(&table_mutex);
+    fs_inode_t *found = hash_find(attr->st_ino, attr->st_dev);
+    if (found) {
+        take_reference(found, parent, name, attr);
+        pthread_mutex_unlock(&table_mutex);
+        *inode = found;
+        return 0;
+    }
+    pthread_mutex_unlock(&table_mutex);
+
+    // New inode: open it and stat the fd, since the name may have been
+    // replaced since the fstatat() above
+    int fd = openat(parent->fd, name, O_PATH | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+    if (fstatat(fd, "", attr, AT_EMPTY_PATH | AT_SYMLINK_NOFOLLOW) != 0) {
+        int err = -errno;
+        close(fd);
+        return err;
+    }
+
+    pthread_mutex_lock(&table_mutex);
+    bool is_link_name = strcmp(name, ".") != 0 && strcmp(name, "..") != 0;
+    found = hash_find(attr->st_ino, attr->st_dev);
+    if (found) {
+        // Another thread added it in the meantime
+        take_reference(found, parent, name, attr);
+        pthread_mutex_unlock(&table_mutex);
+        close(fd);
+        *inode = found;
+        return 0;
+    }
+
+    fs_inode_t *created = calloc(1, sizeof(fs_inode_t));
+    char *name_copy = strdup(is_link_name ? name : "");
+    if (!created || !name_copy) {
+        pthread_mutex_unlock(&table_mutex);
+        free(created);
+        free(name_copy);
+        close(fd);
+        return -ENOMEM;
+    }
+    created->fd = fd;
+    created->ino = attr->st_ino;
+    created->dev = attr->st_dev;
+    created->type = attr->st_mode & S_IFMT;
+    inode_mode_store(created, attr->st_mode);
+    created->nlookup = 1;
+    created->name = name_copy;
+    if (is_link_name) {
+        created->parent = parent;
+        parent->children++;
+    }
+    hash_insert(created);
+    pthread_mutex_unlock(&table_mutex);
+
+    *inode = created;
+    return 0;
+}
+
+// Drop kernel references
+void inode_table_forget(fs_inode_t *inode, uint64_t nlookup) {
+    pthread_mutex_lock(&table_mutex);
+    if (inode->nlookup < nlookup) {
+        LOG_WARN("Inode table: forget of %llu exceeds lookup count %llu",
+                 (unsigned long long)nlookup, (unsigned long long)inode->nlookup);
+        nlookup = inode->nlookup;
+    }
+    inode->nlookup -= nlookup;
+    if (inode->nlookup == 0) {
+        pthread_rwlock_wrlock(&link_lock);
+        release_unused(inode);
+        pthread_rwlock_unlock(&link_lock);
+    }
+    pthread_mutex_unlock(&table_mutex);
+}
+
+// Record a rename so event paths follow the file
+void inode_table_rename(fs_inode_t *parent, const char *name,
+                        fs_inode_t *newparent, const char *newname) {
+    (void)parent;
+    (void)name;
+
+    struct stat st;
+    if (fstatat(newparent->fd, newname, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&table_mutex);
+    fs_inode_t *inode = hash_find(st.st_ino, st.st_dev);
+    if (inode) {
+        set_link(inode, newparent, newname);
+    }
+    pthread_mutex_unlock(&table_mutex);
+}
+
+// Prepend "/name" segments walking up to the root. Called with link_lock held.
+static size_t build_path(const fs_inode_t *inode, const char *leaf, char *buf, size_t size) {
+    if (size < 2) {
+        return 0;
+    }
+
+    size_t pos = size - 1;
+    buf[pos] = '\0';
+
+    const char *segment = leaf;
+    while (segment || (inode && inode != &root_inode)) {
+        if (!segment && !inode->parent) {
+            return 0;  // Only known as "." or "..": its place is unknown
+        }
+        if (!segment) {
+            segment = inode->name;
+            inode = inode->parent;
+        }
+        size_t len = strlen(segment);
+        if (len + 1 > pos) {
+            return 0;
+        }
+        pos -= len;
+        memcpy(buf + pos, segment, len);
+        buf[--pos] = '/';
+        segment = NULL;
+    }
+
+    if (pos == size - 1) {
+        buf[--pos] = '/';  // The root itself
+    }
+
+    size_t length = size - 1 - pos;
+    memmove(buf, buf + pos, length + 1);
+    return length;
+}
+
+// Mount-relative path of an inode
+size_t inode_table_path(const fs_inode_t *inode, char *buf, size_t size) {
+    pthread_rwlock_rdlock(&link_lock);
+    size_t length = build_path(inode, NULL, buf, size);
+    pthread_rwlock_unlock(&link_lock);
+    return length;
+}
+
+// Mount-relative path of a name inside a directory inode
+size_t inode_table_child_path(const fs_inode_t *parent, const char *name,
+                              char *buf, size_t size) {
+    pthread_rwlock_rdlock(&link_lock);
+    size_t length = build_path(parent, name, buf, size);
+    pthread_rwlock_unlock(&link_lock);
+    return length;
+}
+
+// Link changes so far
+uint32_t inode_table_link_generation(void) {
+    return atomic_load_explicit(&link_generation, memory_order_acquire);
+}
+
+// Visit every inode with the table locked
+void inode_table_foreach(void (*fn)(const fs_inode_t *inode, void *ctx), void *ctx) {
+    pthread_mutex_lock(&table_mutex);
+    for (size_t i = 0; i < bucket_count; i++) {
+        for (fs_inode_t *inode = buckets[i]; inode; inode = inode->hash_next) {
+            fn(inode, ctx);
+        }
+    }
+    pthread_mutex_unlock(&table_mutex);
+}
+
+// Number of inodes currently in the table
+size_t inode_table_count(void) {
+    pthread_mutex_lock(&table_mutex);
+    size_t count = inode_count;
+    pthread_mutex_unlock(&table_mutex);
+    return count;
+}
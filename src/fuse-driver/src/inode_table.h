@@ -0,0 +1,98 @@
+#ifndef INODE_TABLE_H
+#define INODE_TABLE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// Inode table for the low-level FUSE front end.
+//
+// Every backing inode the kernel knows about has one fs_inode_t holding an
+// O_PATH fd, so backend operations use *at() syscalls relative to it instead
+// of rebuilding and re-walking absolute paths. The FUSE nodeid handed to the
+// kernel is the fs_inode_t pointer itself (FUSE_ROOT_ID maps to the storage
+// root). Entries are keyed by backing (st_ino, st_dev), so hard links and
+// repeated lookups share one entry, and are freed once the kernel has
+// forgotten them and no child still references them.
+//
+// Each inode also remembers the parent and name it was last looked up
+// under. That is only used to build paths for events, logs and path-scoped
+// fault rules; all backend work goes through the fds. Building a path only
+// waits for lookups and renames that change a link, and a counter of link
+// changes tells when a value derived from a path may be stale.
+//
+// The owner permission checks in fs_operations.c read the mode cached in
+// the entry instead of calling fstat() each time. Lookup and getattr refresh
+// it; chmod and chown through the mount invalidate it.
+
+#define INODE_MODE_VALID 0x80000000u
+
+typedef struct fs_inode {
+    int fd;                    // O_PATH fd of the backing inode
+    ino_t ino;                 // Backing inode number (hash key)
+    dev_t dev;                 // Backing device (hash key)
+    mode_t type;               // File type bits (S_IFMT) at lookup time
+    _Atomic uint32_t mode;     // Cached st_mode | INODE_MODE_VALID (0 = unknown)
+    uint64_t nlookup;          // Kernel lookup count
+    uint64_t children;         // Inodes whose parent link points here
+    struct fs_inode *parent;   // Parent directory at last lookup (NULL for root)
+    char *name;                // Name in parent at last lookup
+    struct fs_inode *hash_next;
+    _Atomic uint64_t fault_scope; // Path rules matching its path (fault_plan_cache_scope())
+} fs_inode_t;
+
+// Cache the st_mode of an inode
+static inline void inode_mode_store(fs_inode_t *inode, mode_t mode) {
+    atomic_store_explicit(&inode->mode, (uint32_t)mode | INODE_MODE_VALID, memory_order_relaxed);
+}
+
+// Forget the cached st_mode (after changing it)
+static inline void inode_mode_invalidate(fs_inode_t *inode) {
+    atomic_store_explicit(&inode->mode, 0, memory_order_relaxed);
+}
+
+// Open the storage root and create the table (0 or negative errno)
+int inode_table_init(const char *storage_path);
+
+// Close every fd and free the table
+void inode_table_cleanup(void);
+
+// Root inode (the storage directory)
+fs_inode_t *inode_table_root(void);
+
+// Resolve name in parent: returns the inode with its lookup count
+// incremented and fills attr (0 or negative errno)
+int inode_table_lookup(fs_inode_t *parent, const char *name, fs_inode_t **inode,
+                       struct stat *attr);
+
+// Drop nlookup kernel references
+void inode_table_forget(fs_inode_t *inode, uint64_t nlookup);
+
+// Record that parent/name was renamed to newparent/newname
+void inode_table_rename(fs_inode_t *parent, const char *name,
+                        fs_inode_t *newparent, const char *newname);
+
+// Build the mount-relative path ("/dir/file") of an inode into buf.
+// Returns the path length, or 0 if it does not fit or the inode has no
+// parent link (it was only ever looked up as "." or "..").
+size_t inode_table_path(const fs_inode_t *inode, char *buf, size_t size);
+
+// Same for a name inside a directory inode
+size_t inode_table_child_path(const fs_inode_t *parent, const char *name,
+                              char *buf, size_t size);
+
+// Number of parent link changes so far (renames, lookups under another
+// name, wrapping). A path built after reading it is current for as long as
+// it stays the same.
+uint32_t inode_table_link_generation(void);
+
+// Number of inodes currently in the table
+size_t inode_table_count(void);
+
+// Call fn for every inode in the table, with the table locked (fn must not
+// call back into the table). Its parent and name fields are stable meanwhile.
+void inode_table_foreach(void (*fn)(const fs_inode_t *inode, void *ctx), void *ctx);
+
+#endif // INODE_TABLE_H
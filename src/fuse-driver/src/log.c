@@ -1,16 +1,79 @@
 #include "log.h"
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 
-// Log file handle
-static FILE *log_file_handle = NULL;
+// Per-thread ring size (power of two)
+#define LOG_RING_SIZE (256 * 1024)
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
 
-// Current log level
-static log_level_t current_log_level = LOG_INFO;
+// Record header: u32 total size (8-byte aligned), u32 site id, u64 timestamp
+#define LOG_RECORD_HEADER 16
+
+// Site id of the filler record written before the ring wraps
+#define LOG_SITE_PAD 0
+
+// Registered call sites (ids 1..LOG_MAX_SITES-1)
+#define LOG_MAX_SITES 8192
+
+// Arguments per call site and bytes kept per string argument
+#define LOG_MAX_ARGS   16
+#define LOG_MAX_STRING 1024
+
+// Longest formatted line
+#define LOG_LINE_MAX 8192
+
+// How long the writer sleeps when every ring is empty
+#define LOG_DRAIN_INTERVAL_NS (10 * 1000000L)
 
-// Mutex for thread safety
-static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Argument classes, as pulled from the va_list and stored in records. Every
+// class except strings takes 8 bytes; strings are a u32 length plus bytes.
+typedef enum {
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_INTMAX,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,    // Stored as double
+    ARG_STRING,
+    ARG_POINTER,
+    ARG_NONE        // %% and friends
+} arg_type_t;
+
+// One conversion specification in a format string
+typedef struct {
+    const char *start;   // At the '%'
+    size_t len;
+    int stars;           // '*' width/precision, each takes an int argument
+    arg_type_t type;
+} spec_t;
+
+// Parsed call site
+typedef struct {
+    log_level_t level;
+    const char *format;
+    uint8_t nargs;
+    uint8_t types[LOG_MAX_ARGS];
+} site_info_t;
+
+// Single-producer/single-consumer ring owned by one thread. head and tail
+// count bytes ever written/consumed; records never straddle the end.
+typedef struct log_ring {
+    _Atomic uint64_t head;               // Written by the owning thread
+    char pad1[64 - sizeof(uint64_t)];
+    _Atomic uint64_t tail;               // Written by the drain
+    char pad2[64 - sizeof(uint64_t)];
+    _Atomic uint64_t dropped;            // Records lost because the ring was full
+    atomic_bool orphaned;                // Owning thread has exited
+    struct log_ring *next;
+    unsigned char data[LOG_RING_SIZE];
+} log_ring_t;
+
+// Current log level
+log_level_t log_current_level = LOG_INFO;
 
 // Log level strings
 static const char *level_strings[] = {
@@ -20,18 +83,665 @@ static const char *level_strings[] = {
     "DEBUG"
 };
 
+// Output state (state_mutex)
+static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FILE *log_file_handle = NULL;
+static bool binary_format = false;
+static atomic_bool log_open = false;
+
+// Writer thread
+static pthread_t writer_thread;
+static atomic_bool writer_running = false;
+static atomic_bool writer_stop = false;
+
+// Drain state (drain_mutex)
+static pthread_mutex_t drain_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool site_written[LOG_MAX_SITES];    // Binary: site definition already written
+static uint64_t dropped_reported = 0;
+static uint64_t dropped_retired = 0;        // Drops counted by rings already freed
+
+// Ring registry (rings_mutex)
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static log_ring_t *rings = NULL;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+static __thread log_ring_t *tls_ring = NULL;
+
+// Site registry (sites_mutex for registration; readers index lock-free)
+static pthread_mutex_t sites_mutex = PTHREAD_MUTEX_INITIALIZER;
+static site_info_t *site_table[LOG_MAX_SITES];
+static uint32_t site_count = 0;
+
+// Parse the conversion specification starting at p ('%'). Returns its end.
+static const char *parse_spec(const char *p, spec_t *spec) {
+    spec->start = p++;
+    spec->stars = 0;
+    spec->type = ARG_NONE;
+
+    if (*p == '%') {
+        spec->len = 2;
+        return p + 1;
+    }
+
+    while (*p && strchr("-+ #0'", *p)) {
+        p++;
+    }
+    if (*p == '*') {
+        spec->stars++;
+        p++;
+    } else {
+        while (isdigit((unsigned char)*p)) p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->stars++;
+            p++;
+        } else {
+            while (isdigit((unsigned char)*p)) p++;
+        }
+    }
+
+    char length = 0;
+    switch (*p) {
+        case 'h': p++; if (*p == 'h') p++; break;
+        case 'l': p++; if (*p == 'l') { p++; length = 'q'; } else { length = 'l'; } break;
+        case 'q': p++; length = 'q'; break;
+        case 'L': p++; length = 'L'; break;
+        case 'z': case 'Z': p++; length = 'z'; break;
+        case 'j': p++; length = 'j'; break;
+        case 't': p++; length = 't'; break;
+    }
+
+    char conversion = *p;
+    if (conversion) {
+        p++;
+    }
+    switch (conversion) {
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+            spec->type = length == 'l' ? ARG_LONG :
+                         length == 'q' ? ARG_LLONG :
+                         length == 'z' ? ARG_SIZE :
+                         length == 'j' ? ARG_INTMAX :
+                         length == 't' ? ARG_PTRDIFF : ARG_INT;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec->type = length == 'L' ? ARG_LDOUBLE : ARG_DOUBLE;
+            break;
+        case 's':
+            spec->type = ARG_STRING;
+            break;
+        case 'p':
+            spec->type = ARG_POINTER;
+            break;
+        default:
+            break;  // %m, %n and unknown conversions take no argument here
+    }
+
+    spec->len = (size_t)(p - spec->start);
+    return p;
+}
+
+// Assign an id to a call site and parse its format (once per site)
+static uint32_t register_site(log_site_t *site) {
+    pthread_mutex_lock(&sites_mutex);
+    uint32_t id = atomic_load_explicit(&site->id, memory_order_relaxed);
+    if (id != 0 || site_count + 1 >= LOG_MAX_SITES) {
+        pthread_mutex_unlock(&sites_mutex);
+        return id;
+    }
+
+    site_info_t *info = calloc(1, sizeof(site_info_t));
+    if (!info) {
+        pthread_mutex_unlock(&sites_mutex);
+        return 0;
+    }
+    info->level = site->level;
+    info->format = site->format;
+
+    for (const char *p = site->format; *p; ) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        spec_t spec;
+        p = parse_spec(p, &spec);
+        for (int i = 0; i < spec.stars && info->nargs < LOG_MAX_ARGS; i++) {
+            info->types[info->nargs++] = ARG_INT;
+        }
+        if (spec.type != ARG_NONE && info->nargs < LOG_MAX_ARGS) {
+            info->types[info->nargs++] = spec.type;
+        }
+    }
+
+    id = ++site_count;
+    site_table[id] = info;
+    atomic_store_explicit(&site->id, id, memory_order_release);
+    pthread_mutex_unlock(&sites_mutex);
+    return id;
+}
+
+// Thread exit: the drain frees the ring once it is empty
+static void ring_release(void *arg) {
+    log_ring_t *ring = arg;
+    atomic_store_explicit(&ring->orphaned, true, memory_order_release);
+}
+
+static void ring_key_create(void) {
+    pthread_key_create(&ring_key, ring_release);
+}
+
+// The calling thread's ring (created on first use)
+static log_ring_t *ring_get(void) {
+    if (tls_ring) {
+        return tls_ring;
+    }
+
+    pthread_once(&ring_key_once, ring_key_create);
+    log_ring_t *ring = NULL;
+    if (posix_memalign((void **)&ring, 64, sizeof(log_ring_t)) != 0) {
+        return NULL;
+    }
+    memset(ring, 0, offsetof(log_ring_t, data));
+
+    pthread_mutex_lock(&rings_mutex);
+    ring->next = rings;
+    rings = ring;
+    pthread_mutex_unlock(&rings_mutex);
+
+    pthread_setspecific(ring_key, ring);
+    tls_ring = ring;
+    return ring;
+}
+
+static void *writer_main(void *arg);
+
+// Start the writer thread (lazily, so it also comes back after a fork)
+static void writer_start(void) {
+    pthread_mutex_lock(&state_mutex);
+    if (!atomic_load(&writer_running) && atomic_load(&log_open)) {
+        atomic_store(&writer_stop, false);
+        if (pthread_create(&writer_thread, NULL, writer_main, NULL) == 0) {
+            atomic_store(&writer_running, true);
+        }
+    }
+    pthread_mutex_unlock(&state_mutex);
+}
+
+// Record a message: copy the site id, a timestamp and the raw arguments into
+// this thread's ring
+void log_record(log_site_t *site, ...) {
+    if (!atomic_load_explicit(&log_open, memory_order_relaxed)) {
+        return;
+    }
+    if (!atomic_load_explicit(&writer_running, memory_order_relaxed)) {
+        writer_start();
+    }
+
+    uint32_t id = atomic_load_explicit(&site->id, memory_order_acquire);
+    if (id == 0 && (id = register_site(site)) == 0) {
+        return;
+    }
+    const site_info_t *info = site_table[id];
+
+    log_ring_t *ring = ring_get();
+    if (!ring) {
+        return;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t timestamp = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+
+    // Size the record (only strings vary)
+    va_list ap;
+    va_start(ap, site);
+    size_t size = LOG_RECORD_HEADER;
+    for (uint8_t i = 0; i < info->nargs; i++) {
+        switch (info->types[i]) {
+            case ARG_INT:     (void)va_arg(ap, int); size += 8; break;
+            case ARG_LONG:    (void)va_arg(ap, long); size += 8; break;
+            case ARG_LLONG:   (void)va_arg(ap, long long); size += 8; break;
+            case ARG_SIZE:    (void)va_arg(ap, size_t); size += 8; break;
+            case ARG_INTMAX:  (void)va_arg(ap, intmax_t); size += 8; break;
+            case ARG_PTRDIFF: (void)va_arg(ap, ptrdiff_t); size += 8; break;
+            case ARG_DOUBLE:  (void)va_arg(ap, double); size += 8; break;
+            case ARG_LDOUBLE: (void)va_arg(ap, long double); size += 8; break;
+            case ARG_POINTER: (void)va_arg(ap, void *); size += 8; break;
+            case ARG_STRING: {
+                const char *s = va_arg(ap, const char *);
+                size += 4 + strnlen(s ? s : "(null)", LOG_MAX_STRING);
+                break;
+            }
+            default: break;
+        }
+    }
+    va_end(ap);
+    size = (size + 7) & ~(size_t)7;
+
+    // Reserve contiguous space, padding out the end of the ring if needed
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t pos = head & LOG_RING_MASK;
+    size_t to_end = LOG_RING_SIZE - pos;
+    size_t needed = size + (to_end < size ? to_end : 0);
+    if (LOG_RING_SIZE - (head - tail) < needed) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    if (to_end < size) {
+        uint32_t pad[2] = { (uint32_t)to_end, LOG_SITE_PAD };
+        memcpy(ring->data + pos, pad, sizeof(pad));
+        pos = 0;
+    }
+
+    // Write the record
+    unsigned char *out = ring->data + pos;
+    uint32_t header[2] = { (uint32_t)size, id };
+    memcpy(out, header, sizeof(header));
+    memcpy(out + 8, &timestamp, 8);
+    out += LOG_RECORD_HEADER;
+
+    va_start(ap, site);
+    for (uint8_t i = 0; i < info->nargs; i++) {
+        uint64_t value = 0;
+        switch (info->types[i]) {
+            case ARG_INT:     value = (uint64_t)(int64_t)va_arg(ap, int); break;
+            case ARG_LONG:    value = (uint64_t)(int64_t)va_arg(ap, long); break;
+            case ARG_LLONG:   value = (uint64_t)va_arg(ap, long long); break;
+            case ARG_SIZE:    value = (uint64_t)va_arg(ap, size_t); break;
+            case ARG_INTMAX:  value = (uint64_t)va_arg(ap, intmax_t); break;
+            case ARG_PTRDIFF: value = (uint64_t)va_arg(ap, ptrdiff_t); break;
+            case ARG_POINTER: value = (uint64_t)(uintptr_t)va_arg(ap, void *); break;
+            case ARG_DOUBLE: {
+                double d = va_arg(ap, double);
+                memcpy(&value, &d, 8);
+                break;
+            }
+            case ARG_LDOUBLE: {
+                double d = (double)va_arg(ap, long double);
+                memcpy(&value, &d, 8);
+                break;
+            }
+            case ARG_STRING: {
+                const char *s = va_arg(ap, const char *);
+                if (!s) s = "(null)";
+                uint32_t len = (uint32_t)strnlen(s, LOG_MAX_STRING);
+                memcpy(out, &len, 4);
+                memcpy(out + 4, s, len);
+                out += 4 + len;
+                continue;
+            }
+            default:
+                continue;
+        }
+        memcpy(out, &value, 8);
+        out += 8;
+    }
+    va_end(ap);
+
+    atomic_store_explicit(&ring->head, head + needed, memory_order_release);
+}
+
+// Read the next 8-byte argument (0 once the block is exhausted)
+static uint64_t take_word(const unsigned char **args, const unsigned char *end) {
+    uint64_t value = 0;
+    if (end - *args >= 8) {
+        memcpy(&value, *args, 8);
+        *args += 8;
+    } else {
+        *args = end;
+    }
+    return value;
+}
+
+// Format one record as a log line
+size_t log_format_line(log_level_t level, const char *format, uint64_t timestamp_ns,
+                       const unsigned char *args, size_t args_len,
+                       char *out, size_t out_size) {
+    // Only the drain (or the offline decoder) formats, so a one-entry cache
+    // of the local time is enough to skip most localtime_r() calls
+    static time_t cached_second = -1;
+    static struct tm cached_tm;
+
+    if (out_size < 2) {
+        return 0;
+    }
+    if (level < LOG_ERROR || level > LOG_DEBUG) {
+        level = LOG_DEBUG;
+    }
+
+    time_t second = (time_t)(timestamp_ns / 1000000000ULL);
+    if (second != cached_second) {
+        localtime_r(&second, &cached_tm);
+        cached_second = second;
+    }
+
+    // Print log header: [LEVEL] [Time]
+    int header = snprintf(out, out_size, "[%s] [%02d:%02d:%02d] ", level_strings[level],
+                          cached_tm.tm_hour, cached_tm.tm_min, cached_tm.tm_sec);
+    size_t used = header > 0 ? (size_t)header : 0;
+    size_t limit = out_size - 1;   // Room for the newline
+    if (used > limit) used = limit;
+
+    const unsigned char *arg = args;
+    const unsigned char *end = args + args_len;
+    for (const char *p = format; *p && used < limit; ) {
+        if (*p != '%') {
+            out[used++] = *p++;
+            continue;
+        }
+
+        spec_t spec;
+        p = parse_spec(p, &spec);
+        if (spec.len >= 32) {
+            continue;  // Not a conversion we could have recorded
+        }
+        char spec_str[32];
+        memcpy(spec_str, spec.start, spec.len);
+        spec_str[spec.len] = '\0';
+
+        int stars[2] = { 0, 0 };
+        for (int i = 0; i < spec.stars && i < 2; i++) {
+            stars[i] = (int)(int64_t)take_word(&arg, end);
+        }
+
+        char *dst = out + used;
+        size_t room = limit - used + 1;
+        int n = 0;
+
+#define FORMAT_VALUE(value) \
+        (spec.stars == 0 ? snprintf(dst, room, spec_str, value) : \
+         spec.stars == 1 ? snprintf(dst, room, spec_str, stars[0], value) : \
+                           snprintf(dst, room, spec_str, stars[0], stars[1], value))
+
+        switch (spec.type) {
+            case ARG_NONE:
+                n = spec.len == 2 && spec.start[1] == '%' ? snprintf(dst, room, "%%") : 0;
+                break;
+            case ARG_INT:     n = FORMAT_VALUE((int)take_word(&arg, end)); break;
+            case ARG_LONG:    n = FORMAT_VALUE((long)take_word(&arg, end)); break;
+            case ARG_LLONG:   n = FORMAT_VALUE((long long)take_word(&arg, end)); break;
+            case ARG_SIZE:    n = FORMAT_VALUE((size_t)take_word(&arg, end)); break;
+            case ARG_INTMAX:  n = FORMAT_VALUE((intmax_t)take_word(&arg, end)); break;
+            case ARG_PTRDIFF: n = FORMAT_VALUE((ptrdiff_t)take_word(&arg, end)); break;
+            case ARG_POINTER: n = FORMAT_VALUE((void *)(uintptr_t)take_word(&arg, end)); break;
+            case ARG_DOUBLE:
+            case ARG_LDOUBLE: {
+                uint64_t bits = take_word(&arg, end);
+                double d;
+                memcpy(&d, &bits, 8);
+                if (spec.type == ARG_LDOUBLE) {
+                    n = FORMAT_VALUE((long double)d);
+                } else {
+                    n = FORMAT_VALUE(d);
+                }
+                break;
+            }
+            case ARG_STRING: {
+                char text[LOG_MAX_STRING + 1];
+                uint32_t len = 0;
+                if (end - arg >= 4) {
+                    memcpy(&len, arg, 4);
+                    arg += 4;
+                }
+                if (len > (size_t)(end - arg)) len = (uint32_t)(end - arg);
+                if (len > LOG_MAX_STRING) len = LOG_MAX_STRING;
+                memcpy(text, arg, len);
+                text[len] = '\0';
+                arg += len;
+                n = FORMAT_VALUE(text);
+                break;
+            }
+        }
+#undef FORMAT_VALUE
+
+        if (n > 0) {
+            used += (size_t)n < room ? (size_t)n : room - 1;
+        }
+    }
+
+    // Add newline if not present
+    if (used == 0 || out[used - 1] != '\n') {
+        out[used++] = '\n';
+    }
+    out[used] = '\0';
+    return used;
+}
+
+// Write a formatted line (or binary entry) for one record. Called with
+// drain_mutex held.
+static void emit_record(uint32_t id, uint64_t timestamp, const unsigned char *args, size_t args_len) {
+    const site_info_t *info = site_table[id];
+    if (!info) {
+        return;
+    }
+
+    if (binary_format) {
+        if (!site_written[id]) {
+            uint8_t level = (uint8_t)info->level;
+            uint16_t format_len = (uint16_t)strnlen(info->format, UINT16_MAX);
+            fputc('S', log_file_handle);
+            fwrite(&id, 4, 1, log_file_handle);
+            fwrite(&level, 1, 1, log_file_handle);
+            fwrite(&format_len, 2, 1, log_file_handle);
+            fwrite(info->format, 1, format_len, log_file_handle);
+            site_written[id] = true;
+        }
+        uint32_t len = (uint32_t)args_len;
+        fputc('R', log_file_handle);
+        fwrite(&id, 4, 1, log_file_handle);
+        fwrite(&timestamp, 8, 1, log_file_handle);
+        fwrite(&len, 4, 1, log_file_handle);
+        fwrite(args, 1, args_len, log_file_handle);
+        return;
+    }
+
+    char line[LOG_LINE_MAX];
+    size_t n = log_format_line(info->level, info->format, timestamp, args, args_len,
+                               line, sizeof(line));
+    fwrite(line, 1, n, log_file_handle);
+}
+
+// Skip filler records; returns the next record of a ring or NULL
+static const unsigned char *ring_peek(log_ring_t *ring, uint64_t head) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    while (tail < head) {
+        const unsigned char *record = ring->data + (tail & LOG_RING_MASK);
+        uint32_t header[2];
+        memcpy(header, record, sizeof(header));
+        if (header[1] != LOG_SITE_PAD) {
+            return record;
+        }
+        tail += header[0];
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    return NULL;
+}
+
+// Drain every ring, merging records in timestamp order. Called with
+// drain_mutex and rings_mutex held. Returns the number of records written.
+static size_t drain_locked(void) {
+    if (!log_file_handle) {
+        return 0;
+    }
+
+    // Snapshot how far each ring has been written; later records wait for
+    // the next pass, which keeps one pass bounded
+    size_t ring_count = 0;
+    for (log_ring_t *ring = rings; ring; ring = ring->next) {
+        ring_count++;
+    }
+    if (ring_count == 0) {
+        return 0;
+    }
+    log_ring_t **list = malloc(ring_count * sizeof(log_ring_t *));
+    uint64_t *heads = malloc(ring_count * sizeof(uint64_t));
+    if (!list || !heads) {
+        free(list);
+        free(heads);
+        return 0;
+    }
+    size_t i = 0;
+    uint64_t dropped = dropped_retired;
+    for (log_ring_t *ring = rings; ring; ring = ring->next, i++) {
+        list[i] = ring;
+        heads[i] = atomic_load_explicit(&ring->head, memory_order_acquire);
+        dropped += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    }
+
+    size_t written = 0;
+    for (;;) {
+        // Pick the oldest pending record across rings
+        size_t best = ring_count;
+        uint64_t best_ts = 0;
+        const unsigned char *best_record = NULL;
+        for (i = 0; i < ring_count; i++) {
+            const unsigned char *record = ring_peek(list[i], heads[i]);
+            if (!record) {
+                continue;
+            }
+            uint64_t ts;
+            memcpy(&ts, record + 8, 8);
+            if (best == ring_count || ts < best_ts) {
+                best = i;
+                best_ts = ts;
+                best_record = record;
+            }
+        }
+        if (best == ring_count) {
+            break;
+        }
+
+        uint32_t header[2];
+        memcpy(header, best_record, sizeof(header));
+        emit_record(header[1], best_ts, best_record + LOG_RECORD_HEADER,
+                    header[0] - LOG_RECORD_HEADER);
+        uint64_t tail = atomic_load_explicit(&list[best]->tail, memory_order_relaxed);
+        atomic_store_explicit(&list[best]->tail, tail + header[0], memory_order_release);
+        written++;
+    }
+
+    // Report messages lost to full rings
+    if (dropped > dropped_reported) {
+        if (binary_format) {
+            fputc('D', log_file_handle);
+            fwrite(&dropped, 8, 1, log_file_handle);
+        } else {
+            time_t now = time(NULL);
+            struct tm tm_now;
+            localtime_r(&now, &tm_now);
+            fprintf(log_file_handle, "[%s] [%02d:%02d:%02d] Logger: %llu messages dropped (ring buffer full)\n",
+                    level_strings[LOG_WARN], tm_now.tm_hour, tm_now.tm_min, tm_now.tm_sec,
+                    (unsigned long long)dropped);
+        }
+        dropped_reported = dropped;
+    }
+
+    // Free the rings of exited threads once they are empty
+    log_ring_t **link = &rings;
+    while (*link) {
+        log_ring_t *ring = *link;
+        if (atomic_load_explicit(&ring->orphaned, memory_order_acquire) &&
+            atomic_load(&ring->tail) == atomic_load(&ring->head)) {
+            *link = ring->next;
+            dropped_retired += atomic_load(&ring->dropped);
+            free(ring);
+        } else {
+            link = &ring->next;
+        }
+    }
+
+    free(list);
+    free(heads);
+    if (written > 0) {
+        fflush(log_file_handle);
+    }
+    return written;
+}
+
+static size_t drain(void) {
+    pthread_mutex_lock(&drain_mutex);
+    pthread_mutex_lock(&rings_mutex);
+    size_t written = drain_locked();
+    pthread_mutex_unlock(&rings_mutex);
+    pthread_mutex_unlock(&drain_mutex);
+    return written;
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    struct timespec interval = { 0, LOG_DRAIN_INTERVAL_NS };
+
+    while (!atomic_load(&writer_stop)) {
+        if (drain() == 0) {
+            nanosleep(&interval, NULL);
+        }
+    }
+    return NULL;
+}
+
+// Stop the writer thread. Called with state_mutex held.
+static void writer_join(void) {
+    if (atomic_load(&writer_running)) {
+        atomic_store(&writer_stop, true);
+        pthread_join(writer_thread, NULL);
+        atomic_store(&writer_running, false);
+    }
+}
+
+// fork(): write out everything buffered so neither process repeats or loses
+// it, and keep the registries consistent across the fork
+static void log_atfork_prepare(void) {
+    pthread_mutex_lock(&state_mutex);
+    pthread_mutex_lock(&drain_mutex);
+    pthread_mutex_lock(&rings_mutex);
+    drain_locked();
+    pthread_mutex_lock(&sites_mutex);
+}
+
+static void log_atfork_parent(void) {
+    pthread_mutex_unlock(&sites_mutex);
+    pthread_mutex_unlock(&rings_mutex);
+    pthread_mutex_unlock(&drain_mutex);
+    pthread_mutex_unlock(&state_mutex);
+}
+
+static void log_atfork_child(void) {
+    // Only the forking thread survives: its ring stays, the others are
+    // drained and freed, and the writer restarts on the next message
+    for (log_ring_t *ring = rings; ring; ring = ring->next) {
+        if (ring != tls_ring) {
+            atomic_store(&ring->orphaned, true);
+        }
+    }
+    atomic_store(&writer_running, false);
+    log_atfork_parent();
+}
+
+static void log_atfork_register(void) {
+    pthread_atfork(log_atfork_prepare, log_atfork_parent, log_atfork_child);
+}
+
+// Select the binary log format
+void log_set_binary(bool binary) {
+    pthread_mutex_lock(&state_mutex);
+    binary_format = binary;
+    pthread_mutex_unlock(&state_mutex);
+}
+
 // Initialize logging system
 void log_init(const char *log_file, log_level_t level) {
-    pthread_mutex_lock(&log_mutex);
-    
+    static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+    pthread_once(&atfork_once, log_atfork_register);
+
+    log_close();
+
+    pthread_mutex_lock(&state_mutex);
+
     // Set log level
-    current_log_level = level;
-    
-    // Close previous log file if open
-    if (log_file_handle != NULL && log_file_handle != stdout) {
-        fclose(log_file_handle);
-    }
-    
+    log_current_level = level;
+
     // Open log file
     if (log_file == NULL || strcmp(log_file, "stdout") == 0) {
         log_file_handle = stdout;
@@ -42,62 +752,42 @@ void log_init(const char *log_file, log_level_t level) {
             log_file_handle = stdout;
         }
     }
-    
-    // Log initialization
-    time_t now = time(NULL);
-    char time_str[26];
-    ctime_r(&now, time_str);
-    time_str[24] = '\0';  // Remove trailing newline
-    
-    fprintf(log_file_handle, "--- Log initialized at %s ---\n", time_str);
+
+    pthread_mutex_lock(&drain_mutex);
+    memset(site_written, 0, sizeof(site_written));
+    pthread_mutex_unlock(&drain_mutex);
+
+    if (binary_format) {
+        // Every session starts with the magic; the decoder resets its site
+        // table there, so appended sessions decode independently
+        fwrite(LOG_BINARY_MAGIC, 1, strlen(LOG_BINARY_MAGIC), log_file_handle);
+    } else {
+        // Log initialization
+        time_t now = time(NULL);
+        char time_str[26];
+        ctime_r(&now, time_str);
+        time_str[24] = '\0';  // Remove trailing newline
+
+        fprintf(log_file_handle, "--- Log initialized at %s ---\n", time_str);
+    }
     fflush(log_file_handle);
-    
-    pthread_mutex_unlock(&log_mutex);
+
+    atomic_store(&log_open, true);
+    pthread_mutex_unlock(&state_mutex);
 }
 
 // Close logging system
 void log_close(void) {
-    pthread_mutex_lock(&log_mutex);
-    
+    pthread_mutex_lock(&state_mutex);
+
+    atomic_store(&log_open, false);
+    writer_join();
+    drain();
+
     if (log_file_handle != NULL && log_file_handle != stdout) {
         fclose(log_file_handle);
     }
     log_file_handle = NULL;
-    
-    pthread_mutex_unlock(&log_mutex);
-}
 
-// Log a message with specific level
-void log_message(log_level_t level, const char *format, ...) {
-    // Skip if level is higher than current level
-    if (level > current_log_level || log_file_handle == NULL) {
-        return;
-    }
-    
-    pthread_mutex_lock(&log_mutex);
-    
-    // Get current time
-    time_t now = time(NULL);
-    struct tm tm_now;
-    localtime_r(&now, &tm_now);
-    
-    // Print log header: [LEVEL] [Time]
-    fprintf(log_file_handle, "[%s] [%02d:%02d:%02d] ", 
-            level_strings[level],
-            tm_now.tm_hour, tm_now.tm_min, tm_now.tm_sec);
-    
-    // Print log message
-    va_list args;
-    va_start(args, format);
-    vfprintf(log_file_handle, format, args);
-    va_end(args);
-    
-    // Add newline if not present
-    if (format[strlen(format) - 1] != '\n') {
-        fprintf(log_file_handle, "\n");
-    }
-    
-    fflush(log_file_handle);
-    
-    pthread_mutex_unlock(&log_mutex);
-}
\ No newline at end of file
+    pthread_mutex_unlock(&state_mutex);
+}
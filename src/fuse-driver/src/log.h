@@ -3,6 +3,10 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
 // Log levels
@@ -13,19 +17,71 @@ typedef enum {
     LOG_DEBUG   // Detailed debug information
 } log_level_t;
 
+// Deferred-formatting logger.
+//
+// Every LOG_* call site owns a static log_site_t with its level and format
+// string. The first time a site fires, its format is parsed once and the site
+// gets a numeric id; after that a call only copies the id, a timestamp and the
+// raw argument values into the calling thread's ring buffer (no lock, no
+// formatting, no syscall). A background thread drains all rings in batches,
+// merges them in timestamp order and writes formatted lines, or raw records
+// when the binary format is selected (tools/log_decode formats those offline).
+// Arguments of disabled levels are not evaluated. Formats must be string
+// literals.
+
+typedef struct {
+    log_level_t level;
+    const char *format;
+    _Atomic uint32_t id;    // 0 = not registered yet
+} log_site_t;
+
+// Current log level (checked at the call site)
+extern log_level_t log_current_level;
+
+// Select the binary log format (call before log_init)
+void log_set_binary(bool binary);
+
 // Initialize logging system
 void log_init(const char *log_file, log_level_t level);
 
-// Close logging system
+// Close logging system (writes out everything still buffered)
 void log_close(void);
 
-// Log a message with specific level
-void log_message(log_level_t level, const char *format, ...);
+// Record a message for a call site (use the LOG_* macros)
+void log_record(log_site_t *site, ...);
+
+// Format one record as a log line ("[LEVEL] [hh:mm:ss] message\n") from its
+// raw argument block. Shared with the binary log decoder. Returns the length.
+size_t log_format_line(log_level_t level, const char *format, uint64_t timestamp_ns,
+                       const unsigned char *args, size_t args_len,
+                       char *out, size_t out_size);
+
+// Binary log layout: LOG_BINARY_MAGIC, then entries starting with one kind
+// byte (all integers little-endian, native width as listed):
+//   'S' u32 id, u8 level, u16 format length, format bytes   (site definition)
+//   'R' u32 id, u64 timestamp ns, u32 args length, args      (record)
+//   'D' u64 total dropped messages                           (drop notice)
+#define LOG_BINARY_MAGIC "NASLOGB1"
+
+// Never called; lets the compiler check LOG_* arguments against the format
+static inline __attribute__((format(printf, 1, 2))) void log_format_check(const char *format, ...) {
+    (void)format;
+}
+
+#define LOG_AT(lvl, fmt, ...) do { \
+        static log_site_t log_site_ = { (lvl), (fmt), 0 }; \
+        if (0) { \
+            log_format_check(fmt, ##__VA_ARGS__); \
+        } \
+        if ((lvl) <= log_current_level) { \
+            log_record(&log_site_, ##__VA_ARGS__); \
+        } \
+    } while (0)
 
 // Helper macros for easier usage
-#define LOG_ERROR(fmt, ...) log_message(LOG_ERROR, fmt, ##__VA_ARGS__)
-#define LOG_WARN(fmt, ...)  log_message(LOG_WARN, fmt, ##__VA_ARGS__)
-#define LOG_INFO(fmt, ...)  log_message(LOG_INFO, fmt, ##__VA_ARGS__)
-#define LOG_DEBUG(fmt, ...) log_message(LOG_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)  LOG_AT(LOG_WARN, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)  LOG_AT(LOG_INFO, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_DEBUG, fmt, ##__VA_ARGS__)
 
-#endif // LOG_H
\ No newline at end of file
+#endif // LOG_H
@@ -0,0 +1,195 @@
+#include "op_stats.h"
+#include "log.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OP_STATS_CACHELINE 64
+
+// One shard per thread. Only the owning thread writes it, so increments are
+// plain relaxed load/store pairs rather than locked read-modify-writes.
+typedef struct op_stats_shard {
+    _Alignas(OP_STATS_CACHELINE) atomic_uint_fast64_t op_counts[FS_OP_COUNT];
+    atomic_uint_fast64_t bytes_read;
+    atomic_uint_fast64_t bytes_written;
+    atomic_uint_fast64_t faults[FS_FAULT_COUNT];
+    atomic_uint_fast64_t mode_cache_hits;
+    atomic_uint_fast64_t mode_cache_misses;
+    struct op_stats_shard *next;       // Registry link (never unlinked)
+    struct op_stats_shard *next_free;  // Free list link (shards of exited threads)
+} op_stats_shard_t;
+
+// Global sequence number - the one intentionally shared counter
+static _Alignas(OP_STATS_CACHELINE) atomic_uint_fast64_t op_sequence;
+
+// Registry of every shard ever handed out (readers walk it lock-free)
+static _Atomic(op_stats_shard_t *) shard_list = NULL;
+
+// Shards released by exited threads, reused by new ones
+static op_stats_shard_t *free_shards = NULL;
+static pthread_mutex_t free_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_key_t shard_key;
+static pthread_once_t shard_key_once = PTHREAD_ONCE_INIT;
+
+static __thread op_stats_shard_t *tls_shard = NULL;
+
+// Return a thread's shard to the free list when the thread exits
+static void shard_release(void *arg) {
+    op_stats_shard_t *shard = arg;
+    pthread_mutex_lock(&free_mutex);
+    shard->next_free = free_shards;
+    free_shards = shard;
+    pthread_mutex_unlock(&free_mutex);
+}
+
+static void shard_key_create(void) {
+    pthread_key_create(&shard_key, shard_release);
+}
+
+// Slow path: claim a shard for the calling thread
+static op_stats_shard_t *shard_acquire(void) {
+    pthread_once(&shard_key_once, shard_key_create);
+
+    pthread_mutex_lock(&free_mutex);
+    op_stats_shard_t *shard = free_shards;
+    if (shard) {
+        free_shards = shard->next_free;
+    }
+    pthread_mutex_unlock(&free_mutex);
+
+    if (!shard) {
+        shard = aligned_alloc(OP_STATS_CACHELINE, sizeof(op_stats_shard_t));
+        if (!shard) {
+            LOG_ERROR("Operation stats: failed to allocate counter shard");
+            return NULL;
+        }
+        memset(shard, 0, sizeof(*shard));
+
+        // Publish into the registry
+        op_stats_shard_t *head = atomic_load(&shard_list);
+        do {
+            shard->next = head;
+        } while (!atomic_compare_exchange_weak(&shard_list, &head, shard));
+    }
+
+    pthread_setspecific(shard_key, shard);
+    tls_shard = shard;
+    return shard;
+}
+
+static inline op_stats_shard_t *shard_get(void) {
+    op_stats_shard_t *shard = tls_shard;
+    if (__builtin_expect(shard == NULL, 0)) {
+        shard = shard_acquire();
+    }
+    return shard;
+}
+
+// Single-writer increment (no lock prefix needed)
+static inline void shard_add(atomic_uint_fast64_t *counter, uint64_t value) {
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+}
+
+// Reset all counters
+void op_stats_init(void) {
+    atomic_store(&op_sequence, 0);
+
+    // Shards are never freed; zero the ones that already exist
+    for (op_stats_shard_t *shard = atomic_load(&shard_list); shard; shard = shard->next) {
+        for (int i = 0; i < FS_OP_COUNT; i++) {
+            atomic_store_explicit(&shard->op_counts[i], 0, memory_order_relaxed);
+        }
+        for (int i = 0; i < FS_FAULT_COUNT; i++) {
+            atomic_store_explicit(&shard->faults[i], 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&shard->bytes_read, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->bytes_written, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->mode_cache_hits, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->mode_cache_misses, 0, memory_order_relaxed);
+    }
+}
+
+// Claim the next global sequence number
+uint64_t op_stats_next_sequence(void) {
+    return atomic_fetch_add_explicit(&op_sequence, 1, memory_order_relaxed);
+}
+
+// Sequence numbers claimed so far
+uint64_t op_stats_sequence(void) {
+    return atomic_load_explicit(&op_sequence, memory_order_relaxed);
+}
+
+// Count one operation of the given type
+void op_stats_count_op(fs_op_type_t operation) {
+    op_stats_shard_t *shard = shard_get();
+    if (shard) {
+        shard_add(&shard->op_counts[operation], 1);
+    }
+}
+
+// Account bytes transferred by a read or write
+void op_stats_add_bytes(fs_op_type_t operation, size_t bytes) {
+    op_stats_shard_t *shard = shard_get();
+    if (!shard) {
+        return;
+    }
+
+    if (operation == FS_OP_READ) {
+        shard_add(&shard->bytes_read, bytes);
+    } else if (operation == FS_OP_WRITE) {
+        shard_add(&shard->bytes_written, bytes);
+    }
+}
+
+// Count one injected fault
+void op_stats_count_fault(fs_fault_type_t fault) {
+    op_stats_shard_t *shard = shard_get();
+    if (shard) {
+        shard_add(&shard->faults[fault], 1);
+    }
+}
+
+// Count one permission check
+void op_stats_count_mode_check(bool hit) {
+    op_stats_shard_t *shard = shard_get();
+    if (shard) {
+        shard_add(hit ? &shard->mode_cache_hits : &shard->mode_cache_misses, 1);
+    }
+}
+
+// Total bytes read + written so far
+uint64_t op_stats_bytes_total(void) {
+    uint64_t total = 0;
+    for (op_stats_shard_t *shard = atomic_load_explicit(&shard_list, memory_order_acquire);
+         shard; shard = shard->next) {
+        total += atomic_load_explicit(&shard->bytes_read, memory_order_relaxed);
+        total += atomic_load_explicit(&shard->bytes_written, memory_order_relaxed);
+    }
+    return total;
+}
+
+// Sum all shards into a snapshot
+void op_stats_snapshot(op_stats_snapshot_t *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    for (op_stats_shard_t *shard = atomic_load_explicit(&shard_list, memory_order_acquire);
+         shard; shard = shard->next) {
+        for (int i = 0; i < FS_OP_COUNT; i++) {
+            snapshot->op_counts[i] += atomic_load_explicit(&shard->op_counts[i], memory_order_relaxed);
+        }
+        for (int i = 0; i < FS_FAULT_COUNT; i++) {
+            snapshot->faults[i] += atomic_load_explicit(&shard->faults[i], memory_order_relaxed);
+        }
+        snapshot->bytes_read += atomic_load_explicit(&shard->bytes_read, memory_order_relaxed);
+        snapshot->bytes_written += atomic_load_explicit(&shard->bytes_written, memory_order_relaxed);
+        snapshot->mode_cache_hits += atomic_load_explicit(&shard->mode_cache_hits, memory_order_relaxed);
+        snapshot->mode_cache_misses += atomic_load_explicit(&shard->mode_cache_misses, memory_order_relaxed);
+    }
+    for (int i = 0; i < FS_OP_COUNT; i++) {
+        snapshot->operation_count += snapshot->op_counts[i];
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef OP_STATS_H
+#define OP_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "fs_common.h"
+
+// Operation statistics.
+//
+// Counters live in cache-line-aligned shards, one per FUSE worker thread,
+// so the hot path never writes a line shared with another core. Readers sum
+// all shards. The global operation sequence number is the only shared
+// counter; it drives operation_count_fault and stays exact under load, but
+// only operations that an every-N rule numbers claim one. Operation totals
+// come from the per-type counts, which cover every operation.
+
+// Point-in-time totals summed across all shards
+typedef struct {
+    uint64_t operation_count;            // All operations (sum of op_counts)
+    uint64_t op_counts[FS_OP_COUNT];     // Count per operation type
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t faults[FS_FAULT_COUNT];     // Injected faults per fault type
+    uint64_t mode_cache_hits;            // Permission checks answered from the inode cache
+    uint64_t mode_cache_misses;          // Permission checks that needed fstat()
+} op_stats_snapshot_t;
+
+// Reset all counters
+void op_stats_init(void);
+
+// Claim the next global sequence number (returns the value before increment)
+uint64_t op_stats_next_sequence(void);
+
+// Sequence numbers claimed so far
+uint64_t op_stats_sequence(void);
+
+// Count one operation of the given type
+void op_stats_count_op(fs_op_type_t operation);
+
+// Account bytes transferred by a read or write
+void op_stats_add_bytes(fs_op_type_t operation, size_t bytes);
+
+// Count one injected fault
+void op_stats_count_fault(fs_fault_type_t fault);
+
+// Count one permission check (hit: answered from the cached inode mode)
+void op_stats_count_mode_check(bool hit);
+
+// Total bytes read + written so far
+uint64_t op_stats_bytes_total(void);
+
+// Sum all shards into a snapshot
+void op_stats_snapshot(op_stats_snapshot_t *snapshot);
+
+#endif // OP_STATS_H
@@ -0,0 +1,234 @@
+#include "path_match.h"
+#include <errno.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Deepest path (in components) that can match a pattern
+#define PATH_MATCH_MAX_DEPTH 128
+
+// Glob remainder of a pattern, anchored at a trie node
+typedef struct path_glob {
+    unsigned int index;          // Pattern index (bit in the match result)
+    char **components;           // Remaining components (may contain wildcards, "**")
+    size_t count;
+    struct path_glob *next;
+} path_glob_t;
+
+// One literal component of the pattern prefixes
+typedef struct path_node {
+    char *name;
+    struct path_node *children;  // First child
+    struct path_node *sibling;   // Next child of the same parent
+    path_glob_t *globs;          // Patterns whose literal prefix ends here
+} path_node_t;
+
+struct path_matcher {
+    path_node_t root;
+};
+
+static bool has_wildcard(const char *component) {
+    return strpbrk(component, "*?[") != NULL;
+}
+
+static void free_node(path_node_t *node) {
+    while (node->children) {
+        path_node_t *child = node->children;
+        node->children = child->sibling;
+        free_node(child);
+        free(child->name);
+        free(child);
+    }
+    while (node->globs) {
+        path_glob_t *glob = node->globs;
+        node->globs = glob->next;
+        for (size_t i = 0; i < glob->count; i++) {
+            free(glob->components[i]);
+        }
+        free(glob->components);
+        free(glob);
+    }
+}
+
+path_matcher_t *path_matcher_create(void) {
+    return calloc(1, sizeof(path_matcher_t));
+}
+
+void path_matcher_free(path_matcher_t *matcher) {
+    if (!matcher) {
+        return;
+    }
+    free_node(&matcher->root);
+    free(matcher);
+}
+
+// Child of node named name (NULL if absent)
+static const path_node_t *find_child(const path_node_t *node, const char *name) {
+    for (const path_node_t *child = node->children; child; child = child->sibling) {
+        if (strcmp(child->name, name) == 0) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+// Child of node named name, created if absent (NULL on allocation failure)
+static path_node_t *add_child(path_node_t *node, const char *name) {
+    for (path_node_t *child = node->children; child; child = child->sibling) {
+        if (strcmp(child->name, name) == 0) {
+            return child;
+        }
+    }
+
+    path_node_t *child = calloc(1, sizeof(path_node_t));
+    if (!child || !(child->name = strdup(name))) {
+        free(child);
+        return NULL;
+    }
+    child->sibling = node->children;
+    node->children = child;
+    return child;
+}
+
+// Split a pattern or path into its non-empty components, in place
+static size_t split_components(char *path, char **components, size_t max) {
+    size_t count = 0;
+    char *save = NULL;
+    for (char *c = strtok_r(path, "/", &save); c; c = strtok_r(NULL, "/", &save)) {
+        if (count == max) {
+            return max + 1;  // Too deep
+        }
+        components[count++] = c;
+    }
+    return count;
+}
+
+int path_matcher_add(path_matcher_t *matcher, const char *pattern, unsigned int index) {
+    if (!pattern || !pattern[0] || index >= PATH_MATCH_MAX_PATTERNS) {
+        return -EINVAL;
+    }
+
+    // "*.vhdx" is "/**/*.vhdx"
+    size_t length = strlen(pattern);
+    bool anchored = strchr(pattern, '/') != NULL;
+    char *copy = malloc(length + 5);
+    if (!copy) {
+        return -ENOMEM;
+    }
+    strcpy(copy, anchored ? "" : "/**/");
+    strcat(copy, pattern);
+
+    char *components[PATH_MATCH_MAX_DEPTH];
+    size_t count = split_components(copy, components, PATH_MATCH_MAX_DEPTH);
+    if (count == 0 || count > PATH_MATCH_MAX_DEPTH) {
+        free(copy);
+        return -EINVAL;
+    }
+
+    // Literal prefix into the trie, the rest into a glob on the last node
+    path_node_t *node = &matcher->root;
+    size_t literal = 0;
+    while (literal < count && !has_wildcard(components[literal])) {
+        node = add_child(node, components[literal]);
+        if (!node) {
+            free(copy);
+            return -ENOMEM;
+        }
+        literal++;
+    }
+
+    path_glob_t *glob = calloc(1, sizeof(path_glob_t));
+    size_t rest = count - literal;
+    char **rest_components = rest ? calloc(rest, sizeof(char *)) : NULL;
+    if (!glob || (rest && !rest_components)) {
+        free(glob);
+        free(rest_components);
+        free(copy);
+        return -ENOMEM;
+    }
+    for (size_t i = 0; i < rest; i++) {
+        rest_components[i] = strdup(components[literal + i]);
+        if (!rest_components[i]) {
+            while (i > 0) {
+                free(rest_components[--i]);
+            }
+            free(rest_components);
+            free(glob);
+            free(copy);
+            return -ENOMEM;
+        }
+    }
+    free(copy);
+
+    glob->index = index;
+    glob->components = rest_components;
+    glob->count = rest;
+    glob->next = node->globs;
+    node->globs = glob;
+    return 0;
+}
+
+// Match glob components against path components ("**" = any number)
+static bool glob_match(char *const *pattern, size_t pattern_count,
+                       char *const *path, size_t path_count) {
+    while (pattern_count > 0) {
+        if (strcmp(pattern[0], "**") == 0) {
+            // Collapse repeated "**", then try every split point
+            while (pattern_count > 0 && strcmp(pattern[0], "**") == 0) {
+                pattern++;
+                pattern_count--;
+            }
+            if (pattern_count == 0) {
+                return true;
+            }
+            for (size_t skip = 0; skip <= path_count; skip++) {
+                if (glob_match(pattern, pattern_count, path + skip, path_count - skip)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (path_count == 0 || fnmatch(pattern[0], path[0], 0) != 0) {
+            return false;
+        }
+        pattern++;
+        pattern_count--;
+        path++;
+        path_count--;
+    }
+    return path_count == 0;
+}
+
+uint32_t path_matcher_match(const path_matcher_t *matcher, const char *path) {
+    char copy[PATH_MAX];
+    size_t length = strlen(path);
+    if (length >= sizeof(copy)) {
+        return 0;
+    }
+    memcpy(copy, path, length + 1);
+
+    char *components[PATH_MATCH_MAX_DEPTH];
+    size_t count = split_components(copy, components, PATH_MATCH_MAX_DEPTH);
+    if (count > PATH_MATCH_MAX_DEPTH) {
+        return 0;
+    }
+
+    // Walk the literal prefixes; at each node try the globs anchored there
+    // against the rest of the path
+    uint32_t matched = 0;
+    const path_node_t *node = &matcher->root;
+    for (size_t depth = 0; node; depth++) {
+        for (const path_glob_t *glob = node->globs; glob; glob = glob->next) {
+            if (!(matched & (1u << glob->index)) &&
+                glob_match(glob->components, glob->count, components + depth, count - depth)) {
+                matched |= 1u << glob->index;
+            }
+        }
+        if (depth == count) {
+            break;
+        }
+        node = find_child(node, components[depth]);
+    }
+    return matched;
+}
@@ -0,0 +1,42 @@
+#ifndef PATH_MATCH_H
+#define PATH_MATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Path patterns of fault rules ("path =" key), compiled into a prefix trie.
+//
+// Patterns are mount-relative. One starting with '/' is anchored at the
+// mount root; one without a '/' ("*.vhdx") matches the last component at
+// any depth. Components may use fnmatch() wildcards (*, ?, [...]), and a
+// "**" component matches any number of components, including none, so
+// "/db/**" matches /db and everything below it. Patterns match whole paths:
+// a bare "/db" matches the directory itself, not what is under it.
+//
+// The leading components without wildcards form the trie: matching a path
+// walks it one component at a time and only runs the glob remainder of the
+// patterns hanging off the nodes it passes, so unrelated patterns cost
+// nothing.
+
+// Distinct patterns one matcher holds. This is also the limit of a fault
+// plan: every combination of matching patterns gets a view slot of its own,
+// and a match fits in the 8 scope bits of a cached match (fault_plan.h).
+#define PATH_MATCH_MAX_PATTERNS 8
+
+typedef struct path_matcher path_matcher_t;
+
+// Create an empty matcher (NULL on allocation failure)
+path_matcher_t *path_matcher_create(void);
+
+// Free a matcher
+void path_matcher_free(path_matcher_t *matcher);
+
+// Add a pattern as index `index` (< PATH_MATCH_MAX_PATTERNS). Returns 0 or
+// a negative errno (-EINVAL for an empty pattern or bad index).
+int path_matcher_add(path_matcher_t *matcher, const char *pattern, unsigned int index);
+
+// Bit i set = pattern i matches the mount-relative path
+uint32_t path_matcher_match(const path_matcher_t *matcher, const char *path);
+
+#endif // PATH_MATCH_H
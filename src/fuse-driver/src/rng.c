@@ -0,0 +1,190 @@
+#include "rng.h"
+#include "log.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+
+// Master seed and the state handed to the next thread that asks for a stream
+static uint64_t master_seed = 0;
+static uint64_t next_stream[4];
+static pthread_mutex_t stream_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Bumped by rng_init() so threads re-derive their stream after a re-seed
+static atomic_uint_fast64_t seed_generation = 0;
+
+// Thread-local generator state
+typedef struct {
+    uint64_t s[4];
+    uint64_t side[4];     // s long-jumped (rng_next_side())
+    uint64_t generation;  // 0 = not yet claimed
+} rng_state_t;
+
+static __thread rng_state_t tls_rng;
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// splitmix64 - used only to expand the master seed into xoshiro state
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t xoshiro_next(uint64_t s[4]) {
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+// Advance state by the number of steps encoded in jump
+static void xoshiro_advance(uint64_t s[4], const uint64_t jump[4]) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (size_t i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & (UINT64_C(1) << b)) {
+                s0 ^= s[0];
+                s1 ^= s[1];
+                s2 ^= s[2];
+                s3 ^= s[3];
+            }
+            xoshiro_next(s);
+        }
+    }
+
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+}
+
+// Advance state by 2^128 steps - each jump yields a non-overlapping stream
+static void xoshiro_jump(uint64_t s[4]) {
+    static const uint64_t JUMP[] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    xoshiro_advance(s, JUMP);
+}
+
+// Advance state by 2^192 steps - past every stream the 2^128 jumps hand out
+static void xoshiro_long_jump(uint64_t s[4]) {
+    static const uint64_t LONG_JUMP[] = {
+        0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+        0x77710069854ee241ULL, 0x39109bb02acbe635ULL
+    };
+    xoshiro_advance(s, LONG_JUMP);
+}
+
+// Initialize the RNG subsystem with a master seed
+void rng_init(uint64_t seed) {
+    if (seed == 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        seed = ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec) ^
+               ((uint64_t)getpid() << 32);
+        if (seed == 0) {
+            seed = 1;
+        }
+    }
+
+    pthread_mutex_lock(&stream_mutex);
+    master_seed = seed;
+    uint64_t x = seed;
+    for (int i = 0; i < 4; i++) {
+        next_stream[i] = splitmix64(&x);
+    }
+    pthread_mutex_unlock(&stream_mutex);
+
+    atomic_fetch_add(&seed_generation, 1);
+
+    LOG_INFO("RNG initialized with seed %llu", (unsigned long long)seed);
+}
+
+// Master seed in use
+uint64_t rng_get_seed(void) {
+    return master_seed;
+}
+
+// Claim the next stream for the calling thread (slow path, once per thread)
+static void rng_claim_stream(uint64_t generation) {
+    pthread_mutex_lock(&stream_mutex);
+    for (int i = 0; i < 4; i++) {
+        tls_rng.s[i] = next_stream[i];
+        tls_rng.side[i] = next_stream[i];
+    }
+    xoshiro_jump(next_stream);
+    pthread_mutex_unlock(&stream_mutex);
+
+    xoshiro_long_jump(tls_rng.side);
+
+    tls_rng.generation = generation;
+}
+
+// Make sure the calling thread holds a stream of the current seed
+static inline void rng_check_stream(void) {
+    uint64_t generation = atomic_load_explicit(&seed_generation, memory_order_relaxed);
+    if (__builtin_expect(tls_rng.generation != generation, 0)) {
+        if (generation == 0) {
+            // Used before rng_init() - fall back to a time-derived seed
+            rng_init(0);
+            generation = atomic_load(&seed_generation);
+        }
+        rng_claim_stream(generation);
+    }
+}
+
+// Next raw 64-bit value from the calling thread's stream
+uint64_t rng_next(void) {
+    rng_check_stream();
+    return xoshiro_next(tls_rng.s);
+}
+
+// Next raw value from the calling thread's side stream
+uint64_t rng_next_side(void) {
+    rng_check_stream();
+    return xoshiro_next(tls_rng.side);
+}
+
+// Fill out with n raw values, checking the stream once
+void rng_fill(uint64_t *out, size_t n) {
+    rng_check_stream();
+    uint64_t s[4] = { tls_rng.s[0], tls_rng.s[1], tls_rng.s[2], tls_rng.s[3] };
+    for (size_t i = 0; i < n; i++) {
+        out[i] = xoshiro_next(s);
+    }
+    for (int i = 0; i < 4; i++) {
+        tls_rng.s[i] = s[i];
+    }
+}
+
+// Uniform double in [0, 1)
+double rng_uniform(void) {
+    return (double)(rng_next() >> 11) * 0x1.0p-53;
+}
+
+// Uniform integer in [0, bound) using Lemire's multiply-shift rejection
+uint64_t rng_below(uint64_t bound) {
+    __uint128_t m = (__uint128_t)rng_next() * bound;
+    uint64_t low = (uint64_t)m;
+    if (low < bound) {
+        uint64_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (__uint128_t)rng_next() * bound;
+            low = (uint64_t)m;
+        }
+    }
+    return (uint64_t)(m >> 64);
+}
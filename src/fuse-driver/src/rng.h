@@ -0,0 +1,36 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Per-thread pseudo random number generator (xoshiro256**).
+//
+// Every thread lazily claims its own stream on first use. Streams are
+// derived from a single master seed by repeated xoshiro jumps, so they never
+// overlap and no lock is taken on the hot path.
+
+// Initialize the RNG subsystem with a master seed (0 = derive one from time)
+void rng_init(uint64_t seed);
+
+// Master seed in use (log it to reproduce a run)
+uint64_t rng_get_seed(void);
+
+// Next raw 64-bit value from the calling thread's stream
+uint64_t rng_next(void);
+
+// Fill out with n raw 64-bit values from the calling thread's stream
+void rng_fill(uint64_t *out, size_t n);
+
+// Next value from the calling thread's side stream: its stream moved ahead
+// by 2^192 steps, so a seeded run reproduces it but drawing from it does not
+// shift rng_next() (for draws that must not change the fault decisions)
+uint64_t rng_next_side(void);
+
+// Uniform double in [0, 1)
+double rng_uniform(void);
+
+// Uniform integer in [0, bound) without modulo bias (bound must be > 0)
+uint64_t rng_below(uint64_t bound);
+
+#endif // RNG_H
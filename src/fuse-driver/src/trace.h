@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Static tracepoints (USDT, provider "nas_fuse").
+//
+// When <sys/sdt.h> is available (systemtap-sdt-dev) every TRACE_* site
+// compiles to a single nop plus an ELF note; nothing runs until perf,
+// bpftrace or systemtap attaches to the probe in the running daemon:
+//
+//   bpftrace -l 'usdt:/usr/local/bin/nas-emu-fuse:*'
+//   bpftrace -e 'usdt:/usr/local/bin/nas-emu-fuse:nas_fuse:fault_error
+//                { @[arg0, arg1] = count(); }'
+//
+// Without the header, or when built with -DNAS_NO_SDT, the macros expand to
+// nothing and their arguments are not evaluated. Probe arguments must stay
+// cheap (plain values and pointers already at hand): they are computed on
+// every pass even when no tracer is attached.
+//
+// Probes (op is an fs_op_type_t, see fs_common.h):
+//   op_entry(op, op_name, ino)                request enters the fault gate
+//   op_exit(op, injected_error)               gate done (0 = backend ran)
+//   op_defer(op, delay_ms)                    reply parked on the delay scheduler
+//   stage_entry(op) / stage_exit(op)          backend step, including the reply
+//   fault_error(op, error_code)               error fault fired
+//   fault_delay(op, delay_ms)                 delay fault fired
+//   fault_timing(op) / fault_opcount(op)      timing or operation count trigger
+//   fault_partial(op, size, new_size)         partial fault fired
+//   fault_corruption(op, size, bytes)         corruption fault fired
+//   read_entry(fd, size, offset) / read_exit(fd, result)    backend pread()
+//   write_entry(fd, size, offset) / write_exit(fd, result)  backend pwrite()
+//   event_send(len, sent)                     event datagram (sent: 1 or 0 = dropped)
+
+#if !defined(NAS_NO_SDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define NAS_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef NAS_HAVE_SDT
+#define TRACE0(name)                DTRACE_PROBE(nas_fuse, name)
+#define TRACE1(name, a)             DTRACE_PROBE1(nas_fuse, name, a)
+#define TRACE2(name, a, b)          DTRACE_PROBE2(nas_fuse, name, a, b)
+#define TRACE3(name, a, b, c)       DTRACE_PROBE3(nas_fuse, name, a, b, c)
+#else
+#define TRACE0(name)                do { } while (0)
+#define TRACE1(name, a)             do { } while (0)
+#define TRACE2(name, a, b)          do { } while (0)
+#define TRACE3(name, a, b, c)       do { } while (0)
+#endif
+
+#endif // TRACE_H
@@ -1,8 +1,10 @@
 #!/usr/bin/env python3
 """Event emission tests -- runs INSIDE the target container.
 
-Binds the event socket, performs FUSE operations locally on the mount,
-and validates received events. Exits 0 on success, 1 on failure.
+Binds the event socket (or, when the driver writes to the shared-memory
+ring at NAS_EVENT_SHM_PATH, reads the ring), performs FUSE operations
+locally on the mount, and validates received events. Exits 0 on success,
+1 on failure.
 
 Usage: python3 test_event_emission.py [--config CONFIG_NAME]
   CONFIG_NAME selects which fault config to test against.
@@ -10,17 +12,37 @@ Usage: python3 test_event_emission.py [--config CONFIG_NAME]
 """
 
 import json
+import mmap
 import os
 import socket
+import struct
 import sys
 import threading
 import time
 
 SOCKET_PATH = "/var/run/nas-emu/events.sock"
+SHM_PATH = os.environ.get("NAS_EVENT_SHM_PATH", "/dev/shm/nas-emu-events")
 MOUNT_POINT = os.environ.get("NAS_MOUNT_POINT", "/mnt/nas-mount")
 
 failures = []
 
+# Binary wire format (event_format = binary), see event_emitter.h
+WIRE_VERSION = 2
+WIRE_HEADER = struct.Struct("<BBBBBxHQqQiI")
+WIRE_NO_FAULT = 0xFF
+WIRE_TRUNCATED = 0x01
+WIRE_MORE = 0x02
+KIND_CORRUPTION = 2
+KIND_SUMMARY = 3
+SUMMARY_COUNTS = struct.Struct("<5Q")
+OP_NAMES = [
+    "getattr", "readdir", "create", "mknod", "read", "write", "open", "release",
+    "mkdir", "rmdir", "unlink", "rename", "access", "chmod", "chown", "truncate",
+    "utimens", "copy_file_range", "fallocate",
+    "fsync", "flush", "statfs",
+]
+FAULT_NAMES = ["error", "delay", "partial", "corruption", "timing", "opcount"]
+
 
 def fail(msg):
     failures.append(msg)
@@ -31,9 +53,87 @@ def ok(msg):
     print(f"  OK: {msg}")
 
 
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if b < 0x80:
+            return value, pos
+        shift += 7
+
+
+def decode_event(data):
+    """Decode one datagram (JSON or binary wire format) into an event dict."""
+    if data[:1] == b"{":
+        return json.loads(data.decode())
+
+    (version, kind, op, fault, flags, path_len, ts, off, sz, res,
+     corr_n) = WIRE_HEADER.unpack_from(data)
+    if version != WIRE_VERSION:
+        raise ValueError(f"unknown event schema version {version}")
+    pos = WIRE_HEADER.size
+    if kind == KIND_SUMMARY:
+        counts = SUMMARY_COUNTS.unpack_from(data, pos + path_len)
+        return {
+            "ts": ts,
+            "summary": {
+                "data": {"sampled_out": counts[0], "rate_limited": counts[1]},
+                "metadata": {"sampled_out": counts[2], "rate_limited": counts[3]},
+                "dropped": counts[4],
+            },
+        }
+    evt = {
+        "ts": ts,
+        "op": OP_NAMES[op],
+        "path": data[pos:pos + path_len].decode(errors="replace"),
+        "off": off,
+        "sz": sz,
+        "res": res,
+        "fault": None if fault == WIRE_NO_FAULT else FAULT_NAMES[fault],
+    }
+    pos += path_len
+
+    if kind == KIND_CORRUPTION:
+        chunk, m = struct.unpack_from("<II", data, pos)
+        pos += 8
+        ranges = []
+        end = 0
+        for _ in range(m):
+            gap, pos = read_varint(data, pos)
+            length, pos = read_varint(data, pos)
+            start = end + gap
+            ranges.append([start, length, data[pos:pos + length].hex()])
+            pos += length
+            end = start + length
+        evt["corr"] = {
+            "n": corr_n,
+            "chunk": chunk,
+            "ranges": ranges,
+            "more": bool(flags & WIRE_MORE),
+            "truncated": bool(flags & WIRE_TRUNCATED),
+        }
+    return evt
+
+
+def corruption_writes(events):
+    """Reassemble chunked corruption records: one entry per corrupted write,
+    keyed by (path, off, ts), with the chunks in order."""
+    writes = {}
+    for e in events:
+        if e.get("fault") == "corruption" and "corr" in e:
+            writes.setdefault((e["path"], e["off"], e["ts"]), []).append(e)
+    for chunks in writes.values():
+        chunks.sort(key=lambda e: e["corr"]["chunk"])
+    return writes
+
+
 class EventCollector:
     def __init__(self):
         self.events = []
+        self.summaries = []  # Suppression summaries, kept apart from op events
+        self.undecodable = 0
         self._sock = None
         self._running = False
         self._thread = None
@@ -61,12 +161,11 @@ class EventCollector:
         while self._running:
             try:
                 data = self._sock.recv(8192)
-                evt = json.loads(data.decode())
-                self.events.append(evt)
             except socket.timeout:
                 continue
             except Exception:
                 continue
+            self._deliver(data)
 
     def wait(self, n=1, timeout=3):
         deadline = time.monotonic() + timeout
@@ -86,6 +185,76 @@ class EventCollector:
     def clear(self):
         self.events.clear()
 
+    def _deliver(self, data):
+        try:
+            evt = decode_event(data)
+        except Exception:
+            self.undecodable += 1
+            return
+        (self.summaries if "summary" in evt else self.events).append(evt)
+
+
+# Shared-memory ring (event_shm_path), see event_ring.h
+RING_MAGIC = 0x31425245564E4153
+RING_HEAD = 64
+RING_TAIL = 128
+RING_COMMITTED = 0x80000000
+RING_PAD = 0x40000000
+RING_LEN_MASK = 0x3FFFFFFF
+
+
+class RingCollector(EventCollector):
+    """Reads events from the driver's shared-memory ring instead of the socket."""
+
+    def start(self):
+        with open(SHM_PATH, "r+b") as f:
+            self._map = mmap.mmap(f.fileno(), 0)
+        magic, _version, self._data, self._cap = struct.unpack_from("<QIIQ", self._map, 0)
+        if magic != RING_MAGIC:
+            raise RuntimeError(f"{SHM_PATH} is not an event ring")
+        # Skip whatever was emitted before the tests started (a bound socket
+        # would not have seen it either)
+        while self._next() is not None:
+            pass
+        self._running = True
+        self._thread = threading.Thread(target=self._loop, daemon=True)
+        self._thread.start()
+
+    def stop(self):
+        self._running = False
+        if self._thread:
+            self._thread.join(timeout=2)
+        self._map.close()
+
+    def _next(self):
+        """Consume one record; None when the ring is empty or the oldest
+        record is still being written."""
+        m = self._map
+        while True:
+            head, = struct.unpack_from("<Q", m, RING_HEAD)
+            tail, = struct.unpack_from("<Q", m, RING_TAIL)
+            if tail == head:
+                return None
+            pos = self._data + (tail & (self._cap - 1))
+            word, = struct.unpack_from("<I", m, pos)
+            length = word & RING_LEN_MASK
+            if not word & (RING_COMMITTED | RING_PAD):
+                return None
+            size = length if word & RING_PAD else (length + 7) & ~7
+            data = None if word & RING_PAD else bytes(m[pos + 8:pos + length])
+            m[pos:pos + size] = bytes(size)
+            struct.pack_into("<Q", m, RING_TAIL, tail + size)
+            if data is not None:
+                return data
+
+    def _loop(self):
+        while self._running:
+            data = self._next()
+            if data is None:
+                time.sleep(0.01)
+                continue
+            self._deliver(data)
+
 
 # ---------------------------------------------------------------------------
 # Test cases
@@ -193,7 +362,7 @@ def test_event_size_positive(c):
 
 
 def test_corruption_event_details(c):
-    """Corruption events should have corr field with n, pos, orig, new."""
+    """Corruption events should have corr field with n, chunk, ranges."""
     c.clear()
     for i in range(10):
         p = os.path.join(MOUNT_POINT, f"evt_corr_{i}.bin")
@@ -210,32 +379,104 @@ def test_corruption_event_details(c):
             fail(f"corruption event missing 'corr': {e}")
             return
         d = e["corr"]
-        for field in ("n", "pos", "orig", "new"):
+        for field in ("n", "chunk", "ranges", "more", "truncated"):
             if field not in d:
                 fail(f"corr missing '{field}': {d}")
                 return
         if d["n"] <= 0:
             fail(f"corr n <= 0: {d}")
             return
-        if len(d["pos"]) != d["n"]:
-            fail(f"pos length {len(d['pos'])} != n {d['n']}")
+    for key, chunks in corruption_writes(corr).items():
+        if [e["corr"]["chunk"] for e in chunks] != list(range(len(chunks))):
+            fail(f"missing chunks for {key}")
+            return
+        total = sum(r[1] for e in chunks for r in e["corr"]["ranges"])
+        if total != chunks[0]["corr"]["n"]:
+            fail(f"ranges cover {total} bytes != n {chunks[0]['corr']['n']}")
             return
     ok(f"corruption events have valid details ({len(corr)} events)")
 
 
 def test_corruption_positions_in_range(c):
-    """Corrupted byte positions should be within [0, sz)."""
+    """Corrupted ranges should be within [0, sz) and carry one mask byte each."""
     corr = c.by(fault="corruption")
     if not corr:
         ok("no corruption events to check positions")
         return
     for e in corr:
-        d = e.get("corr", {})
-        for pos in d.get("pos", []):
-            if pos < 0 or pos >= e["sz"]:
-                fail(f"position {pos} out of range [0, {e['sz']})")
+        for start, length, masks in e.get("corr", {}).get("ranges", []):
+            if start < 0 or length <= 0 or start + length > e["sz"]:
+                fail(f"range [{start}, {start + length}) out of range [0, {e['sz']})")
+                return
+            if len(masks) != 2 * length:
+                fail(f"range of {length} bytes has {len(masks) // 2} masks")
                 return
-    ok("all corruption positions in valid range")
+    ok("all corruption ranges in valid range")
+
+
+def test_corruption_ground_truth(c):
+    """A corrupted write is reported completely (chunked, not capped)."""
+    c.clear()
+    # Well past the old 256-byte cap, but few enough chunks that the default
+    # Unix datagram queue (max_dgram_qlen = 10) does not drop any
+    size = 4096
+    data = bytes(i % 251 for i in range(size))
+    p = os.path.join(MOUNT_POINT, "evt_corr_large.bin")
+    fd = os.open(p, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o644)
+    try:
+        os.write(fd, data)
+    finally:
+        os.close(fd)
+    c.wait(1, timeout=3)
+    time.sleep(0.5)  # Let every chunk arrive
+    writes = {k: v for k, v in corruption_writes(c.by(fault="corruption")).items()
+              if k[0].endswith("evt_corr_large.bin")}
+    if not writes:
+        ok("no corruption events (config may not have corruption enabled)")
+        return
+
+    with open(p, "rb") as f:
+        stored = f.read()
+    expected = bytearray(data)
+    corrupted = 0
+    for (_path, off, _ts), chunks in writes.items():
+        if chunks[-1]["corr"]["more"] or chunks[0]["corr"]["truncated"]:
+            fail(f"incomplete corruption report at offset {off}")
+            return
+        for e in chunks:
+            for start, length, masks in e["corr"]["ranges"]:
+                for i, mask in enumerate(bytes.fromhex(masks)):
+                    expected[off + start + i] ^= mask
+                corrupted += length
+    if bytes(expected) != stored:
+        fail("file content does not match the reported corruption")
+        return
+    ok(f"{corrupted} corrupted bytes in {sum(len(v) for v in writes.values())} records "
+       f"reproduce the stored file")
+
+
+def test_event_path_escaped(c):
+    """Paths with quotes and backslashes must survive encoding."""
+    c.clear()
+    name = 'evt_q"uote\\back.txt'
+    p = os.path.join(MOUNT_POINT, name)
+    with open(p, "w") as f:
+        f.write("escape test")
+    c.wait(1)
+    matched = [e for e in c.by(op="write") if e.get("path", "").endswith(name)]
+    if matched:
+        ok(f"path with special characters intact ({matched[0]['path']})")
+    else:
+        paths = [e.get("path") for e in c.events]
+        fail(f"no event with path ending in {name!r}. Seen: {paths}")
+
+
+def test_all_datagrams_decoded(c):
+    """Every datagram should decode (JSON or binary)."""
+    if c.undecodable:
+        fail(f"{c.undecodable} datagrams could not be decoded")
+    else:
+        ok("all datagrams decoded")
 
 
 def test_no_fault_field_when_clean(c):
@@ -253,10 +494,14 @@ def test_no_fault_field_when_clean(c):
 
 def main():
     print("=== Event Emission Tests (inside target container) ===")
-    print(f"Socket: {SOCKET_PATH}")
+    if os.path.exists(SHM_PATH):
+        print(f"Ring:   {SHM_PATH}")
+        collector = RingCollector()
+    else:
+        print(f"Socket: {SOCKET_PATH}")
+        collector = EventCollector()
     print(f"Mount:  {MOUNT_POINT}")
 
-    collector = EventCollector()
     collector.start()
     time.sleep(0.5)  # Let socket bind settle
 
@@ -270,7 +515,10 @@ def main():
             test_event_size_positive,
             test_corruption_event_details,
             test_corruption_positions_in_range,
+            test_corruption_ground_truth,
             test_no_fault_field_when_clean,
+            test_event_path_escaped,
+            test_all_datagrams_decoded,
         ]
         for t in tests:
             print(f"\n--- {t.__doc__.strip()} ---")
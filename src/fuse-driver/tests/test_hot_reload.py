@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+"""Hot reload tests -- runs INSIDE the target container.
+
+Switches the running driver between reload_a.conf (1s delay on every
+write) and reload_b.conf (EIO on every write) with nas-emu-reload and
+checks which rules each write sees: before a reload, after it, and while
+a delayed write or a directory listing is in progress. Finally checks in
+the driver log that every plan replaced by a reload has been freed.
+Exits 0 on success, 1 on failure.
+
+Usage: python3 test_hot_reload.py
+"""
+
+import errno
+import os
+import subprocess
+import sys
+import threading
+import time
+
+MOUNT_POINT = os.environ.get("NAS_MOUNT_POINT", "/mnt/nas-mount")
+STORAGE_PATH = os.environ.get("NAS_STORAGE_PATH", "/var/nas-storage")
+LOG_FILE = os.environ.get("NAS_LOG_FILE", "/var/log/nas-emu.log")
+
+CONFIG_A = "reload_a.conf"  # delay_ms = 1000 on write
+CONFIG_B = "reload_b.conf"  # error_code = -5 on write
+DELAY_S = 1.0
+LISTING_FILES = 600         # Enough for a listing of several readdir chunks
+
+failures = []
+
+
+def fail(msg):
+    failures.append(msg)
+    print(f"  FAIL: {msg}", file=sys.stderr)
+
+
+def ok(msg):
+    print(f"  OK: {msg}")
+
+
+def reload(config):
+    """Switch the driver to config; True once the new rules are active."""
+    result = subprocess.run(
+        ["nas-emu-reload", config], capture_output=True, text=True, timeout=30,
+    )
+    if result.returncode != 0:
+        fail(f"nas-emu-reload {config}: {result.stderr.strip()}")
+        return False
+    return True
+
+
+def timed_write(name, data):
+    """Write data to a new file on the mount; returns (errno or 0, seconds)."""
+    path = os.path.join(MOUNT_POINT, name)
+    fd = os.open(path, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o644)
+    start = time.monotonic()
+    try:
+        os.write(fd, data)
+        err = 0
+    except OSError as exc:
+        err = exc.errno
+    elapsed = time.monotonic() - start
+    os.close(fd)
+    return err, elapsed
+
+
+def stored(name):
+    with open(os.path.join(STORAGE_PATH, name), "rb") as f:
+        return f.read()
+
+
+def log_size():
+    try:
+        return os.path.getsize(LOG_FILE)
+    except OSError:
+        return 0
+
+
+def log_since(offset):
+    with open(LOG_FILE, "rb") as f:
+        f.seek(offset)
+        return f.read().decode(errors="replace")
+
+
+# ---------------------------------------------------------------------------
+# Test cases
+# ---------------------------------------------------------------------------
+
+def test_rules_a_active():
+    """Config A: writes are delayed and succeed"""
+    if not reload(CONFIG_A):
+        return
+    err, elapsed = timed_write("reload_a1.txt", b"config a")
+    if err:
+        fail(f"write failed under config A: {os.strerror(err)}")
+    elif elapsed < DELAY_S * 0.9:
+        fail(f"write under config A took {elapsed:.2f}s, expected the {DELAY_S}s delay")
+    else:
+        ok(f"write delayed {elapsed:.2f}s and succeeded")
+
+
+def test_write_parked_across_reload():
+    """A write delayed under A completes under A after the switch to B"""
+    result = {}
+
+    def writer():
+        result["err"], result["elapsed"] = timed_write("reload_parked.txt", b"parked")
+
+    t = threading.Thread(target=writer)
+    t.start()
+    time.sleep(DELAY_S / 4)  # The write is now parked on the delay scheduler
+    reloaded = reload(CONFIG_B)
+    t.join(timeout=10)
+    if not reloaded:
+        return
+    if t.is_alive():
+        fail("write parked across the reload never completed")
+        return
+    if result["err"]:
+        fail(f"parked write failed: {os.strerror(result['err'])} (B applied to a call admitted under A)")
+    elif stored("reload_parked.txt") != b"parked":
+        fail("parked write did not reach the storage")
+    else:
+        ok(f"parked write completed after the reload ({result['elapsed']:.2f}s) with its data stored")
+
+
+def test_rules_b_active():
+    """Config B: writes fail with EIO and are not delayed"""
+    err, elapsed = timed_write("reload_b1.txt", b"config b")
+    if err != errno.EIO:
+        fail(f"write under config B returned {os.strerror(err) if err else 'success'}, expected EIO")
+    elif elapsed >= DELAY_S / 2:
+        fail(f"write under config B took {elapsed:.2f}s, config A's delay still applied")
+    else:
+        ok(f"write failed with EIO in {elapsed:.2f}s")
+
+
+def test_readdir_across_reloads():
+    """Directory listings stay complete while the rules are reloaded"""
+    d = os.path.join(MOUNT_POINT, "reload_dir")
+    os.makedirs(d, exist_ok=True)
+    for i in range(LISTING_FILES):
+        # create is not targeted by either config
+        open(os.path.join(d, f"entry_with_a_longish_name_{i:04d}"), "w").close()
+
+    done = threading.Event()
+    reloads = []
+
+    def reloader():
+        for config in (CONFIG_A, CONFIG_B) * 3:
+            reloads.append(reload(config))
+        done.set()
+
+    t = threading.Thread(target=reloader)
+    t.start()
+    listings = 0
+    complete = True
+    while complete and not done.is_set():
+        names = os.listdir(d)
+        listings += 1
+        if len(names) != LISTING_FILES:
+            fail(f"listing during reloads returned {len(names)} of {LISTING_FILES} entries")
+            complete = False
+    t.join()
+    if complete and all(reloads):
+        ok(f"{listings} listings of {LISTING_FILES} entries complete across {len(reloads)} reloads")
+
+
+def test_rules_a_again():
+    """Switching back to A restores the delay"""
+    if not reload(CONFIG_A):
+        return
+    err, elapsed = timed_write("reload_a2.txt", b"config a again")
+    if err:
+        fail(f"write failed after switching back to A: {os.strerror(err)}")
+    elif elapsed < DELAY_S * 0.9:
+        fail(f"write after switching back to A took {elapsed:.2f}s, expected the delay")
+    else:
+        ok(f"write delayed {elapsed:.2f}s again")
+
+
+def test_retired_plans_freed(log_offset):
+    """Every plan replaced by a reload is freed"""
+    deadline = time.monotonic() + 5
+    while True:
+        log = log_since(log_offset)
+        loaded = log.count("Reload: fault rules loaded")
+        freed = log.count("Fault plan: freed retired plan")
+        if freed >= loaded or time.monotonic() > deadline:
+            break
+        time.sleep(0.2)
+    if loaded == 0:
+        fail("no reload logged (log level below INFO?)")
+    elif freed < loaded:
+        fail(f"{loaded} reloads but {freed} retired plans freed")
+    else:
+        ok(f"{freed} retired plans freed")
+
+
+# ---------------------------------------------------------------------------
+# Main
+# ---------------------------------------------------------------------------
+
+def main():
+    print("=== Hot Reload Tests (inside target container) ===")
+    print(f"Mount:  {MOUNT_POINT}")
+    print(f"Log:    {LOG_FILE}")
+
+    log_offset = log_size()
+    tests = [
+        test_rules_a_active,
+        test_write_parked_across_reload,
+        test_rules_b_active,
+        test_readdir_across_reloads,
+        test_rules_a_again,
+    ]
+    for t in tests:
+        print(f"\n--- {t.__doc__.strip()} ---")
+        t()
+    print(f"\n--- {test_retired_plans_freed.__doc__.strip()} ---")
+    test_retired_plans_freed(log_offset)
+
+    print(f"\n{'='*50}")
+    if failures:
+        print(f"FAILED: {len(failures)} test(s)")
+        for f in failures:
+            print(f"  - {f}")
+        return 1
+    print(f"ALL {len(tests) + 1} tests passed")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
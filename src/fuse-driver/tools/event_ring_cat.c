@@ -0,0 +1,96 @@
+// Print events from the shared-memory ring (event_shm_path) as they arrive.
+// JSON events are printed as lines, binary events as hex.
+//
+// Usage: event_ring_cat [-s] path
+//   -s  print per-thread written/dropped counters and exit
+
+#include "event_ring.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static void print_stats(const event_ring_header_t *header) {
+    uint32_t slots = header->producer_count;
+    if (slots > EVENT_RING_MAX_PRODUCERS) {
+        slots = EVENT_RING_MAX_PRODUCERS;
+    }
+    printf("capacity %llu, head %llu, tail %llu\n",
+           (unsigned long long)header->capacity,
+           (unsigned long long)header->head, (unsigned long long)header->tail);
+    for (uint32_t i = 0; i < slots; i++) {
+        printf("slot %u tid %llu written %llu dropped %llu\n", i,
+               (unsigned long long)header->producers[i].tid,
+               (unsigned long long)header->producers[i].written,
+               (unsigned long long)header->producers[i].dropped);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int stats = 0;
+    const char *path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) {
+            stats = 1;
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s [-s] path\n", argv[0]);
+        return 2;
+    }
+
+    // The driver may not have created the ring yet
+    event_ring_reader_t reader;
+    int err;
+    while ((err = event_ring_attach(&reader, path)) == -EAGAIN || err == -ENOENT) {
+        usleep(100 * 1000);
+    }
+    if (err < 0) {
+        fprintf(stderr, "Cannot attach to %s: %s\n", path, strerror(-err));
+        return 1;
+    }
+
+    if (stats) {
+        print_stats(reader.header);
+        event_ring_detach(&reader);
+        return 0;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    while (!stop) {
+        const unsigned char *data;
+        size_t len = event_ring_peek(&reader, &data);
+        if (len == 0) {
+            event_ring_wait(&reader, 200);
+            continue;
+        }
+        if (data[0] == '{') {
+            printf("%.*s\n", (int)len, (const char *)data);
+        } else {
+            for (size_t i = 0; i < len; i++) {
+                printf("%02x", data[i]);
+            }
+            printf("\n");
+        }
+        event_ring_release(&reader);
+    }
+
+    event_ring_detach(&reader);
+    return 0;
+}
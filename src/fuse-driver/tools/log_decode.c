@@ -0,0 +1,142 @@
+// Decode a binary driver log (log_binary = true) into the text log format.
+//
+// Usage: log_decode [file]   (reads stdin when no file is given)
+
+#include "log.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SITES 8192
+
+typedef struct {
+    log_level_t level;
+    char *format;
+} site_t;
+
+static site_t sites[MAX_SITES];
+
+static void reset_sites(void) {
+    for (size_t i = 0; i < MAX_SITES; i++) {
+        free(sites[i].format);
+        sites[i].format = NULL;
+    }
+}
+
+static int read_exact(FILE *in, void *buf, size_t len) {
+    return fread(buf, 1, len, in) == len ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    FILE *in = stdin;
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "-h") == 0)) {
+        fprintf(stderr, "Usage: %s [file]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2 && (in = fopen(argv[1], "rb")) == NULL) {
+        fprintf(stderr, "Cannot open %s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    const size_t magic_len = strlen(LOG_BINARY_MAGIC);
+    char magic[16];
+    if (read_exact(in, magic, magic_len) != 0 || memcmp(magic, LOG_BINARY_MAGIC, magic_len) != 0) {
+        fprintf(stderr, "Not a binary driver log\n");
+        return 1;
+    }
+    printf("--- Log initialized ---\n");
+
+    unsigned char *args = NULL;
+    size_t args_cap = 0;
+    char line[8192];
+    uint64_t last_timestamp = 0;
+    int rc = 0;
+    int kind;
+
+    while ((kind = fgetc(in)) != EOF) {
+        if (kind == 'S') {
+            uint32_t id;
+            uint8_t level;
+            uint16_t format_len;
+            if (read_exact(in, &id, 4) || read_exact(in, &level, 1) || read_exact(in, &format_len, 2)) {
+                goto truncated;
+            }
+            char *format = malloc((size_t)format_len + 1);
+            if (!format || read_exact(in, format, format_len)) {
+                free(format);
+                goto truncated;
+            }
+            format[format_len] = '\0';
+            if (id >= MAX_SITES) {
+                free(format);
+                continue;
+            }
+            free(sites[id].format);
+            sites[id].format = format;
+            sites[id].level = (log_level_t)level;
+        } else if (kind == 'R') {
+            uint32_t id, args_len;
+            uint64_t timestamp;
+            if (read_exact(in, &id, 4) || read_exact(in, &timestamp, 8) || read_exact(in, &args_len, 4)) {
+                goto truncated;
+            }
+            if (args_len > args_cap) {
+                unsigned char *grown = realloc(args, args_len);
+                if (!grown) {
+                    fprintf(stderr, "Out of memory\n");
+                    rc = 1;
+                    break;
+                }
+                args = grown;
+                args_cap = args_len;
+            }
+            if (read_exact(in, args, args_len)) {
+                goto truncated;
+            }
+            last_timestamp = timestamp;
+            if (id >= MAX_SITES || !sites[id].format) {
+                fprintf(stderr, "Record for unknown site %u skipped\n", id);
+                continue;
+            }
+            size_t n = log_format_line(sites[id].level, sites[id].format, timestamp,
+                                       args, args_len, line, sizeof(line));
+            fwrite(line, 1, n, stdout);
+        } else if (kind == 'D') {
+            uint64_t dropped;
+            if (read_exact(in, &dropped, 8)) {
+                goto truncated;
+            }
+            size_t n = log_format_line(LOG_WARN, "Logger: %llu messages dropped (ring buffer full)",
+                                       last_timestamp, (const unsigned char *)&dropped, 8,
+                                       line, sizeof(line));
+            fwrite(line, 1, n, stdout);
+        } else if (kind == LOG_BINARY_MAGIC[0]) {
+            // Next session appended to the same file; site ids start over
+            if (read_exact(in, magic, magic_len - 1) ||
+                memcmp(magic, LOG_BINARY_MAGIC + 1, magic_len - 1) != 0) {
+                goto corrupt;
+            }
+            reset_sites();
+            printf("--- Log initialized ---\n");
+        } else {
+            goto corrupt;
+        }
+        continue;
+
+truncated:
+        fprintf(stderr, "Truncated log entry\n");
+        rc = 1;
+        break;
+corrupt:
+        fprintf(stderr, "Unknown log entry type 0x%02x at offset %ld\n", kind, ftell(in) - 1);
+        rc = 1;
+        break;
+    }
+
+    reset_sites();
+    free(args);
+    if (in != stdin) {
+        fclose(in);
+    }
+    return rc;
+}
@@ -0,0 +1,90 @@
+"""Path-scoped fault tests -- path_scoped.conf.
+
+Two corruption rules (100% probability, 70% of the bytes) are scoped with
+`path =`: one to /db/** (the /db directory and everything below it), one
+to *.vhdx (the last component, at any depth). Files in either scope must
+be corrupted on the backing storage, files outside both must be stored
+intact, including near misses such as /dbx and *.vhd.
+"""
+
+import os
+import time
+
+
+# Written through the mount, checked on the raw storage
+IN_SCOPE = ["db/data.bin", "db/sub/deep.bin", "disk.vhdx", "vm/disk.vhdx"]
+OUT_OF_SCOPE = ["other.bin", "dbx/data.bin", "vm/disk.vhd", "disk.vhdx.bak"]
+
+# Chunks written per handle in the interleaved handle test
+NUM_CHUNKS = 5
+
+
+def _test_data() -> bytes:
+    """200-byte deterministic test payload."""
+    return bytes(ord("A") + i % 26 for i in range(200))
+
+
+def _write_and_read_back(smb_path: str, raw_storage: str, name: str, data: bytes) -> bytes:
+    smb_file = os.path.join(smb_path, name)
+    os.makedirs(os.path.dirname(smb_file), exist_ok=True)
+    with open(smb_file, "wb") as f:
+        f.write(data)
+    time.sleep(0.1)
+    with open(os.path.join(raw_storage, name), "rb") as f:
+        return f.read()
+
+
+class TestPathScoped:
+    """path_scoped.conf -- corruption on writes below /db and to *.vhdx."""
+
+    def test_in_scope_files_corrupted(self, smb_path, raw_storage):
+        data = _test_data()
+        intact = [
+            name for name in IN_SCOPE
+            if _write_and_read_back(smb_path, raw_storage, name, data) == data
+        ]
+        assert not intact, f"Files in a rule's scope stored intact: {intact}"
+
+    def test_files_outside_both_scopes_intact(self, smb_path, raw_storage):
+        data = _test_data()
+        corrupted = [
+            name for name in OUT_OF_SCOPE
+            if _write_and_read_back(smb_path, raw_storage, name, data) != data
+        ]
+        assert not corrupted, f"Files outside every scope corrupted: {corrupted}"
+
+    def test_handles_keep_their_own_match(self, smb_path, raw_storage):
+        """Alternate writes on an in-scope and an out-of-scope handle.
+
+        Each open file caches its rule match in its handle; interleaving the
+        two catches a match leaking from one handle to the other.
+        """
+        data = _test_data()
+        names = {"db/handle.bin": True, "handle.bin": False}
+        os.makedirs(os.path.join(smb_path, "db"), exist_ok=True)
+        files = {name: open(os.path.join(smb_path, name), "wb") for name in names}
+        try:
+            for _ in range(NUM_CHUNKS):
+                for f in files.values():
+                    f.write(data)
+                    f.flush()
+                    os.fsync(f.fileno())  # One write request per chunk
+        finally:
+            for f in files.values():
+                f.close()
+        time.sleep(0.1)
+
+        for name, in_scope in names.items():
+            with open(os.path.join(raw_storage, name), "rb") as f:
+                stored = f.read()
+            assert len(stored) == NUM_CHUNKS * len(data), (
+                f"{name}: stored {len(stored)} bytes, expected {NUM_CHUNKS * len(data)}"
+            )
+            chunks = [
+                stored[i * len(data):(i + 1) * len(data)] != data
+                for i in range(NUM_CHUNKS)
+            ]
+            if in_scope:
+                assert all(chunks), f"{name}: chunks stored intact: {chunks}"
+            else:
+                assert not any(chunks), f"{name}: chunks corrupted: {chunks}"
@@ -49,8 +49,9 @@ class TestTiming1minWrite:
         assert early_ok > 0, "Writes failed before timing threshold"
 
         # Phase 2: wait well past 1-minute threshold from FUSE start.
-        # FUSE driver starts when container launches (~5-10s before tests).
-        # Use 65s to ensure we're past the 1-minute mark from driver init.
+        # The clock starts when the driver starts, or when it reloads this
+        # config into a reused target (~5-10s before tests). Use 65s to
+        # ensure we're past the 1-minute mark from driver init or reload.
         time.sleep(65)
 
         # Phase 3: operations should now fail